@@ -18,10 +18,24 @@ extern "C"
 {
 #endif
 
+#if __CWCC__
 #define bsp_declare_state()         register int __msr_state
 #define bsp_enable_interrupts()     asm { wrtee  __msr_state; }
 #define bsp_disable_interrupts()    asm { mfmsr  __msr_state; \
                                           wrteei 0; }
+#elif defined(BSP_HOST)
+/* linux host build, interrupts are simulated by src/host/bsp_host.c */
+#define bsp_declare_state()         int __msr_state
+#define bsp_enable_interrupts()     bsp_host_irq_restore( __msr_state )
+#define bsp_disable_interrupts()    ( __msr_state = bsp_host_irq_save() )
+int  bsp_host_irq_save( void );
+void bsp_host_irq_restore( int state );
+#else
+/* host build of the control code - nothing to mask */
+#define bsp_declare_state()         int __msr_state = 0
+#define bsp_enable_interrupts()     ((void)__msr_state)
+#define bsp_disable_interrupts()    ((void)__msr_state)
+#endif
 
 /**
  * @brief system time in milliseconds since power on.
@@ -50,6 +64,26 @@ void
 void
   bsp_decr_init( void );
 
+/**
+ * @brief core clocks per systime tick, 1ms at 80MHz
+ */
+#define BSP_DECR_PERIOD   ( 80000ul )
+
+/**
+ * @public
+ * @brief load the decrementer, next tick in 'ticks' core clocks
+ * @note the periodic reload value is left alone
+ */
+void
+  bsp_decr_set( uint32_t ticks );
+
+/**
+ * @public
+ * @brief drop a pending decrementer interrupt
+ */
+void
+  bsp_decr_ack( void );
+
 /**
  * @public
  * @brief atomic fetch of entire timebase
@@ -68,6 +102,60 @@ uint64_t
 uint32_t
   bsp_get_timebase_lower( void );
 
+/**
+ * @brief unused stack fill, see bsp_stack_used()
+ */
+#define BSP_STACK_PAINT   ( 0xa5a5a5a5ul )
+
+/**
+ * @public
+ * @brief fill the unused stack with BSP_STACK_PAINT
+ * @note called once from __start, before the c runtime is up
+ */
+void
+  bsp_stack_paint( void );
+
+/**
+ * @public
+ * @brief stack size in bytes, everything in ram above .bss
+ */
+uint32_t
+  bsp_stack_size( void );
+
+/**
+ * @public
+ * @brief deepest stack use since reset, interrupts included
+ * @retval uint32_t high water mark in bytes
+ */
+uint32_t
+  bsp_stack_used( void );
+
+/**
+ * @public
+ * @brief ram used by statics (.sdata/.sbss/.data/.bss) plus the ram
+ *        vector table and ramfuncs
+ * @retval uint32_t bytes
+ */
+uint32_t
+  bsp_static_ram( void );
+
+/**
+ * @public
+ * @brief *p += v, safe against any interrupt without masking them
+ * @retval uint32_t the new value
+ */
+uint32_t
+  bsp_atomic_add( volatile uint32_t *p, uint32_t v );
+
+/**
+ * @public
+ * @brief if *p == old then *p = new_, safe against any interrupt without
+ *        masking them
+ * @retval int !0 if the swap was made
+ */
+int
+  bsp_atomic_cas( volatile uint32_t *p, uint32_t old, uint32_t new_ );
+
 /**
  * @brief default ivor handler, override as desired
  */
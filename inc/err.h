@@ -12,6 +12,8 @@
 #ifndef   __err_h
 #define   __err_h
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -31,11 +33,13 @@ extern "C"
 #define xxxxx_MODULE            (  2 )
 #define yyyyy_MODULE            (  3 )
 #define TUNER_MODULE            (  4 )
+#define ANGLE_MODULE            (  5 )
 
 #define GLOBAL_CODE( code_ )        ( _CODE( ALL_MODULES, code_ ) )
 #define xxxxx_CODE( code_ )         ( _CODE( xxxxx_MODULE, code_ ) )
 #define yyyyy_CODE( code_ )         ( _CODE( yyyyy_MODULE, code_ ) )
 #define TUNER_CODE( code_ )         ( _CODE( TUNER_MODULE, code_ ) )
+#define ANGLE_CODE( code_ )         ( _CODE( ANGLE_MODULE, code_ ) )
 
 #define MODULE( code_ )             ( (code_&0x0000ff00) >> 8 )
 
@@ -115,12 +119,44 @@ enum
   CODE_yyyyy_INFO             = INFO(yyyyy_CODE( 0x02 )),
 
   CODE_TUNER_                 = INFO(TUNER_CODE( 0x00 )),
+  CODE_TUNER_BAD_TABLE        = RECOVERABLE(TUNER_CODE( 0x01 )),   /**< burn refused, a table has a bad size */
+
+  CODE_ANGLE_EVENTS_FULL      = RECOVERABLE(ANGLE_CODE( 0x01 )),   /**< angle event not added, queue full or bad cylinder */
+  CODE_ANGLE_CLOCK_INIT       = FATAL(ANGLE_CODE( 0x02 )),         /**< angle clock eTPU channel failed to start */
+  CODE_MAP_WINDOW_INIT        = FATAL(ANGLE_CODE( 0x03 )),         /**< MAP window eTPU channel failed to start */
+  CODE_KNOCK_WINDOW_INIT      = FATAL(ANGLE_CODE( 0x04 )),         /**< knock window eTPU channel failed to start */
+  CODE_ANGLE_TOO_MANY_CYL     = RECOVERABLE(ANGLE_CODE( 0x05 )),   /**< N_Cyl over ANGLE_MAX_CYL, the angle windows leave the rest out */
 
 };
 
-#define ERR_DEPTH     32                     /**< depth of code FIFO stack */
+#define ERR_DEPTH     32                     /**< depth of code ring, 2^n  */
+#define ERR_CODES     64                     /**< distinct codes counted   */
 typedef struct err_t err_t;                                  /**< fwd decl */
 
+/**
+ * @public
+ * @brief occurrences of one code since reset
+ * @note times are systime, ms
+ */
+struct err_count
+{
+  uint32_t code;              /**< CODE_NONE for an unused slot            */
+  uint32_t count;
+  uint32_t first;
+  uint32_t last;
+};
+
+/**
+ * @public
+ * @brief every code pushed since reset, read only, tuner page 0xf6
+ */
+struct err_counts
+{
+  uint32_t dropped;           /**< not queued, the ring was full           */
+  uint32_t untracked;         /**< not counted, codes[] was full           */
+  struct err_count codes[ERR_CODES];    /**< hashed on code, unsorted      */
+};
+
 /**
  * @public
  * @brief init code logger
@@ -135,7 +171,8 @@ void
  * @brief push an error code into the stack
  * @param[in] code error code
  * @retval none
- * @note { threadsafe }
+ * @note { threadsafe, lock free, callable from interrupts }
+ * @note a code that is already queued and not yet pop'd is only counted
  */
 void
   err_push( uint32_t code );
@@ -145,7 +182,7 @@ void
  * @brief pop oldest error from the stack
  * @param none
  * @retval err_t* err or 0 if none
- * @note { threadsafe }
+ * @note { single consumer, err_destroy() it before the next pop }
  */
 err_t const *
   err_pop( void );
@@ -173,11 +210,20 @@ uint32_t
  * @brief return err_t back to the free pool
  * @param[in] e previously pop'd err
  * @retval none
- * @note { threadsafe }
+ * @note { single consumer, same context as err_pop() }
  */
 void
   err_destroy( err_t const *e );
 
+/**
+ * @public
+ * @brief per code counters and first/last times
+ * @retval struct err_counts const* live table, entries may change while
+ *         it is being read
+ */
+struct err_counts const *
+  err_counts_get( void );
+
 #ifdef __cplusplus
 }
 #endif
@@ -119,6 +119,10 @@ extern "C" {
 #pragma ANSI_strict off
 #endif  /* 
  */
+
+#ifdef BSP_HOST
+#pragma scalar_storage_order big-endian /* .B fields land where .R puts them */
+#endif
     
 /****************************************************************************/
 /*                     MODULE : FMPLL                                       */
@@ -4078,6 +4082,10 @@ extern "C" {
      
 #define TSENS    (*( volatile struct TSENS_tag *)      0xFFFEC000)
      
+#ifdef BSP_HOST
+#pragma scalar_storage_order default
+#endif
+
 #ifdef __MWERKS__
 #pragma pop
 #endif  /* 
@@ -17,12 +17,16 @@ extern "C"
 {
 #endif
 
-#ifndef NDEBUG
+#if !defined(NDEBUG) && __CWCC__
   #define trap(x) \
     do { if (!(x)) { asm { trap } } } while(0)
+#elif !defined(NDEBUG)
+  #include <assert.h>       /**< host build */
+  #define trap(x) \
+    assert(x)
 #else
   #define trap(x) \
-    do { (void)sizeof(x); } while(0)
+    ((void)0)               /**< not evaluated, x may be a bit-field */
 #endif
 
 #ifdef __cplusplus
@@ -0,0 +1,40 @@
+#ifndef AD_Filter_h
+#define AD_Filter_h
+
+/* Filter bank for the Q0 A/D channels.  Runs once per complete scan, from
+   ADC_Scan_Done(), so a filter's time constant means the same thing however
+   often the sensors are read.  The coefficients for the measured scan rate
+   are worked out by AD_Filter_Update() in task context, the scans pass
+   through until it has run.  Each channel has its own filter type and time
+   in seconds from the calibration (AD_Filter_Type_Array, AD_Filter_Time_Array):
+
+   default     - the channel's built in filter, time not used.  The same
+                 smoothing the sensors had when each read took 1/8 of the new
+                 value: an EMA of 0.07 s on V_Batt, TPS, MAP 2, MAF 1 and P1
+                 (read every 10 msec) and 0.72 s on CLT and IAT (every 103
+                 msec), none on the rest
+   none        - raw value
+   EMA         - first order lag, time = time constant
+   average     - moving average over time, at most AD_FILTER_WINDOW scans
+   median      - median over time, odd length, at most AD_FILTER_WINDOW - 1 scans
+   rate limit  - time = seconds to slew the full A/D range
+
+   Longer average and median times are cut to those lengths.  An unknown type
+   (blank flash is 0xff) is treated as default, so are zeroed constants. */
+
+#define AD_FILTER_WINDOW 8              // scans of history kept, power of 2
+
+enum {
+    AD_FILTER_DEFAULT,
+    AD_FILTER_NONE,
+    AD_FILTER_EMA,
+    AD_FILTER_AVERAGE,
+    AD_FILTER_MEDIAN,
+    AD_FILTER_RATE,
+    AD_FILTER_TYPES
+};
+
+void AD_Filter_Scan(const uint16_t *raw, uint16_t *out, uint32_t time);
+void AD_Filter_Update(void);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef Angle_Clock_h
+#define Angle_Clock_h
+
+/* Interrupt driven crank angle clock.  An eTPU knock window channel opens
+   ANGLE_CLOCK_WINDOWS windows per engine cycle and interrupts the CPU at each
+   opening.  The windows open at the angle event angles (Angle_Events_Windows()),
+   spare ones fill the longest gaps.  The interrupt turns the TCR2 movement since the
+   last one into whole degrees, adds them to Degree_Clock and the OS angle
+   clock (clock 1) and runs the angle events that have come up.
+
+   Nothing happens without crank sync, so loss of sync is left to a task:
+   it calls Angle_Clock_Restart() when the engine position status changes and
+   Angle_Clock_Update() every pass to follow the event angles.
+
+   So the clock only moves at the windows, ANGLE_CLOCK_STEP degrees apart on
+   average.  Degree_Clock jumps by the gap each time, and a task waiting on
+   clock 1 runs at the first window at or past its angle, up to a gap late.
+   Use task_wait_degrees(), which rounds a wait up to whole steps - anything
+   that needs a finer angle should be an angle event, those get a window of
+   their own (see Angle_Events.h). */
+
+#define ANGLE_CLOCK_WINDOWS 8           // interrupts per 720 degrees, 8 is the most the knock window function does
+#define ANGLE_CLOCK_STEP (720 / ANGLE_CLOCK_WINDOWS)  // degrees between interrupts, on average
+
+// wait at least d crank degrees, in whole ANGLE_CLOCK_STEPs
+#define task_wait_degrees(d) task_wait_id(1, (((d) + ANGLE_CLOCK_STEP - 1) / ANGLE_CLOCK_STEP) * ANGLE_CLOCK_STEP)
+
+void Angle_Clock_Init(void);
+void Angle_Clock_Restart(void);
+void Angle_Clock_Update(void);
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef Angle_Events_h
+#define Angle_Events_h
+
+/* Crank angle event queue - run a callback at a fixed angle before a cylinder's TDC, once per
+   engine cycle.  Register everything before os_start(), the list is rebuilt from the
+   calibration (cylinder offsets, engine position, wheel) whenever Page_Generation changes.
+
+   Example - recompute fuel for each cylinder 90 degrees before its TDC:
+
+       for (i = 0; i < N_Cyl; ++i)
+           if (Angle_Event_Add(i, 9000, Fuel_Cyl_Update) != 0)
+               break;          // full, or past ANGLE_MAX_CYL
+
+   Callbacks run from the angle clock interrupt (Angle_Clock.c), whose windows open at the
+   event angles, so keep them short.  Only with more than ANGLE_CLOCK_WINDOWS distinct
+   angles do some events wait for the next window. */
+
+#define MAX_ANGLE_EVENTS 24
+#define ANGLE_MAX_CYL 8      /* cylinder offsets in the calibration, also the windows one knock
+                                window channel does - the MAP and knock windows and the angle
+                                events leave out any cylinders past this */
+
+typedef void (*angle_event_fn)(uint8_t cyl);
+
+int8_t Angle_Event_Add(uint8_t cyl, int32_t btdc_x100, angle_event_fn fn);
+void Angle_Events_Dispatch(uint32_t tcr2);
+void Angle_Events_Reset(void);
+uint8_t Angle_Events_Windows(uint32_t * const open_x100, const uint8_t n);
+int32_t Angle_Cyl_TDC(uint8_t cyl);
+
+#endif
@@ -7,6 +7,7 @@ extern uint32_t etpu_Pulse_Width;
 void Slow_Vars_Task(void);
 void Fuel_Pump_Task(void);
 void Engine10_Task(void);
+void Cyl_Events_Init(void);
 
 
 
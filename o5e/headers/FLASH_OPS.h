@@ -19,8 +19,14 @@ extern "C"
 
 /* missing guard, so I added it until I can figure out what's going on here */
 
-#define BLK1B_BASE 0x00008000
-#define BLK2A_BASE 0x00010000
+#ifdef BSP_HOST
+#define FLASH_BASE 0x20000000   /**< linux host build, src/host maps the flash array here, 0 can't be */
+#else
+#define FLASH_BASE 0x00000000
+#endif
+
+#define BLK1B_BASE (FLASH_BASE + 0x00008000)
+#define BLK2A_BASE (FLASH_BASE + 0x00010000)
 
 /*This function Initializes, Erases and Programs the MPC5xxx FLASH Memory */
 
@@ -0,0 +1,24 @@
+#ifndef Knock_h
+#define Knock_h
+
+/* Knock detection.  An eTPU knock window channel (KNOCK_WINDOW_CHANNEL) opens one
+   window per cylinder, Knock_Window_Open degrees after that cylinder's TDC and
+   Knock_Window_Width degrees long.  The window gates CFIFO3, which converts the
+   knock sensor back to back while it is open, and the RFIFO3 DMA drops the
+   samples in one half of ADC_Q3_Buf.  The window closing interrupts, the DMA is
+   moved to the other half, and the interrupt takes the energy in the
+   Knock_Freq band (one Goertzel bin, fixed point) from the finished half.
+
+   Each cylinder keeps a running average of its own band energy, and
+   Knock_Intensity[cyl] is the latest window over that average, x100.  So 100 is
+   a normal cycle and knock shows as a jump well above it, whatever the sensor
+   gain or the cylinder's distance from the sensor.
+
+   The windows need the engine position, nothing is sampled without full sync. */
+
+#define KNOCK_INTENSITY_SCALE 100       // Knock_Intensity for a window at the running average
+
+void Knock_Init(void);
+void Knock_Update(void);
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef MAP_Sample_h
+#define MAP_Sample_h
+
+/* Angle based MAP.  An eTPU knock window channel (MAP_WINDOW_CHANNEL) opens one
+   window per cylinder, MAP_Angle_Table(RPM) degrees after that cylinder's TDC, so
+   the calibration puts each window in its cylinder's intake stroke.  The window
+   opening triggers CFIFO5, which converts MAP ADC_Q5_SIZE times back to back, and
+   the RFIFO5 DMA interrupts once the burst is in.  MAP_Burst_Done() averages it,
+   files it against the cylinder whose window it was, and the next Engine10 pass
+   reads the newest one.
+
+   The windows need the engine position, nothing is sampled without full sync. */
+
+#define MAP_WINDOW_WIDTH 1000           // deg*100, only the opening edge triggers the A/D
+
+// one averaged burst
+struct map_sample {
+    uint16_t count;                     // A/D counts
+    uint8_t cyl;                        // cylinder whose intake stroke it is
+    uint32_t seq;                       // bursts averaged since reset
+    uint32_t time;                      // systime when the burst completed
+};
+
+extern volatile uint16_t MAP_Cyl_Count[8];  // newest average per cylinder, A/D counts
+
+void MAP_Sample_Init(void);
+void MAP_Sample_Update(void);
+void MAP_Burst_Done(uint8_t buf);
+uint8_t MAP_Sample_Read(struct map_sample *sample);
+
+#endif
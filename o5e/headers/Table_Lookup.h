@@ -5,6 +5,7 @@
 /* size of biggest table we will use - max 255 */
 #define MAX_ROWS 32
 #define MAX_COLS 32
+#define MAX_AXIS 32		/* bigger of the two */
 
 /* Structure of the data table with header information */
 									
@@ -19,8 +20,168 @@ struct table
 	float data[MAX_ROWS * MAX_COLS];  /* rows*cols array of floats, X order, rows first */
 };
 
+/* Per axis part of a hint */
+
+struct axis_hint
+{
+	uint8_t index;			/* cell used last time */
+	float min;				/* first axis value */
+	float inv_step;			/* 1/cell width if the axis is evenly spaced, 0 if not */
+	uint8_t widths;			/* inv_width[] has been filled in */
+	float inv_width[MAX_AXIS - 1];	/* 1/(axis[i+1] - axis[i]) for each cell */
+};
+
+/* Where the last lookup landed plus what was learned about the table's axes - keep one per
+   call site (static) and zero it to start.  Any value is safe, a stale cell only costs a binary
+   search and the axis info is redone whenever the table or Page_Generation changes */
+
+struct table_hint
+{
+	struct axis_hint col;
+	struct axis_hint row;
+	const struct table *table;	/* table the axis info is for */
+	uint32_t generation;		/* Page_Generation when it was worked out */
+	uint8_t valid;				/* the table's size is in range, lookups return 255 if not */
+};
+
+/* A located cell - the upper left index and how far across the cell (0-1) the value is on each axis.
+   A ratio of 0 means no interpolation on that axis */
+
+struct table_pos
+{
+	uint8_t col_index;
+	uint8_t row_index;
+	float col_ratio;
+	float row_ratio;
+};
+
+/* Fixed point copy of a float table for the integer only (eTPU) paths.  Axes and data are scaled
+   and rounded to int32 whenever the float table changes and 1/cell width is kept as 2^32/width,
+   so a lookup is integer compares, multiplies and shifts only.  Declare one per table (static) with
+   TABLE_Q(), ie. data scale 100 gives results in deg*100 straight from a table in degrees */
+
+struct table_q
+{
+	float col_scale;		/* caller's x units per table x unit */
+	float row_scale;		/* caller's y units per table y unit */
+	float data_scale;		/* result units per table unit */
+	int32_t *data;			/* room for max_cells scaled values */
+	uint16_t max_cells;
+	const struct table *table;	/* float table this was built from */
+	uint32_t generation;		/* Page_Generation when it was built */
+	uint8_t valid;			/* 0 if the table didn't fit, lookups then fall back to float */
+	uint8_t cols;
+	uint8_t rows;
+	uint8_t col_index;		/* cell used last time */
+	uint8_t row_index;
+	int32_t col_axis[MAX_COLS];
+	int32_t row_axis[MAX_ROWS];
+	uint32_t col_inv[MAX_COLS - 1];	/* 2^32 / cell width, 0 means don't interpolate */
+	uint32_t row_inv[MAX_ROWS - 1];
+};
+
+#define TABLE_Q(data_, col_scale_, row_scale_, data_scale_) \
+	{ (col_scale_), (row_scale_), (data_scale_), (data_), sizeof(data_) / sizeof((data_)[0]) }
+
+/* One table of a table_lookup_group() - the table, its own hint for when it has to be looked up
+   alone, and its result.  Give it a fixed point copy (static, from TABLE_Q()) for a result in
+   q_result, leave q 0 for a float result */
+
+struct table_group_member
+{
+	const struct table *table;
+	struct table_q *q;			/* fixed point copy, or 0 */
+	struct table_hint hint;		/* used when the tables don't share axes */
+	float result;				/* float result, q == 0 */
+	int32_t q_result;			/* fixed point result times q->data_scale, q != 0 */
+};
+
+/* Tables looked up at the same x,y - keep it static and zero it to start.  Point member at n
+   members, then set x,y (and the tables, pages move on a burn) before each lookup */
+
+struct table_group
+{
+	float col_value;			/* x */
+	float row_value;			/* y (optional) */
+	struct table_group_member *member;
+	uint8_t n;
+	uint8_t same_axes;			/* all tables have the same axes */
+	const struct table *table;	/* first table when same_axes was worked out */
+	uint32_t generation;		/* Page_Generation when same_axes was worked out */
+	struct table_hint hint;		/* cell found last time, on the first table's axes */
+};
+
+/* Count indexed copy of a 1D sensor table.  The table is resampled at evenly spaced A/D counts
+   whenever the table or Page_Generation changes, so a conversion is a shift, an index and one
+   multiply-add - no volts, no search.  Declare one per sensor (static) with TABLE_LUT(), giving
+   the table's x units (volts) per count.  256 segments of 64 counts, 2K of ram per copy.
+   A segment with a table point inside it isn't a straight line, those few go to table_lookup() */
+
+#define TABLE_LUT_COUNTS 16384		/* 14 bit A/D results */
+#define TABLE_LUT_SHIFT 6			/* counts per segment = 1 << TABLE_LUT_SHIFT */
+#define TABLE_LUT_SEGMENTS (TABLE_LUT_COUNTS >> TABLE_LUT_SHIFT)
+
+struct table_lut_seg
+{
+	float base;				/* table value at the first count of the segment */
+	float slope;			/* change per count */
+};
+
+struct table_lut
+{
+	float x_per_count;		/* table x units per A/D count */
+	const struct table *table;	/* float table this was built from */
+	uint32_t generation;		/* Page_Generation when it was built */
+	uint8_t valid;			/* 0 if the table isn't a usable 1D table, lookups then fall back to float */
+	uint32_t knee[TABLE_LUT_SEGMENTS / 32];	/* bit per segment with a table point inside it */
+	struct table_lut_seg seg[TABLE_LUT_SEGMENTS];
+};
+
+#define TABLE_LUT(x_per_count_) { (x_per_count_) }
+
+/* 3D table, ie. RPM x load x CLT.  Sized so the whole thing (1636 bytes) fits in one 2048 byte
+   tuner page.  Data is layer by layer, each layer laid out like a 2D table */
+
+#define MAX_3D_COLS 12
+#define MAX_3D_ROWS 8
+#define MAX_3D_LAYERS 4
+
+struct table3d
+{
+	uint8_t cols;			/* Number of columns in the table */
+	uint8_t rows;			/* Number of rows in the table */
+	uint8_t layers;			/* Number of layers in the table */
+	uint8_t filler;			/* filler to put 32bit stuff on multiple of 4 */
+	float col_axis[MAX_3D_COLS];
+	float row_axis[MAX_3D_ROWS];
+	float layer_axis[MAX_3D_LAYERS];
+	float data[MAX_3D_LAYERS * MAX_3D_ROWS * MAX_3D_COLS];	/* layers*rows*cols, X order, rows first, then layers */
+};
+
+/* Per call site state for table_lookup_3d() - keep it static and zero it to start */
+
+struct table3d_hint
+{
+	struct axis_hint col;
+	struct axis_hint row;
+	struct axis_hint layer;
+	const struct table3d *table;	/* table the axis info is for */
+	uint32_t generation;		/* Page_Generation when it was worked out */
+	uint8_t valid;				/* the table's size is in range, lookups return 255 if not */
+};
+
 /* Function Declarations */
+uint32_t table_check ( const struct table * const t);
 float table_lookup ( const float col_value, const float row_value, const struct table * const t);
+float table_lookup_hint ( const float col_value, const float row_value, const struct table * const t, struct table_hint * const hint);
+void table_locate ( const float col_value, const float row_value, const struct table * const t, struct table_hint * const hint, struct table_pos * const pos);
+float table_interp ( const struct table * const t, const struct table_pos * const pos);
+void table_lookup_array ( const float * const col_values, const float * const row_values, float * const results, const uint32_t n, const struct table * const t);
+uint32_t table3d_check ( const struct table3d * const t);
+float table_lookup_3d ( const float col_value, const float row_value, const float layer_value, const struct table3d * const t, struct table3d_hint * const hint);
+int32_t table_lookup_q ( const int32_t col_value, const int32_t row_value, const struct table * const t, struct table_q * const q);
+void table_lookup_group ( struct table_group * const group);
+float table_lookup_lut ( uint16_t count, const struct table * const t, struct table_lut * const lut);
 
 /*  macro to extract value from table */
 #define value(index)	*(float *)index
@@ -38,10 +38,12 @@ extern float Ref_IAT;
 extern float Ref_MAP;
 extern float Ref_Baro;
 extern float Ref_TPS;
+extern uint8_t MAP_Angle_OK;    // MAP[0] is from a recent intake stroke burst
+extern uint16_t MAP_Angle_Count; // the burst MAP[0] came from, A/D counts
 
 void Get_Slow_Op_Vars(void);
 void Get_Fast_Op_Vars(void);
-uint16_t Filter_AD(vuint16_t * Value, uint16_t Strength);
+float Get_MAP_Slope(void);
 
 #ifdef __cplusplus
 }
@@ -22,7 +22,8 @@
 #define WHEEL_SPEED_1_4       16,17,18,19      // read wheel speed
 //for testing - Blink based on engine position status
 #define MAP_WINDOW_CHANNEL    26    // eTPU channel to output MAP sample windows on - fixed, do not change
-#define KNOCK_WINDOW_CHANNEL  28    // eTPU channel to output MAP sample windows on - fixed
+#define KNOCK_WINDOW_CHANNEL  28    // eTPU channel to output knock sample windows on - fixed
+#define ANGLE_CLOCK_CHANNEL   29    // eTPU channel whose window interrupts drive the angle clock - pad 143 left GPIO
 #define FAKE_CAM_PIN          137   // GPIO used for semi-sequentail operation
 
 // used for serial port A and tuner communications
@@ -31,7 +32,7 @@
 
 // servo motor or idle air control
 #define PWM1_CHANNEL 27     // eTPU channel to use for servo motor output 
-#define PWM1_PAD     143    // servo GPIO pad # for above
+#define PWM1_PAD     141    // servo GPIO pad # for above, eTPU pad = 114 + channel
 #define PWM1_HZ      50     // recommend 50 for servos, 200 or 300 for IAC
 
 //Outptional outputs
@@ -14,3 +14,5 @@
 
 void init_eDMA(void);
 void Zero_DMA_Channel(int DMA_chan);
+void ADC_Q3_DMA_Start(uint8_t buf);
+uint16_t ADC_Q3_DMA_Count(uint8_t buf);
@@ -24,20 +24,51 @@ extern "C"
 extern uint32_t ADC_CmdQ0[40];		// 
 extern uint32_t ADC_CmdQ1[1];		
 extern uint32_t ADC_CmdQ2[1];		// unused
-extern uint32_t ADC_CmdQ3[1];		// Knock from eTPU 28 AD0/AD1 and AD2/AD3 (both differential)
+extern uint32_t ADC_CmdQ3[1];		// Knock from eTPU 28 AD0/AD1, continuous while the knock window is open
 extern uint32_t ADC_CmdQ4[1];   	// unused
-extern uint32_t ADC_CmdQ5[1];   	// for MAP based on trigger from eTPU 26 AD18 
+extern uint32_t ADC_CmdQ5[8];   	// for MAP based on trigger from eTPU 26 AD18, ADC_Q5_SIZE
 
 // where the results are stored, 
 // count must be exactly right, usually same as above (unless using time stamps)
-extern vuint16_t ADC_RsltQ0[40];
+#define ADC_Q0_SIZE 40
+// Q0 A/D channel numbers of the sensors, AD_Filter.c gives these their default filters
+#define V_Batt_AD    25
+#define V_CLT_AD     39
+#define V_IAT_AD     38
+#define V_TPS_AD     31
+#define V_MAP_2_AD   23     /* TODO - shares a pin with O2 1 */
+#define V_MAF_1_AD   35
+#define V_P1_AD      17
+#define V_P2_AD      31
+#define V_P3_AD      32
+#define V_P4_AD      33
+#define V_O2_1_AD    23
+#define V_O2_2_AD    28
+extern vuint16_t ADC_Q0_Buf[2][ADC_Q0_SIZE];  // DMA ping-pong for Q0, read it with ADC_Scan_Read()
 extern vuint16_t ADC_RsltQ1[1];
 extern vuint16_t ADC_RsltQ2[1];
-extern vuint16_t ADC_RsltQ3[1];
+#define ADC_CLOCK_PS 0xA                    // ADC0/1_CR prescaler, A/D clock = CPU_CLOCK / (2 * (PS + 1))
+#define ADC_Q3_SIZE 512                     // most knock samples kept per window
+#define ADC_Q3_CLOCKS (64 + 13)             // A/D clocks per knock conversion, LST(2) sample + 13 to convert
+#define ADC_Q3_RATE ((float)CPU_CLOCK / (2 * (ADC_CLOCK_PS + 1)) / ADC_Q3_CLOCKS)   // knock samples/s, needs config.h
+#define ADC_KNOCK_CHANNEL 96                // DAN0, AN0 - AN1 differential, knock 1
+extern vuint16_t ADC_Q3_Buf[2][ADC_Q3_SIZE];  // one knock window each, see Knock.c
 extern vuint16_t ADC_RsltQ4[1];
-extern vuint16_t ADC_RsltQ5[1];
+#define ADC_Q5_SIZE 8                       // MAP conversions per window, power of 2
+#define ADC_MAP_CHANNEL 18                  // AN18, MAP 1
+extern vuint16_t ADC_Q5_Buf[2][ADC_Q5_SIZE];  // DMA ping-pong for Q5, one window each, see MAP_Sample.c
+
+// one complete Q0 scan
+struct adc_scan {
+    uint16_t result[ADC_Q0_SIZE];   // indexed by A/D channel, filtered, see AD_Filter.h
+    uint16_t raw[ADC_Q0_SIZE];
+    uint32_t seq;                   // scans completed since reset
+    uint32_t time;                  // systime when the scan completed
+};
 
 void init_ADC(void);
+void ADC_Scan_Done(uint8_t buf);
+uint8_t ADC_Scan_Read(struct adc_scan *scan);
 
 #ifdef __cplusplus
 }
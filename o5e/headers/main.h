@@ -4,6 +4,5 @@
 
 // general purpose clocks that all tasks can use
 		  	// crank degrees since engine start - won't roll over
-void Angle_Clock_Task(void);
-extern uint32_t Degree_Clock;
+extern volatile uint32_t Degree_Clock;
 #endif
\ No newline at end of file
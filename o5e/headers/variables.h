@@ -36,6 +36,8 @@
 // subroutines related to this file
 void init_variables(void);
 void Set_Page_Locations(uint8_t block);
+void Page_Changed(uint8_t page);
+uint8_t Check_Page_Tables(uint8_t page);
 
 //************************************************************************************
 
@@ -105,10 +107,11 @@ float V_P[4];					//Optional 0-5V signal or 0/5V digital
 uint32_t Last_Error; 
 uint32_t Last_Error_Time;
 float Air_Temp_Fuel_Corr;
+uint16_t Knock_Intensity[8];	//knock band energy over its running average per cylinder, 100 = average
 };
 
 // this must match the offsets in the .ini file AND must be a multiple of 4
-#define OUTPUT_CHANNELS_SIZE  172        // don't use sizeof() here
+#define OUTPUT_CHANNELS_SIZE  188        // don't use sizeof() here
 
 
 // these are for convenience and more readable code - must match above
@@ -151,6 +154,7 @@ float Air_Temp_Fuel_Corr;
 #define Last_Error_Time Output_Channels.Last_Error_Time
 
 #define Air_Temp_Fuel_Corr Output_Channels.Air_Temp_Fuel_Corr
+#define Knock_Intensity Output_Channels.Knock_Intensity
 
 
 //*******************************************************
@@ -329,6 +333,13 @@ extern struct Outputs Output_Channels;
 
 #define MAP_2_Table ((CONST struct table * )(&Page_Ptr[4][1296]))
 
+#define AD_Filter_Type_Array ((CONST U08 * )(&Page_Ptr[4][1620]))
+#define AD_Filter_Time_Array ((CONST F32 * )(&Page_Ptr[4][1660]))
+
+#define Knock_Freq (*(CONST F32 * )(&Page_Ptr[4][1820]))
+#define Knock_Window_Open (*(CONST F32 * )(&Page_Ptr[4][1824]))
+#define Knock_Window_Width (*(CONST F32 * )(&Page_Ptr[4][1828]))
+
 
 // Page 6
 #define Inj_Time_Corr_Table ((CONST struct table * )(&Page_Ptr[5][0]))
@@ -368,6 +379,8 @@ extern volatile uint8_t *Page_Ptr[NPAGES];
 extern int8_t Ram_Page_Buffer_Page;	// which page # is in the buffer (-1 means none)
 extern int Flash_OK;		// is flash empty or has values
 extern uint8_t Burn_Count;		// how many flash burns 
+extern uint8_t Page_Valid[NPAGES];	// all tables on the page are a usable size
+extern volatile uint32_t Page_Generation;	// bumped every time any page moves or changes
 
 // This 8 byte (not counting directory) structure is written as a header to the beginning of a used flash block
 struct Flash_Header {
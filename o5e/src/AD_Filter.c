@@ -0,0 +1,289 @@
+/*********************************************************************************
+
+    @file      AD_Filter.c
+    @brief     Open5xxxECU - per channel filter bank for the Q0 A/D scan
+    @note      www.Open5xxxECU.org
+    @version   1.0
+
+**********************************************************************************/
+
+#include <stdint.h>
+#include "typedefs.h" /**< pickup vuint_xxx */
+#include "config.h"
+#include "variables.h"
+#include "eQADC_OPS.h"
+#include "AD_Filter.h"
+
+#define AD_FULL_SCALE 16384.0f          // A/D counts, see MAX_AD_COUNTS
+#define WINDOW_MASK (AD_FILTER_WINDOW - 1)
+
+// what the old 1/8 per read smoothing comes to as a time constant, 7 read periods
+#define DEFAULT_FAST 0.07f              // Get_Fast_Op_Vars(), 10 msec
+#define DEFAULT_SLOW 0.72f              // Get_Slow_Op_Vars(), 103 msec
+
+static const struct {
+    uint8_t ch;
+    float time;
+} Default_EMA[] = {
+    { V_Batt_AD, DEFAULT_FAST },
+    { V_TPS_AD, DEFAULT_FAST },
+    { V_MAP_2_AD, DEFAULT_FAST },
+    { V_MAF_1_AD, DEFAULT_FAST },
+    { V_P1_AD, DEFAULT_FAST },
+    { V_CLT_AD, DEFAULT_SLOW },
+    { V_IAT_AD, DEFAULT_SLOW }
+};
+
+/* State is kept as one array per field, indexed by channel, and the channels are
+   grouped into a list per filter type when the calibration changes.  Each type
+   is then one short loop with no decisions in it.
+
+   The coefficients are worked out in task context by AD_Filter_Update() into
+   the half of Coeff[] the scans aren't using, and moving Coeff_Seq on hands
+   it over in one write.  The scan interrupt can't be preempted by the task,
+   so it always sees a whole set, and it only compares a new one against what
+   it was using to see which channels restart. */
+
+struct ad_coeff {
+    uint8_t list[AD_FILTER_TYPES][ADC_Q0_SIZE];        // channels using each filter type
+    uint8_t n_list[AD_FILTER_TYPES];
+    uint8_t type[ADC_Q0_SIZE];          // never AD_FILTER_DEFAULT
+    float time[ADC_Q0_SIZE];            // seconds
+    float alpha[ADC_Q0_SIZE];           // EMA gain per scan
+    uint8_t window[ADC_Q0_SIZE];        // average/median length in scans
+    float inv_window[ADC_Q0_SIZE];
+    int32_t step[ADC_Q0_SIZE];          // rate limit, counts per scan
+};
+
+static struct ad_coeff Coeff[2];
+static volatile uint32_t Coeff_Seq;     // sets published, the scans use Coeff[Coeff_Seq & 1], 0 passes them through
+
+// scan interrupt only
+static uint32_t Seq_Used;               // Coeff_Seq of the set in use
+static uint8_t Type[ADC_Q0_SIZE];       // filter in use
+static float Time[ADC_Q0_SIZE];         // seconds in use
+static uint8_t Window[ADC_Q0_SIZE];     // average/median length in use
+static uint8_t Stale[ADC_Q0_SIZE];      // type or time changed, restart from the next reading
+static float Ema[ADC_Q0_SIZE];
+static int32_t Sum[ADC_Q0_SIZE];        // average, sum of the last Window[] raw values
+static uint16_t Last[ADC_Q0_SIZE];      // filter outputs
+
+static uint16_t History[AD_FILTER_WINDOW][ADC_Q0_SIZE];        // raw values, row per scan
+static uint8_t Pos;                     // History[] row of the newest scan
+
+static uint32_t Filter_Generation;      // Page_Generation the coefficients came from, task only
+static float Period;                    // seconds per scan the coefficients are for, task only
+static volatile float Period_Avg;       // seconds per scan measured
+static uint32_t Last_Time;
+static uint8_t Any_Stale;
+
+static void Setup(struct ad_coeff * const c, const float period);
+static void Adopt(const struct ad_coeff * const c);
+static void Prime(const uint16_t *raw);
+
+/**
+ * @brief  Filter one complete scan
+ * @param  raw   ADC_Q0_SIZE raw results, indexed by channel
+ * @param  out   ADC_Q0_SIZE filtered results
+ * @param  time  timebase (CPU clocks) when the scan completed, gives the scan rate
+ */
+
+void AD_Filter_Scan(const uint16_t *raw, uint16_t *out, uint32_t time)
+{
+    const struct ad_coeff *c;
+    uint32_t seq;
+    uint8_t i, n, k, ch;
+    float d;
+
+    // measure the scan rate, nothing is filtered until the task has coefficients for it
+    if (Last_Time != 0) {
+        d = (float)(time - Last_Time) * (1.0f / CPU_CLOCK);
+        if (Period_Avg == 0.0f)
+            Period_Avg = d;
+        else
+            Period_Avg += (d - Period_Avg) * (1.0f / 16.0f);
+    }
+    Last_Time = time;
+    seq = Coeff_Seq;
+    if (seq == 0) {
+        for (i = 0; i < ADC_Q0_SIZE; ++i)
+            out[i] = raw[i];
+        return;
+    }
+
+    c = &Coeff[seq & 1];
+    if (Seq_Used != seq) {
+        Seq_Used = seq;
+        Adopt(c);
+    }
+
+    Pos = (Pos + 1) & WINDOW_MASK;
+    if (Any_Stale)
+        Prime(raw);
+
+    for (n = 0; n < c->n_list[AD_FILTER_NONE]; ++n) {
+        ch = c->list[AD_FILTER_NONE][n];
+        Last[ch] = raw[ch];
+    }
+
+    for (n = 0; n < c->n_list[AD_FILTER_EMA]; ++n) {
+        ch = c->list[AD_FILTER_EMA][n];
+        Ema[ch] += c->alpha[ch] * ((float)raw[ch] - Ema[ch]);
+        Last[ch] = (uint16_t)(Ema[ch] + 0.5f);
+    }
+
+    // before History[Pos] is overwritten, it holds the value AD_FILTER_WINDOW scans back
+    for (n = 0; n < c->n_list[AD_FILTER_AVERAGE]; ++n) {
+        ch = c->list[AD_FILTER_AVERAGE][n];
+        Sum[ch] += (int32_t)raw[ch] - History[(Pos - Window[ch]) & WINDOW_MASK][ch];
+        Last[ch] = (uint16_t)((float)Sum[ch] * c->inv_window[ch] + 0.5f);
+    }
+
+    for (i = 0; i < ADC_Q0_SIZE; ++i)
+        History[Pos][i] = raw[i];
+
+    for (n = 0; n < c->n_list[AD_FILTER_MEDIAN]; ++n) {
+        uint16_t v[AD_FILTER_WINDOW];
+        uint16_t x;
+        uint8_t j;
+
+        ch = c->list[AD_FILTER_MEDIAN][n];
+        for (k = 0; k < Window[ch]; ++k) {      // insertion sort, at most 7 values
+            x = History[(Pos - k) & WINDOW_MASK][ch];
+            for (j = k; j > 0 && v[j - 1] > x; --j)
+                v[j] = v[j - 1];
+            v[j] = x;
+        }
+        Last[ch] = v[Window[ch] >> 1];
+    }
+
+    for (n = 0; n < c->n_list[AD_FILTER_RATE]; ++n) {
+        int32_t delta;
+
+        ch = c->list[AD_FILTER_RATE][n];
+        delta = (int32_t)raw[ch] - Last[ch];
+        delta = delta > c->step[ch] ? c->step[ch] : delta;
+        delta = delta < -c->step[ch] ? -c->step[ch] : delta;
+        Last[ch] = (uint16_t)(Last[ch] + delta);
+    }
+
+    for (i = 0; i < ADC_Q0_SIZE; ++i)
+        out[i] = Last[i];
+}
+
+/**
+ * @brief  Work out new coefficients when the calibration changes or the scan
+ *         rate moves more than 1/16 from what they assume
+ * @note   task context, from Get_Slow_Op_Vars().  Nothing is filtered until
+ *         the first call after the scan rate is known
+ */
+
+void AD_Filter_Update(void)
+{
+    const float period = Period_Avg;
+    float d;
+
+    if (period == 0.0f)
+        return;
+    d = period - Period;
+    if (d < 0.0f)
+        d = -d;
+    if (Coeff_Seq != 0 && Filter_Generation == Page_Generation && d <= Period * (1.0f / 16.0f))
+        return;
+
+    Setup(&Coeff[(Coeff_Seq + 1) & 1], period);
+    ++Coeff_Seq;                        // the interrupt takes the set when it sees this
+}
+
+// work out the per channel coefficients from the calibration and the scan rate
+
+static void Setup(struct ad_coeff * const c, const float period)
+{
+    uint8_t ch, type, n, i;
+    float t, w;
+
+    Filter_Generation = Page_Generation;
+    Period = period;
+
+    for (type = 0; type < AD_FILTER_TYPES; ++type)
+        c->n_list[type] = 0;
+
+    for (ch = 0; ch < ADC_Q0_SIZE; ++ch) {
+        type = AD_Filter_Type_Array[ch];
+        t = AD_Filter_Time_Array[ch];
+        if (type == AD_FILTER_DEFAULT || type >= AD_FILTER_TYPES) {
+            type = AD_FILTER_NONE;
+            t = 0.0f;
+            for (i = 0; i < sizeof(Default_EMA) / sizeof(Default_EMA[0]); ++i) {
+                if (Default_EMA[i].ch == ch) {
+                    type = AD_FILTER_EMA;
+                    t = Default_EMA[i].time;
+                }
+            }
+        }
+        if (!(t > 0.0f))                // also catches blank flash (NaN)
+            t = 0.0f;
+
+        c->type[ch] = type;
+        c->time[ch] = t;
+        c->list[type][c->n_list[type]++] = ch;
+
+        c->alpha[ch] = period / (t + period);
+
+        w = t / period + 0.5f;
+        n = w >= AD_FILTER_WINDOW ? AD_FILTER_WINDOW : w < 1.0f ? 1 : (uint8_t)w;
+        if (type == AD_FILTER_MEDIAN && (n & 1) == 0)
+            --n;                        // odd, so there is a middle value
+        c->window[ch] = n;
+        c->inv_window[ch] = 1.0f / n;
+
+        w = t > 0.0f ? AD_FULL_SCALE * period / t : AD_FULL_SCALE;
+        c->step[ch] = w < 1.0f ? 1 : w > AD_FULL_SCALE ? (int32_t)AD_FULL_SCALE : (int32_t)w;
+    }
+}
+
+// take a new set.  Only channels whose type or time changed are restarted, a
+// tuner write to anything else (or the scan rate drifting) leaves the filter
+// state alone
+
+static void Adopt(const struct ad_coeff * const c)
+{
+    uint8_t ch, k, n;
+    int32_t sum;
+
+    for (ch = 0; ch < ADC_Q0_SIZE; ++ch) {
+        n = c->window[ch];
+        if (c->type[ch] != Type[ch] || c->time[ch] != Time[ch]) {
+            Type[ch] = c->type[ch];
+            Time[ch] = c->time[ch];
+            Stale[ch] = 1;
+            Any_Stale = 1;
+        } else if (n != Window[ch]) {
+            // the average's length moved with the scan rate, resum the history it covers now
+            sum = 0;
+            for (k = 0; k < n; ++k)
+                sum += History[(Pos - k) & WINDOW_MASK][ch];
+            Sum[ch] = sum;
+        }
+        Window[ch] = n;
+    }
+}
+
+// start the changed filters from the current reading, no step when a filter changes
+
+static void Prime(const uint16_t *raw)
+{
+    uint8_t i, k;
+
+    for (i = 0; i < ADC_Q0_SIZE; ++i) {
+        if (!Stale[i])
+            continue;
+        for (k = 0; k < AD_FILTER_WINDOW; ++k)
+            History[k][i] = raw[i];
+        Ema[i] = raw[i];
+        Sum[i] = (int32_t)raw[i] * Window[i];
+        Last[i] = raw[i];
+        Stale[i] = 0;
+    }
+    Any_Stale = 0;
+}
@@ -0,0 +1,171 @@
+/*********************************************************************************
+
+    @file      Angle_Clock.c
+    @brief     Open5xxxECU - crank angle clock, advanced from an eTPU channel interrupt
+    @note      www.Open5xxxECU.org
+    @version   1.0
+
+**********************************************************************************/
+
+#include <stdint.h>
+#include "config.h"
+#include "cocoos.h"
+#include "bsp.h"
+#include "variables.h"
+#include "err.h"
+#include "etpu_util.h"
+#include "etpu_struct.h"
+#include "etpu_app_eng_pos.h"
+#include "etpu_knock_window.h"
+#include "eTPU_OPS.h"
+#include "main.h"
+#include "Angle_Events.h"
+#include "Angle_Clock.h"
+
+#define ANGLE_CLOCK_VECTOR   (68 + ANGLE_CLOCK_CHANNEL)    // eTPU A channel n interrupts on INTC vector 68 + n
+/* INTC levels, highest first: angle clock 8, MAP burst DMA (Q5) 5, A/D scan
+   DMA (Q0) 4, knock window 3 */
+#define ANGLE_CLOCK_PRIORITY 8          // above everything else, callbacks are angle critical
+
+#define ANGLE_TICKS_PER_DEGREE ((Ticks_Per_Tooth * (N_Teeth + Missing_Teeth)) / 360)
+
+volatile uint32_t Degree_Clock = 0;     // crank degrees since engine start - won't roll over
+
+static uint32_t Prev_Angle;             // TCR2 at the last whole degree counted
+static uint32_t Cycle_Ticks;            // TCR2 ticks per 720 degrees, TCR2 goes back to 0 after that
+static uint32_t Ticks_Per_Degree;       // cached ANGLE_TICKS_PER_DEGREE
+static uint32_t Degrees_Per_Tick;       // 2^32 / Ticks_Per_Degree
+static uint32_t Angle_Generation;       // Page_Generation the three above came from
+static uint8_t Running;                 // the window channel started
+
+static void Angle_Clock_ISR(void);
+static uint32_t Window_Width(const uint32_t * const open, const uint8_t i);
+
+/**
+ * @brief  Start the eTPU window channel and hook up its interrupt
+ * @note   call from init_eTPU() after the engine position channels, the
+ *         window angles come from the cam channel's ticks per cycle
+ */
+
+void Angle_Clock_Init(void)
+{
+    static uint32_t Window_Table[ANGLE_CLOCK_WINDOWS * 2];     // open, width pairs in degrees*100
+    uint32_t open[ANGLE_CLOCK_WINDOWS];
+    uint8_t i;
+
+    Angle_Generation = Page_Generation - 1;    // work out the conversion on the first interrupt
+
+    // events are usually added later, Angle_Clock_Update() moves the windows onto them
+    (void)Angle_Events_Windows(open, ANGLE_CLOCK_WINDOWS);
+    for (i = 0; i < ANGLE_CLOCK_WINDOWS; ++i) {
+        Window_Table[i * 2] = open[i];
+        Window_Table[i * 2 + 1] = Window_Width(open, i);
+    }
+
+    if (fs_etpu_knock_window_init(ANGLE_CLOCK_CHANNEL,
+                                  FS_ETPU_PRIORITY_LOW,
+                                  ANGLE_CLOCK_WINDOWS,
+                                  FS_ETPU_KNOCK_FM0_RISING_EDGE,
+                                  FS_ETPU_KNOCK_FM1_INT_OPEN,  // one interrupt per window
+                                  1,                           // CAM in engine: A; channel: 1
+                                  Window_Table) != 0) {
+        err_push( CODE_ANGLE_CLOCK_INIT );
+        return;
+    }
+
+    (void)bsp_vector_install(ANGLE_CLOCK_VECTOR, Angle_Clock_ISR);
+    bsp_vector_set_pri(ANGLE_CLOCK_VECTOR, ANGLE_CLOCK_PRIORITY);
+    fs_etpu_clear_chan_interrupt_flag(ANGLE_CLOCK_CHANNEL);
+    fs_etpu_interrupt_enable(ANGLE_CLOCK_CHANNEL);
+    Running = 1;
+}
+
+/**
+ * @brief  Move the windows when the angle events or the calibration change
+ * @note   task context, call every Angle_Clock_Task pass
+ */
+
+void Angle_Clock_Update(void)
+{
+    uint32_t open[ANGLE_CLOCK_WINDOWS];
+    uint8_t i;
+
+    if (!Running || !Angle_Events_Windows(open, ANGLE_CLOCK_WINDOWS))
+        return;
+
+    // the eTPU takes each new window at its next opening, window numbers count from 0
+    for (i = 0; i < ANGLE_CLOCK_WINDOWS; ++i)
+        (void)fs_etpu_knock_window_update(ANGLE_CLOCK_CHANNEL, 1, i, open[i], Window_Width(open, i));
+}
+
+/**
+ * @brief  Zero Degree_Clock and count from the current angle, call on a sync change
+ * @note   task context, masks the angle interrupt while it works
+ */
+
+void Angle_Clock_Restart(void)
+{
+    os_declare_state();
+    os_disable_interrupts();
+
+    Degree_Clock = 0;
+    Prev_Angle = angle_clock() & 0xffffff;
+    Angle_Events_Reset();       // angle events need the engine position again
+
+    os_enable_interrupts();
+}
+
+/**
+ * @brief  ANGLE_CLOCK_CHANNEL interrupt, a window just opened
+ * @note   the only place Degree_Clock and the OS angle clock move.  os_task_tick()
+ *         masks interrupts around its own work so the decrementer can't tear it
+ */
+
+static void Angle_Clock_ISR(void)
+{
+    uint32_t tcr2;
+    uint32_t i;
+
+    fs_etpu_clear_chan_interrupt_flag(ANGLE_CLOCK_CHANNEL);
+
+    // redo the conversion constants only when the calibration changes
+    if (Angle_Generation != Page_Generation) {
+        Angle_Generation = Page_Generation;
+        Cycle_Ticks = (uint32_t)Ticks_Per_Tooth * Total_Teeth * 2;
+        Ticks_Per_Degree = ANGLE_TICKS_PER_DEGREE;
+        if (Ticks_Per_Degree < 2)           // 1 needs no conversion (2^32 won't fit), 0 is a bad config
+            Degrees_Per_Tick = 0;
+        else
+            Degrees_Per_Tick = (uint32_t)(((uint64_t)1 << 32) / Ticks_Per_Degree);
+    }
+
+    tcr2 = angle_clock() & 0xffffff;
+    if (tcr2 >= Prev_Angle)
+        i = tcr2 - Prev_Angle;
+    else
+        i = tcr2 + Cycle_Ticks - Prev_Angle;    // TCR2 went back to 0 at the end of the cycle
+    if (Ticks_Per_Degree != 1)
+        i = (uint32_t)(((uint64_t)i * Degrees_Per_Tick) >> 32);    // upper word of 32x32 multiply = full degrees
+
+    if (i > 0) {                // delta full degrees
+        Degree_Clock += i;
+        Prev_Angle += i * Ticks_Per_Degree;
+        if (Prev_Angle >= Cycle_Ticks)
+            Prev_Angle -= Cycle_Ticks;
+        os_task_tick(1, (uint16_t) i);      // increment os angle clock value
+    }
+
+    // run the per cylinder callbacks whose crank angle has come up
+    if (fs_etpu_eng_pos_get_engine_position_status() == FS_ETPU_ENG_POS_FULL_SYNC)
+        Angle_Events_Dispatch(tcr2);
+}
+
+/* Half the gap to the next window, so each window closes before the next opens */
+
+static uint32_t Window_Width(const uint32_t * const open, const uint8_t i)
+{
+    uint32_t next;
+
+    next = i + 1 < ANGLE_CLOCK_WINDOWS ? open[i + 1] : open[0] + 72000;
+    return (next - open[i]) / 2;
+}
@@ -0,0 +1,253 @@
+/*********************************************************************************
+
+    @file      Angle_Events.c
+    @brief     Open5xxxECU - crank angle event queue, runs per cylinder callbacks at
+               a fixed angle before each cylinder's TDC
+    @note      www.Open5xxxECU.org
+    @version   1.0
+
+**********************************************************************************/
+
+#include <stdint.h>
+#include "config.h"
+#include "cocoos.h"
+#include "bsp.h"
+#include "variables.h"
+#include "err.h"
+#include "etpu_util.h"
+#include "eTPU_OPS.h"
+#include "Angle_Events.h"
+
+/* One registered event.  angle is where it fires in TCR2 ticks from the start of the
+   engine cycle, worked out from btdc_x100 and the calibration */
+
+struct angle_event
+{
+	uint32_t angle;
+	uint32_t angle_x100;		/* the same angle in deg*100, for the angle clock windows */
+	int32_t btdc_x100;
+	angle_event_fn fn;
+	uint8_t cyl;
+};
+
+static struct angle_event Events[MAX_ANGLE_EVENTS];	/* sorted by angle */
+static uint8_t N_Events;
+static uint8_t Next_Event;			/* first event not yet run this cycle */
+static uint32_t Last_Angle;			/* TCR2 at the previous dispatch */
+static uint8_t Position_Known;		/* Next_Event and Last_Angle are valid */
+static uint32_t Cycle_Ticks;		/* TCR2 ticks per 720 degrees */
+static uint32_t Events_Generation;	/* Page_Generation the angles came from */
+static uint8_t Windows_Stale = 1;	/* angles changed since Angle_Events_Windows() */
+
+#define WINDOW_MIN_GAP 200			/* deg*100, closer event angles share an angle clock window */
+
+static void Rebuild_Events(void);
+
+/**
+ * @brief  Register fn to run for cylinder cyl at btdc_x100 (deg*100) before its TDC
+ * @retval 0 ok, -1 if the queue is full or cyl is out of range
+ * @note   call before os_start() - the queue is not locked
+ */
+
+int8_t Angle_Event_Add(uint8_t cyl, int32_t btdc_x100, angle_event_fn fn)
+{
+	if (N_Events >= MAX_ANGLE_EVENTS || cyl >= ANGLE_MAX_CYL || fn == 0) {
+		err_push( CODE_ANGLE_EVENTS_FULL );
+		return -1;
+	}
+
+	Events[N_Events].btdc_x100 = btdc_x100;
+	Events[N_Events].fn = fn;
+	Events[N_Events].cyl = cyl;
+	++N_Events;
+
+	Events_Generation = Page_Generation - 1;		/* force a rebuild and resort */
+	Windows_Stale = 1;
+	return 0;
+}
+
+/**
+ * @brief  Forget the engine position, call on loss of sync
+ * @note   nothing runs on the first dispatch after this, it only finds the place in the cycle
+ */
+
+void Angle_Events_Reset(void)
+{
+	Position_Known = 0;
+}
+
+/**
+ * @brief  Run the callbacks for every event passed since the previous call
+ * @param  tcr2 current eTPU angle counter, only valid in full sync
+ * @note   work done is one compare plus the events that are due
+ */
+
+void Angle_Events_Dispatch(uint32_t tcr2)
+{
+	if (Events_Generation != Page_Generation)
+		Rebuild_Events();
+
+	if (N_Events == 0 || tcr2 >= Cycle_Ticks)
+		return;
+
+	if (!Position_Known) {
+		/* start with the first event still ahead of us */
+		Next_Event = 0;
+		while (Next_Event < N_Events && Events[Next_Event].angle <= tcr2)
+			++Next_Event;
+		Last_Angle = tcr2;
+		Position_Known = 1;
+		return;
+	}
+
+	if (tcr2 < Last_Angle) {
+		/* TCR2 went back to 0 at the end of the cycle - finish off the old cycle first */
+		while (Next_Event < N_Events) {
+			Events[Next_Event].fn(Events[Next_Event].cyl);
+			++Next_Event;
+		}
+		Next_Event = 0;
+	}
+
+	while (Next_Event < N_Events && Events[Next_Event].angle <= tcr2) {
+		Events[Next_Event].fn(Events[Next_Event].cyl);
+		++Next_Event;
+	}
+
+	Last_Angle = tcr2;
+}
+
+/**
+ * @brief  Place n angle clock windows so each event angle opens one
+ * @param  open_x100 where to put the n opening angles, deg*100 ascending
+ * @param  n number of windows, at least 1
+ * @retval 1 if the angles changed since the last call, 0 if not (open_x100 untouched)
+ * @note   task context.  With more than n event angles the windows closest to the
+ *         next one are dropped, their events run at the next window instead.
+ *         Spare windows split the longest gaps so the angle clock keeps moving
+ */
+
+uint8_t Angle_Events_Windows(uint32_t * const open_x100, const uint8_t n)
+{
+	uint32_t a[MAX_ANGLE_EVENTS + 1];
+	uint32_t gap, best, v;
+	uint8_t i, j, m;
+	os_declare_state();
+
+	os_disable_interrupts();			/* the angle clock interrupt rebuilds the list too */
+	if (Events_Generation != Page_Generation)
+		Rebuild_Events();
+	if (!Windows_Stale) {
+		os_enable_interrupts();
+		return 0;
+	}
+	Windows_Stale = 0;
+	m = 0;
+	for (i = 0; i < N_Events; ++i)
+		if (m == 0 || Events[i].angle_x100 >= a[m - 1] + WINDOW_MIN_GAP)
+			a[m++] = Events[i].angle_x100;
+	os_enable_interrupts();
+
+	if (m > 1 && a[m - 1] + WINDOW_MIN_GAP > a[0] + 72000)	/* too close across the end of the cycle */
+		--m;
+
+	/* too many, drop the window with the shortest wait for the next one */
+	while (m > n) {
+		best = 0xffffffff;
+		j = 0;
+		for (i = 0; i < m; ++i) {
+			gap = (i + 1 < m ? a[i + 1] : a[0] + 72000) - a[i];
+			if (gap < best) {
+				best = gap;
+				j = i;
+			}
+		}
+		for (i = j; i + 1 < m; ++i)
+			a[i] = a[i + 1];
+		--m;
+	}
+
+	if (m == 0)
+		a[m++] = 0;
+
+	/* too few, split the longest gap */
+	while (m < n) {
+		best = 0;
+		j = 0;
+		for (i = 0; i < m; ++i) {
+			gap = (i + 1 < m ? a[i + 1] : a[0] + 72000) - a[i];
+			if (gap > best) {
+				best = gap;
+				j = i;
+			}
+		}
+		v = (a[j] + best / 2) % 72000;
+		for (i = m; i > 0 && a[i - 1] > v; --i)
+			a[i] = a[i - 1];
+		a[i] = v;
+		++m;
+	}
+
+	for (i = 0; i < n; ++i)
+		open_x100[i] = a[i];
+	return 1;
+}
+
+/**
+ * @brief  Cylinder cyl's TDC in eTPU angle, deg*100 from 0 to 71999
+ * @note   done the same way as the fuel and spark channel setup in eTPU_OPS.c
+ */
+
+int32_t Angle_Cyl_TDC(uint8_t cyl)
+{
+	int32_t tdc;
+
+	tdc = ((int32_t)Cyl_Offset_Array[cyl] + (72000 - Engine_Position)) % 72000;
+	if (tdc < 0)
+		tdc += 72000;
+	return tdc;
+}
+
+/* Work out each event's TCR2 angle from the calibration and sort by it.  A tuner
+   write lands here too, so keep the place in the cycle rather than skip a cycle
+   of events.  An event moved across the current angle is missed or run twice
+   in that one cycle */
+
+static void Rebuild_Events(void)
+{
+	uint8_t i, j;
+	int32_t angle_x100;
+	struct angle_event tmp;
+	uint32_t old_cycle;
+
+	Events_Generation = Page_Generation;
+	old_cycle = Cycle_Ticks;
+	Cycle_Ticks = (uint32_t)Ticks_Per_Tooth * Total_Teeth * 2;
+
+	for (i = 0; i < N_Events; ++i) {
+		angle_x100 = (Angle_Cyl_TDC(Events[i].cyl) - Events[i].btdc_x100) % 72000;
+		if (angle_x100 < 0)
+			angle_x100 += 72000;
+		Events[i].angle_x100 = (uint32_t)angle_x100;
+		Events[i].angle = (uint32_t)(((uint64_t)angle_x100 * Cycle_Ticks) / 72000);
+	}
+
+	/* insertion sort, a handful of entries */
+	for (i = 1; i < N_Events; ++i) {
+		tmp = Events[i];
+		for (j = i; j > 0 && Events[j - 1].angle > tmp.angle; --j)
+			Events[j] = Events[j - 1];
+		Events[j] = tmp;
+	}
+
+	Windows_Stale = 1;
+
+	/* a new wheel changes what TCR2 means, only then is the place lost */
+	if (Cycle_Ticks != old_cycle) {
+		Position_Known = 0;
+	} else {
+		Next_Event = 0;
+		while (Next_Event < N_Events && Events[Next_Event].angle <= Last_Angle)
+			++Next_Event;
+	}
+}
@@ -23,6 +23,8 @@
 float Base_Pulse_Width;
 float Inverse_Injector_Pressure;
 float Injector_Flow;
+
+static struct table_hint Sqrt_Hint;     // remembers the last cell used
   
 void Get_Base_Pulse_Width(void)
 {  
@@ -30,7 +32,7 @@ void Get_Base_Pulse_Width(void)
 	//correct injector flow rate for actual fuel pressure
 	Inverse_Injector_Pressure = 1.0f / Rating_Fuel_Presure;
     Injector_Flow = Fuel_Presure * Inverse_Injector_Pressure; 
-    Injector_Flow = table_lookup(Injector_Flow, 1, sqrt_Table);
+    Injector_Flow = table_lookup_hint(Injector_Flow, 1, sqrt_Table, &Sqrt_Hint);
     Injector_Flow = Injector_Flow * Injector_Size;// get current injector flow	
 	
     // base (max) pulse width
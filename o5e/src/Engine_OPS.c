@@ -35,6 +35,9 @@
 #include "eTPU_OPS.h"
 #include "Load_OPS.h"
 #include "Base_Values_OPS.h"
+#include "MAP_Sample.h"
+#include "Knock.h"
+#include "Angle_Events.h"
 
 
 
@@ -42,10 +45,62 @@ uint32_t *fs_free_param;
 float Pulse_Width;
 uint32_t etpu_Pulse_Width;
 //uint32_t Injector_Flow;
-static void Check_Engine(void);
+void Check_Engine(void);     /* not static, it is called from the debugger */
 
 static void Set_Spark(void);
 static void Set_Fuel(void);
+static uint8_t Spark_End_Angles(int32_t advance_x100, uint32_t *end_1, uint32_t *end_2);
+static void Fuel_Cyl_Update(uint8_t cyl);
+static void Spark_Cyl_Update(uint8_t cyl);
+
+static void Get_Speed_Load_Tables(void);
+
+// remembers the last table cell used by each lookup below
+static struct table_hint Dwell_Hint;
+static struct table_hint Fuel_Temp_Corr_Hint;
+static struct table_hint IAT_Fuel_Corr_Hint;
+static struct table_hint Inj_Dead_Time_Hint;
+
+// the RPM x Reference_VE tables, looked up once per pass as a group - one axis search for
+// all three when their axes are the same.  Spark advance and injection angle only go to the
+// eTPU, so they use fixed point copies of the tables that give deg*100 directly
+enum { SPEED_LOAD_SPARK, SPEED_LOAD_INJ_END_ANGLE, SPEED_LOAD_INJ_TIME_CORR, N_SPEED_LOAD };
+static struct table_group_member Speed_Load[N_SPEED_LOAD];
+static struct table_group Speed_Load_Group = { 0, 0, Speed_Load, N_SPEED_LOAD };
+static int32_t Spark_Advance_Q_Data[32 * 11];      // size from the .ini
+static int32_t Inj_End_Angle_Q_Data[32 * 11];
+static struct table_q Spark_Advance_Q = TABLE_Q(Spark_Advance_Q_Data, 1.0f, 10.0f, 100.0f);
+static struct table_q Inj_End_Angle_Q = TABLE_Q(Inj_End_Angle_Q_Data, 1.0f, 10.0f, 100.0f);
+static int32_t Spark_Advance_x100;                 // deg*100
+static int32_t Inj_End_Angle_x100;                 // deg*100
+static float Inj_Time_Corr;                        // %
+
+// per cylinder updates from the angle clock interrupt, see Cyl_Events_Init()
+#define FUEL_UPDATE_BTDC 0                         // deg*100, at TDC, ahead of the next injection ending Inj_End_Angle before the next TDC
+#define SPARK_UPDATE_BTDC 27000                    // deg*100, ahead of Set_Spark()'s recalc angle to about 8000 rpm
+#define MAP_DELTA_MAX 2048                         // A/D counts, about 0.6 V, the most an update moves off the pass's MAP
+#define SPARK_SLOPE_COUNTS 256                     // A/D counts, the step the spark slope is taken over
+
+// the pass's fuel or spark as a straight line in the MAP burst A/D count, in eTPU units,
+// so an update only multiplies.  The task writes one whole with interrupts off
+struct cyl_update {
+    uint8_t on;                                    // 0 leaves the channels to the pass
+    uint16_t count;                                // MAP burst the pass used, A/D counts
+    int32_t base;                                  // at count - TCR1 ticks of injection time, TCR2 ticks of end angle
+    int32_t slope;                                 // per A/D count, << 16
+};
+static struct cyl_update Fuel_Update;
+static struct cyl_update Spark_Update;
+static uint32_t Spark_Cycle;                       // TCR2 ticks per 720 degrees
+static int32_t Spark_End_Min;                      // TCR2 ticks, the end angles Spark_End_Angles() takes
+static int32_t Spark_End_Max;
+static struct table_hint Spark_Slope_Hint;
+static struct map_sample Cyl_MAP_Sample;           // only the angle clock interrupt copies into this
+static uint8_t Fuel_Events_OK;                     // every injector has its update, otherwise none are used
+static uint8_t Spark_Events_OK;                    // the same for the coils
+
+static void Cyl_Update_Set(struct cyl_update *u, uint8_t on, float base, float slope);
+static int32_t Cyl_Update_Value(struct cyl_update const *u);
 
 
 #if __CWCC__
@@ -113,27 +168,25 @@ void Engine10_Task(void)
 {
     task_open();
     task_wait(1);
-    
-
-	static float V_Battery_Stored;
-	
-	
 
 	//read sensors to get basline values
 	Get_Slow_Op_Vars();
 	Get_Fast_Op_Vars();
 	Get_Base_Pulse_Width();
-	
-
-	//store a baseline Battery Voltage
-	V_Battery_Stored = V_Batt;
 
     for (;;) {    
         // Read the sensors that can change quickly like RPM, TPS, MAP, ect
         Get_Fast_Op_Vars();
+        // keep the MAP windows at MAP_Angle_Table(RPM)
+        MAP_Sample_Update();
+        // knock windows and band filter follow the calibration
+        Knock_Update();
         // go calculate the %Reference VE that should be used for current conditions
         Get_Reference_VE();
 
+        // everything indexed by RPM and Reference_VE
+        Get_Speed_Load_Tables();
+
         // set spark advance and dwell based on current conditions
         Set_Spark();
 
@@ -152,7 +205,9 @@ void Engine10_Task(void)
 
 		
         
-        task_wait(9);           // allow others tasks to run
+        // fixed 10 msec rate whatever the load sensor, the per pass filters and enrichment
+        // are tuned to it.  MAP load uses the newest intake stroke burst each pass
+        task_period(10);        // late passes show up as overruns in the task stats
     }                           // for      
     task_close();
 }                               // Engine10_Task()
@@ -169,18 +224,12 @@ static void Set_Spark()
 
        
         // Looks up the desired spark advance in degrees before Top Dead Center (TDC)
-        Spark_Advance = table_lookup(RPM, Reference_VE, Spark_Advance_Table);
+        Spark_Advance = Spark_Advance_x100 * 0.01f;        // for the tuner
         
         // TODO Knock_Retard(); Issue #7
         // TODO  Air Temp retard                
 
-        Spark_Advance_eTPU = 72000 - ((int24_t)(Spark_Advance *100));
-        Spark_Advance_eTPU_2 = Spark_Advance_eTPU + 36000; // needed for waste spark, harmless otherwise
-          if (Spark_Advance_eTPU_2 >= 72000) // roll it over at 720 degrees
-              Spark_Advance_eTPU_2 -= 72000;
-          
-
-        if (Spark_Advance_eTPU < (72000 - 6000) && Spark_Advance_eTPU > 2000) {      // error checking, -60 to +20 is OK
+        if (!Spark_End_Angles(Spark_Advance_x100, &Spark_Advance_eTPU, &Spark_Advance_eTPU_2)) {      // error checking, -60 to +20 is OK
               err_push( CODE_OLDJUNK_E3 );
               Spark_Advance_eTPU = 0;
         }
@@ -197,13 +246,14 @@ static void Set_Spark()
         fs_etpu_spark_set_recalc_offset_angle(Spark_Channels[0], Spark_Recalc_Angle_eTPU); // global value despite the channel param
 
         // Dwell
-           Dwell = (table_lookup(V_Batt, 1, Dwell_Table)) * Inverse100;  //
+           Dwell = (table_lookup_hint(V_Batt, 1, Dwell_Table, &Dwell_Hint)) * Inverse100;  //
            Dwell = Dwell_Set * (1+ Dwell);
            
              //the engine position is not known, of over rev limit, shut off the spark
-              if (Enable_Ignition == 0 //spark disabled
+        uint8_t const spark_off = Enable_Ignition == 0 //spark disabled
                  || fs_etpu_eng_pos_get_engine_position_status() != FS_ETPU_ENG_POS_FULL_SYNC //crank position unknow
-                 || (RPM > Rev_Limit && (Rev_Limit_Type == 2 || Rev_Limit_Type == 4))) //rev limit engaged
+                 || (RPM > Rev_Limit && (Rev_Limit_Type == 2 || Rev_Limit_Type == 4)); //rev limit engaged
+              if (spark_off)
                     //Turn spark off
                     Dwell = 0;
 
@@ -217,15 +267,64 @@ static void Set_Spark()
     uint24_t Dwell_etpu = (uint24_t)(Dwell *1000);//the user sees msec, the etpu wants usec
     uint24_t Dwell_etpu_2 = Dwell_etpu * Ignition_Type; //used for waste spark, set to zero otherwise
     
+    // on MAP load the angle events move the advance along the newest intake stroke MAP.
+    // Published ahead of the channel writes, so an update can't turn a spark back on
+    if (Spark_Events_OK && !spark_off && Spark_Advance_eTPU != 0 && Load_Sense <= 3 && MAP_Angle_OK && MAP[0] > 0) {
+        float const ve_step = Reference_VE / MAP[0] * Get_MAP_Slope() * SPARK_SLOPE_COUNTS;
+        float const adv_step = table_lookup_hint(RPM, Reference_VE + ve_step, Spark_Advance_Table, &Spark_Slope_Hint)
+                             - table_lookup_hint(RPM, Reference_VE, Spark_Advance_Table, &Spark_Slope_Hint);
+        float const ticks_per_x100 = (float)Spark_Cycle * (1.0f / 72000);
+
+        // more advance is an earlier end angle
+        Cyl_Update_Set(&Spark_Update, 1, Spark_Advance_eTPU * ticks_per_x100,
+                       -adv_step * (100.0f / SPARK_SLOPE_COUNTS) * ticks_per_x100);
+    } else
+        Cyl_Update_Set(&Spark_Update, 0, 0, 0);
+
     for (i = 0; i < N_Coils; ++i) {
+        os_declare_state();
+
+        os_disable_interrupts();        // the angle events write the same pair of end angles
         fs_etpu_spark_set_end_angles(Spark_Channels[i], Spark_Advance_eTPU, Spark_Advance_eTPU_2);
         
         fs_etpu_spark_set_dwell_times(Spark_Channels[i], Dwell_etpu, Dwell_etpu_2);
+        os_enable_interrupts();
     }                           // for
 
-
 } // Set_Spark()
 
+// eTPU end angles for an advance, the second is for waste spark and harmless otherwise.
+// Returns 0 if the advance is out of range
+
+static uint8_t Spark_End_Angles(int32_t advance_x100, uint32_t *end_1, uint32_t *end_2)
+{
+    *end_1 = 72000 - advance_x100;
+    *end_2 = *end_1 + 36000;
+    if (*end_2 >= 72000)        // roll it over at 720 degrees
+        *end_2 -= 72000;
+
+    return !(*end_1 < (72000 - 6000) && *end_1 > 2000);
+}
+
+// Look up the RPM x Reference_VE tables
+
+static void Get_Speed_Load_Tables(void)
+{
+    Speed_Load[SPEED_LOAD_SPARK].table = Spark_Advance_Table;
+    Speed_Load[SPEED_LOAD_SPARK].q = &Spark_Advance_Q;
+    Speed_Load[SPEED_LOAD_INJ_END_ANGLE].table = Inj_End_Angle_Table;
+    Speed_Load[SPEED_LOAD_INJ_END_ANGLE].q = &Inj_End_Angle_Q;
+    Speed_Load[SPEED_LOAD_INJ_TIME_CORR].table = Inj_Time_Corr_Table;
+
+    Speed_Load_Group.col_value = RPM;
+    Speed_Load_Group.row_value = Reference_VE;
+    table_lookup_group(&Speed_Load_Group);
+
+    Spark_Advance_x100 = Speed_Load[SPEED_LOAD_SPARK].q_result;
+    Inj_End_Angle_x100 = Speed_Load[SPEED_LOAD_INJ_END_ANGLE].q_result;
+    Inj_Time_Corr = Speed_Load[SPEED_LOAD_INJ_TIME_CORR].result;
+}
+
 //TODO - add to ini for setting in TS.  Issue #11
 #define CRANK_VOLTAGE 11
 //#define Run_Threshold 250       // RPM below this then not running
@@ -241,8 +340,6 @@ static void Set_Fuel(void)
     static float Dead_Time;
     static uint32_t Dead_Time_etpu;
 
-    static uint32_t Load_Ref_AFR;
-
     // if the engine is not turning, the engine position is not known, or over reving, shut off the fuel channels
 
 
@@ -261,21 +358,21 @@ static void Set_Fuel(void)
 
 
         // Main fuel table correction - this is used to adjust for RPM effects
-        Corr = table_lookup(RPM, Reference_VE, Inj_Time_Corr_Table);
+        Corr = Inj_Time_Corr;
         Corr = 1.0f + (Corr * Inverse100);
         Pulse_Width = Pulse_Width * Corr;
 
 
         // Coolant temp correction from enrichment_ops
         if (Enable_Coolant_Temp_Corr == 1){
-           Fuel_Temp_Corr = table_lookup(CLT, 1, Fuel_Temp_Corr_Table);
+           Fuel_Temp_Corr = table_lookup_hint(CLT, 1, Fuel_Temp_Corr_Table, &Fuel_Temp_Corr_Hint);
            Fuel_Temp_Corr = 1.0f + (Fuel_Temp_Corr * Inverse100);
            Pulse_Width = Pulse_Width * Fuel_Temp_Corr;
         }
 
                 // Coolant temp correction from enrichment_ops
         if (Enable_Air_Temp_Corr == 1){
-           Air_Temp_Fuel_Corr = table_lookup(IAT, 1, IAT_Fuel_Corr_Table);
+           Air_Temp_Fuel_Corr = table_lookup_hint(IAT, 1, IAT_Fuel_Corr_Table, &IAT_Fuel_Corr_Hint);
            Air_Temp_Fuel_Corr = 1.0f + (Air_Temp_Fuel_Corr * Inverse100);
            Pulse_Width = Pulse_Width * Air_Temp_Fuel_Corr;
         }
@@ -298,7 +395,7 @@ static void Set_Fuel(void)
 
         // fuel dead time - extra pulse needed to open the injector
         // take user value and adjust based on battery voltage
-        Dead_Time = table_lookup(V_Batt, 1, Inj_Dead_Time_Table);
+        Dead_Time = table_lookup_hint(V_Batt, 1, Inj_Dead_Time_Table, &Inj_Dead_Time_Hint);
         Dead_Time = Dead_Time_Set *  (1+ (Dead_Time * Inverse100));     
         Dead_Time_etpu = (uint32_t)(Dead_Time * 1000);//etpu wants usec
          
@@ -318,7 +415,7 @@ static void Set_Fuel(void)
         
 //Injection_angle()
         // where should pulse end (injection timing)?
-         uint24_t Inj_End_Angle_eTPU =(uint24_t) (100 * (table_lookup(RPM, Reference_VE, Inj_End_Angle_Table)));//etpu needs deg * 100
+         uint24_t Inj_End_Angle_eTPU =(uint24_t) Inj_End_Angle_x100;//etpu needs deg * 100
 
 		//I'm not sure where this came from but I think it's wrong - me 7/24/2013
         //if (Inj_End_Angle_eTPU >= Drop_Dead_Angle )            // clip to 1 degree before Drop_Dead
@@ -338,21 +435,39 @@ static void Set_Fuel(void)
         // TODO - Cylinder Trim math and updates.  Issue #9 
         // TODO - Staged injection math and updates Issue #10
 
+        uint8_t const fuel_off = fs_etpu_eng_pos_get_engine_position_status() != FS_ETPU_ENG_POS_FULL_SYNC
+           || Enable_Inj == 0
+           || (RPM > Rev_Limit && (Rev_Limit_Type == 1 || Rev_Limit_Type == 3));
+
+        // on MAP load the angle events move the pulse width along the newest intake stroke
+        // MAP, it is taken as proportional to MAP.  Published ahead of the channel writes,
+        // so an update can't put a time back on a channel going off
+        if (Fuel_Events_OK && !fuel_off && Load_Sense <= 3 && MAP_Angle_OK && MAP[0] > 0) {
+            float const ticks = ((etpu_a_tcr1_freq / 10000) * etpu_Pulse_Width) / 100;     // as fs_etpu_fuel_set_injection_time()
+
+            Cyl_Update_Set(&Fuel_Update, 1, ticks, ticks / MAP[0] * Get_MAP_Slope());
+        } else
+            Cyl_Update_Set(&Fuel_Update, 0, 0, 0);
+
         // tell eTPU to use new fuel injection pulse values (same for all cylinders)
         uint32_t j;
         for (j = 0; j < N_Injectors; ++j) {
             fs_etpu_fuel_switch_on(Fuel_Channels[j]);   // Turn on fuel channels
 
             error_code = 1;
-            while (error_code != 0)     // This tries until the channel is actually updated
+            while (error_code != 0) {   // This tries until the channel is actually updated
      //look up trim values
          //need to make table use the "j" value before it will work
             //Corr = table_lookup(RPM, Reference_VE, Cyl_Trim_1_Table);
             //Cyl_Pulse_Width=  (Pulse_Width * Corr) >> 14;
-           
+                os_declare_state();
+
+                os_disable_interrupts();        // one writer at a time with the angle events
                 //error_code = fs_etpu_fuel_set_injection_time(Fuel_Channels[j], Cyl_Pulse_Width);
                 //this goes away once cyl trim is working
                 error_code = fs_etpu_fuel_set_injection_time(Fuel_Channels[j], etpu_Pulse_Width);
+                os_enable_interrupts();
+            }
 
         }                       // for
 
@@ -362,9 +477,7 @@ static void Set_Fuel(void)
         fs_etpu_fuel_set_recalc_offset_angle(Fuel_Channels[0], Fuel_Recalc_Angle_eTPU); // degrees * 100
     
    
-        if (fs_etpu_eng_pos_get_engine_position_status() != FS_ETPU_ENG_POS_FULL_SYNC 
-           || Enable_Inj == 0
-           || (RPM > Rev_Limit && (Rev_Limit_Type == 1 || Rev_Limit_Type == 3))) {
+        if (fuel_off) {
 
            int i;
            for (i = 0; i < N_Cyl; ++i) {
@@ -376,6 +489,117 @@ static void Set_Fuel(void)
          
 }                              // Set_Fuel()
 
+/***************************************************************************************/
+// Per cylinder fuel and spark on the crank angle.  A MAP burst that came in after the
+// pass gives a newer pulse width and advance for the cylinder that is next to use them.
+// The pass works out the fuel and spark and how they move with the MAP A/D count, the
+// updates only multiply the newest burst's change in count and write the eTPU.  They
+// run in the angle clock interrupt, so the pass writes the same channels with
+// interrupts off.  The pass still writes every channel, so at low rpm, where an update
+// comes long before the eTPU uses it, nothing is older than a pass.
+
+/**
+ * @brief  Register the per cylinder updates with the angle events
+ * @note   call before os_start(), after init_eTPU() has the injector and coil counts
+ */
+
+void Cyl_Events_Init(void)
+{
+    uint8_t i;
+
+    Spark_Cycle = (uint32_t)Ticks_Per_Tooth * Total_Teeth * 2;
+    Spark_End_Min = (int32_t)(((uint64_t)2000 * Spark_Cycle) / 72000) + 1;
+    Spark_End_Max = (int32_t)(((uint64_t)(72000 - 6000) * Spark_Cycle) / 72000) - 1;
+
+    // all or nothing per side, so every cylinder is fueled and fired from the same MAP.
+    // Angle_Event_Add() has pushed the error for one that didn't go in
+    if (N_Injectors > ANGLE_MAX_CYL || N_Coils > ANGLE_MAX_CYL)
+        err_push( CODE_ANGLE_TOO_MANY_CYL );    // the passes do them all
+
+    Fuel_Events_OK = N_Injectors <= ANGLE_MAX_CYL;
+    for (i = 0; i < N_Injectors && Fuel_Events_OK; ++i)
+        if (Angle_Event_Add(i, FUEL_UPDATE_BTDC, Fuel_Cyl_Update) != 0)
+            Fuel_Events_OK = 0;
+    Spark_Events_OK = N_Coils <= ANGLE_MAX_CYL;
+    for (i = 0; i < N_Coils && Spark_Events_OK; ++i)        // with waste spark, ahead of the coil's first cylinder
+        if (Angle_Event_Add(i, SPARK_UPDATE_BTDC, Spark_Cyl_Update) != 0)
+            Spark_Events_OK = 0;
+}
+
+// task side, publish one line
+
+static void Cyl_Update_Set(struct cyl_update *u, uint8_t on, float base, float slope)
+{
+    int32_t const b = (int32_t)base;
+    int32_t const k = (int32_t)(slope * 65536.0f);
+    os_declare_state();
+
+    os_disable_interrupts();
+    u->on = on;
+    u->count = MAP_Angle_Count;
+    u->base = b;
+    u->slope = k;
+    os_enable_interrupts();
+}
+
+// interrupt side, the line at the newest burst
+
+static int32_t Cyl_Update_Value(struct cyl_update const *u)
+{
+    int32_t delta;
+
+    (void)MAP_Sample_Read(&Cyl_MAP_Sample);
+    delta = (int32_t)Cyl_MAP_Sample.count - u->count;
+    if (delta > MAP_DELTA_MAX)
+        delta = MAP_DELTA_MAX;
+    else if (delta < -MAP_DELTA_MAX)
+        delta = -MAP_DELTA_MAX;
+
+    return u->base + (int32_t)(((int64_t)u->slope * delta) >> 16);
+}
+
+static void Fuel_Cyl_Update(uint8_t cyl)
+{
+    uint8_t const channel = Fuel_Channels[cyl];
+    int32_t ticks;
+
+    if (!Fuel_Update.on)
+        return;
+    ticks = Cyl_Update_Value(&Fuel_Update);
+    if (ticks < 0)
+        ticks = 0;
+
+    // as fs_etpu_fuel_set_injection_time() but in ticks.  One try, a request
+    // still pending takes the new time with it
+    fs_etpu_set_chan_local_24(channel, FS_ETPU_FUEL_INJECTION_TIME_OFFSET, (uint24_t)ticks);
+    if (eTPU->CHAN[channel].HSRR.R == 0)
+        eTPU->CHAN[channel].HSRR.R = FS_ETPU_FUEL_INJECTION_TIME_CHANGE;
+}
+
+static void Spark_Cyl_Update(uint8_t cyl)
+{
+    uint8_t const channel = Spark_Channels[cyl];
+    int32_t end_1;
+    int32_t end_2;
+
+    if (!Spark_Update.on)
+        return;
+    end_1 = Cyl_Update_Value(&Spark_Update);
+    if (end_1 < Spark_End_Min)   // the range Spark_End_Angles() takes
+        end_1 = Spark_End_Min;
+    else if (end_1 > Spark_End_Max)
+        end_1 = Spark_End_Max;
+    end_2 = end_1 + (Spark_Cycle >> 1);
+    if (end_2 >= (int32_t)Spark_Cycle)      // roll it over at 720 degrees
+        end_2 -= Spark_Cycle;
+
+    // as fs_etpu_spark_set_end_angles() but in TCR2 ticks
+    fs_etpu_set_chan_local_24(channel, FS_ETPU_SPARK_SPARK1_ANGLE_OFFSET, (uint24_t)end_1);
+    fs_etpu_set_chan_local_24(channel, FS_ETPU_SPARK_SPARK2_ANGLE_OFFSET, (uint24_t)end_2);
+    if (eTPU->CHAN[channel].HSRR.R == 0)
+        eTPU->CHAN[channel].HSRR.R = FS_ETPU_SPARK_UPDATE;
+}
+
 /***************************************************************************************/ 
 
 // read status - returns can be viewed in the debugger or sent to the tuner
@@ -383,7 +607,7 @@ static void Set_Fuel(void)
 //
 //MOVE THIS
 //
-static void Check_Engine(void)
+void Check_Engine(void)
 {
     int8_t s4;
     int8_t s5;
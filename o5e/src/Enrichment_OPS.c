@@ -35,6 +35,16 @@
    
    
    #define TPS_Dot_Dead 0.01f
+
+   // RPM and CLT lookups, each remembers its last cell
+   static struct table_hint Accel_Limit_Hint;
+   static struct table_hint Accel_Sensativity_Hint;
+   static struct table_hint Accel_Decay_Hint;
+   static struct table_hint Decel_Limit_Hint;
+   static struct table_hint Decel_Sensativity_Hint;
+   static struct table_hint Decel_Decay_Hint;
+   static struct table_hint Prime_Corr_Hint;
+   static struct table_hint Prime_Decay_Hint;
    
    //prime variables
    uint32_t Prime_Post_Start_Last = 1;
@@ -120,9 +130,9 @@ void Get_Accel_Decel_Corr(void)
           TPS_Dot_Degree = (Degree_Clock - Degree_Clock_Last);
             // check if acceleration enrich required
           if (TPS_Dot >= TPS_Dot_Dead && TPS_Dot > TPS_Dot_Last) {
-              TPS_Dot_Limit = table_lookup(RPM, 1, Accel_Limit_Table);
-              TPS_Dot_Corr = table_lookup(RPM, 1, Accel_Sensativity_Table);
-              TPS_Dot_Decay_Rate = table_lookup(RPM, 1, Accel_Decay_Table);
+              TPS_Dot_Limit = table_lookup_hint(RPM, 1, Accel_Limit_Table, &Accel_Limit_Hint);
+              TPS_Dot_Corr = table_lookup_hint(RPM, 1, Accel_Sensativity_Table, &Accel_Sensativity_Hint);
+              TPS_Dot_Decay_Rate = table_lookup_hint(RPM, 1, Accel_Decay_Table, &Accel_Decay_Hint);
               TPS_Dot_Decay_Rate = 1 + (TPS_Dot_Decay_Rate *  Inverse100);
               TPS_Dot_Corr = (TPS_Dot_Corr * (TPS_Dot - TPS_Dot_Dead));
 
@@ -133,9 +143,9 @@ void Get_Accel_Decel_Corr(void)
               TPS_Dot_Sign = 1;
                 // decel required 
           } else if (TPS_Dot <= (-TPS_Dot_Dead) && TPS_Dot < TPS_Dot_Last) {
-              TPS_Dot_Limit = table_lookup(RPM, 1, Decel_Limit_Table);
-              TPS_Dot_Corr = table_lookup(RPM, 1, Decel_Sensativity_Table);
-              TPS_Dot_Decay_Rate = table_lookup(RPM, 1, Decel_Decay_Table);
+              TPS_Dot_Limit = table_lookup_hint(RPM, 1, Decel_Limit_Table, &Decel_Limit_Hint);
+              TPS_Dot_Corr = table_lookup_hint(RPM, 1, Decel_Sensativity_Table, &Decel_Sensativity_Hint);
+              TPS_Dot_Decay_Rate = table_lookup_hint(RPM, 1, Decel_Decay_Table, &Decel_Decay_Hint);
               TPS_Dot_Decay_Rate = 1 + (TPS_Dot_Decay_Rate *  Inverse100);
               TPS_Dot_Corr = (TPS_Dot_Corr * (TPS_Dot_Dead - TPS_Dot));
               // update the last clock
@@ -174,14 +184,14 @@ void Get_Prime_Corr(void)
             // check if in prime needed conditions   
             if (Post_Start_Cycles < Prime_Cycles_Threshold) {
 
-                Prime_Corr = table_lookup(CLT, 1, Prime_Corr_Table) * Inverse100;
+                Prime_Corr = table_lookup_hint(CLT, 1, Prime_Corr_Table, &Prime_Corr_Hint) * Inverse100;
 
                 // Update Prime decay each cycle - this is a log decay of the prime pulse
                 if (Post_Start_Cycles > Prime_Post_Start_Last) {
                     // reset cycle number
                     Prime_Post_Start_Last = Post_Start_Cycles;
                     // Get the decay rate for current conditions
-                    Prime_Decay = table_lookup(RPM, 1, Prime_Decay_Table);
+                    Prime_Decay = table_lookup_hint(RPM, 1, Prime_Decay_Table, &Prime_Decay_Hint);
                     
                    Prime_Decay = 1.0f + (Prime_Decay * Inverse100);
                     // decrease decay by the new value
@@ -194,7 +194,10 @@ int32_t fs_etpu_pwm_update( uint8_t channel, uint32_t freq, uint16_t duty,
 
 	pba = fs_etpu_data_ram (channel);
 
-    /* Determine frequency of output waveform */
+    /* Determine frequency of output waveform, 0 (engine stopped) is out of
+       range too - the e200 divide gives no trap to catch it */
+	if (freq == 0)
+		return( FS_ETPU_ERROR_FREQ);
 	chan_period = timebase_freq / freq;
 
 	if ((chan_period == 0) || (chan_period > 0x007FFFFF ))
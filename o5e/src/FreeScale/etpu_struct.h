@@ -31,6 +31,10 @@ extern "C" {
 #pragma ANSI_strict off
 #endif
 
+#ifdef BSP_HOST
+#pragma scalar_storage_order big-endian /* .B fields land where .R puts them */
+#endif
+
 /****************************************************************************/
 /*                              MODULE :ETPU                                */
 /****************************************************************************/
@@ -1046,6 +1050,10 @@ extern "C" {
 
 
 
+#ifdef BSP_HOST
+#pragma scalar_storage_order default
+#endif
+
 #ifdef __MWERKS__
 #pragma pop
 #endif
@@ -0,0 +1,296 @@
+/*********************************************************************************
+
+    @file      Knock.c
+    @brief     Open5xxxECU - knock sensor band energy per cylinder, from angle windows
+    @note      www.Open5xxxECU.org
+    @version   1.0
+
+**********************************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "typedefs.h" /**< pickup vuint_xxx */
+#include "config.h"
+#include "cocoos.h"
+#include "bsp.h"
+#include "variables.h"
+#include "err.h"
+#include "etpu_util.h"
+#include "etpu_struct.h"
+#include "etpu_knock_window.h"
+#include "eTPU_OPS.h"
+#include "eQADC_OPS.h"
+#include "eDMA_OPS.h"
+#include "Angle_Events.h"
+#include "Knock.h"
+
+#define KNOCK_VECTOR   (68 + KNOCK_WINDOW_CHANNEL)     // eTPU A channel n interrupts on INTC vector 68 + n
+#define KNOCK_PRIORITY 3                // below the A/D DMA, this is the longest handler
+#define KNOCK_WINDOWS ANGLE_MAX_CYL     // Knock_Intensity[] in the tuner's output channels is this size too
+#define KNOCK_MIN_WIDTH 500             // deg*100
+#define COEFF_ONE 16384                 // Goertzel coefficient 1.0, Q14
+#define REF_SHIFT 5                     // background average over 32 windows per cylinder
+#define ENERGY_MAX (0xffffffff >> (REF_SHIFT + 1))     // keeps Ref_x32 and twice the background in 32 bits
+
+static uint8_t N_Windows;               // 0 if the channel didn't start
+static uint8_t Window_Cyl[KNOCK_WINDOWS];       // cylinder per window, windows in TDC order
+static uint32_t Window_Open[KNOCK_WINDOWS];     // deg*100
+static uint32_t Close_Tick[KNOCK_WINDOWS];      // TCR2 at each window closing, for the interrupt
+static uint32_t Cycle_Ticks;            // TCR2 ticks per 720 degrees
+static uint32_t Width_x100;             // window width the eTPU has
+static uint32_t Knock_Generation;       // Page_Generation Knock_Update() last looked at
+
+static volatile int32_t Coeff;          // 2cos(2 pi Knock_Freq / ADC_Q3_RATE), Q14, 0 = off
+static float Coeff_Freq;                // Knock_Freq Coeff is for
+
+static uint8_t Buf_Cur;                 // ADC_Q3_Buf half the DMA is filling
+static uint32_t Ref_x32[KNOCK_WINDOWS];         // background band energy per cylinder, << REF_SHIFT
+
+static void Knock_ISR(void);
+static uint32_t Band_Energy(const uint16_t *x, uint16_t n, int32_t coeff);
+static uint32_t Setup_Windows(uint32_t * const open, uint8_t * const cyl, uint32_t * const cycle);
+static void Set_Windows(const uint32_t * const open, const uint8_t * const cyl, const uint32_t width, const uint32_t cycle);
+static void Set_Coeff(void);
+
+/**
+ * @brief  Start the knock window channel, one window per cylinder, and hook up its interrupt
+ * @note   call from init_eTPU() after the engine position channels, the
+ *         window angles come from the cam channel's ticks per cycle
+ */
+
+void Knock_Init(void)
+{
+    static uint32_t Window_Table[KNOCK_WINDOWS * 2];   // open, width pairs in degrees*100
+    uint32_t open[KNOCK_WINDOWS], width, cycle;
+    uint8_t cyl[KNOCK_WINDOWS];
+    uint8_t i, n;
+
+    n = N_Cyl;
+    if (n > KNOCK_WINDOWS) {
+        err_push( CODE_ANGLE_TOO_MANY_CYL );    // the rest go unwatched
+        n = KNOCK_WINDOWS;
+    }
+    N_Windows = n == 0 ? 1 : n;
+    Knock_Generation = Page_Generation;
+    width = Setup_Windows(open, cyl, &cycle);
+    Set_Windows(open, cyl, width, cycle);
+    Set_Coeff();
+
+    for (i = 0; i < N_Windows; ++i) {
+        Window_Table[i * 2] = Window_Open[i];
+        Window_Table[i * 2 + 1] = Width_x100;
+    }
+
+    // the window output gates CFIFO3 (SIU.ETISR TSEL3), the closing edge interrupts
+    if (fs_etpu_knock_window_init(KNOCK_WINDOW_CHANNEL,
+                                  FS_ETPU_PRIORITY_LOW,
+                                  N_Windows,
+                                  FS_ETPU_KNOCK_FM0_RISING_EDGE,
+                                  FS_ETPU_KNOCK_FM1_INT_CLOSE,
+                                  1,                           // CAM in engine: A; channel: 1
+                                  Window_Table) != 0) {
+        err_push( CODE_KNOCK_WINDOW_INIT );
+        N_Windows = 0;
+        return;
+    }
+
+    (void)bsp_vector_install(KNOCK_VECTOR, Knock_ISR);
+    bsp_vector_set_pri(KNOCK_VECTOR, KNOCK_PRIORITY);
+    fs_etpu_clear_chan_interrupt_flag(KNOCK_WINDOW_CHANNEL);
+    fs_etpu_interrupt_enable(KNOCK_WINDOW_CHANNEL);
+}
+
+/**
+ * @brief  Follow calibration changes
+ * @note   task context.  Most tuner writes are to other constants, so the
+ *         eTPU windows are only touched when their angles really moved
+ */
+
+void Knock_Update(void)
+{
+    uint32_t open[KNOCK_WINDOWS], width, cycle;
+    uint8_t cyl[KNOCK_WINDOWS];
+    uint8_t i;
+
+    if (N_Windows == 0 || Knock_Generation == Page_Generation)
+        return;
+    Knock_Generation = Page_Generation;
+
+    if (Knock_Freq != Coeff_Freq)       // blank flash (NaN) never matches, that only redoes it
+        Set_Coeff();
+
+    width = Setup_Windows(open, cyl, &cycle);
+    if (width == Width_x100 && cycle == Cycle_Ticks
+        && memcmp(open, Window_Open, N_Windows * sizeof(open[0])) == 0
+        && memcmp(cyl, Window_Cyl, N_Windows * sizeof(cyl[0])) == 0)
+        return;
+    Set_Windows(open, cyl, width, cycle);
+
+    // the eTPU takes each new window at its next opening, window numbers count from 0
+    for (i = 0; i < N_Windows; ++i)
+        (void)fs_etpu_knock_window_update(KNOCK_WINDOW_CHANNEL, 1, i, Window_Open[i], Width_x100);
+}
+
+/* Goertzel coefficient for Knock_Freq.  The sample rate is fixed by the A/D
+   clock and the knock conversion's sample time, see ADC_Q3_RATE */
+
+static void Set_Coeff(void)
+{
+    float f;
+
+    Coeff_Freq = Knock_Freq;
+    f = Knock_Freq / ADC_Q3_RATE;
+    if (!(f >= 0.05f && f <= 0.45f)) {  // also catches blank flash (NaN), and a band the rate can't see
+        Coeff = 0;
+        return;
+    }
+    Coeff = (int32_t)(2.0f * COEFF_ONE * cosf(2.0f * 3.14159265f * f));
+    if (Coeff == 0)
+        Coeff = 1;                      // a quarter of the sample rate, 0 means off
+}
+
+/* Window closed.  Hand the DMA the other buffer first, the next window can open
+   before the energy is worked out */
+
+static void Knock_ISR(void)
+{
+    uint32_t tcr2, since, best, e, ref;
+    uint64_t intensity;
+    uint16_t n;
+    uint8_t i, w, cyl, buf;
+    int32_t coeff;
+
+    fs_etpu_clear_chan_interrupt_flag(KNOCK_WINDOW_CHANNEL);
+
+    buf = Buf_Cur;
+    n = ADC_Q3_DMA_Count(buf);
+    Buf_Cur ^= 1;
+    ADC_Q3_DMA_Start(Buf_Cur);
+
+    // the window that closed most recently
+    tcr2 = angle_clock() & 0xffffff;
+    best = 0xffffffff;
+    w = 0;
+    for (i = 0; i < N_Windows; ++i) {
+        since = tcr2 >= Close_Tick[i] ? tcr2 - Close_Tick[i] : tcr2 + Cycle_Ticks - Close_Tick[i];
+        if (since < best) {
+            best = since;
+            w = i;
+        }
+    }
+    cyl = Window_Cyl[w];
+
+    coeff = Coeff;
+    if (coeff == 0 || n < 8)
+        return;
+
+    // DMA is done with this half, it is writing the other one
+    e = Band_Energy((const uint16_t *)&ADC_Q3_Buf[buf][0], n, coeff);
+    if (e > ENERGY_MAX)
+        e = ENERGY_MAX;
+
+    // normal cycles set the background, a knock counts as at most twice it
+    ref = Ref_x32[cyl] >> REF_SHIFT;
+    if (ref == 0) {
+        Ref_x32[cyl] = e << REF_SHIFT;
+        ref = e;
+    } else {
+        Ref_x32[cyl] += (e > ref * 2 ? ref * 2 : e) - ref;
+    }
+    if (ref == 0)
+        ref = 1;
+
+    intensity = (uint64_t)e * KNOCK_INTENSITY_SCALE / ref;
+    Knock_Intensity[cyl] = intensity > 0xffff ? 0xffff : (uint16_t)intensity;
+}
+
+/* One Goertzel bin over n samples, mean removed.  The samples are 14 bit so
+   the state stays inside 32 bits for ADC_Q3_SIZE samples, only the coefficient
+   product needs 64.  Returns the bin power over n^2, about amplitude^2 / 4
+   for a tone in the band */
+
+static uint32_t Band_Energy(const uint16_t *x, uint16_t n, int32_t coeff)
+{
+    int32_t s0, s1, s2, mean;
+    uint32_t sum;
+    uint64_t p;
+    uint16_t i;
+
+    sum = 0;
+    for (i = 0; i < n; ++i)
+        sum += x[i];
+    mean = (int32_t)((sum + n / 2) / n);
+
+    s1 = s2 = 0;
+    for (i = 0; i < n; ++i) {
+        s0 = (int32_t)x[i] - mean + (int32_t)(((int64_t)coeff * s1) >> 14) - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+
+    // s1^2 + s2^2 - coeff s1 s2, never negative apart from rounding
+    p = (uint64_t)((int64_t)s1 * s1 + (int64_t)s2 * s2);
+    p -= (uint64_t)((((int64_t)s1 * s2) >> 14) * coeff);
+    if ((int64_t)p < 0)
+        p = 0;
+    return (uint32_t)(p / ((uint32_t)n * n));
+}
+
+/* Window angles from the calibration, windows in TDC order.  The width is held
+   short of the spacing between cylinders so each window closes before the next
+   opens.  Returns the width, the cycle's TCR2 ticks go in *cycle */
+
+static uint32_t Setup_Windows(uint32_t * const open, uint8_t * const cyl, uint32_t * const cycle)
+{
+    uint8_t i, j;
+    int32_t tdc, start, width, limit;
+    float a;
+
+    *cycle = (uint32_t)Ticks_Per_Tooth * Total_Teeth * 2;
+
+    a = Knock_Window_Open;
+    if (!(a >= 0.0f))                   // also catches blank flash (NaN)
+        a = 0.0f;
+    if (a > 719.99f)
+        a = 719.99f;
+    start = (int32_t)(a * 100.0f + 0.5f);
+
+    limit = 72000 / N_Windows - 100;
+    a = Knock_Window_Width;
+    width = a > 0.0f && a < 720.0f ? (int32_t)(a * 100.0f + 0.5f) : KNOCK_MIN_WIDTH;
+    width = width < KNOCK_MIN_WIDTH ? KNOCK_MIN_WIDTH : width > limit ? limit : width;
+
+    for (i = 0; i < N_Windows; ++i) {
+        tdc = (Angle_Cyl_TDC(i) + start) % 72000;
+
+        // insertion sort, a handful of entries
+        for (j = i; j > 0 && (int32_t)open[j - 1] > tdc; --j) {
+            open[j] = open[j - 1];
+            cyl[j] = cyl[j - 1];
+        }
+        open[j] = (uint32_t)tdc;
+        cyl[j] = i;
+    }
+
+    return (uint32_t)width;
+}
+
+/* Hand the interrupt a new set of windows, it reads the order and angles so
+   they change together */
+
+static void Set_Windows(const uint32_t * const open, const uint8_t * const cyl, const uint32_t width, const uint32_t cycle)
+{
+    uint8_t i;
+    os_declare_state();
+
+    os_disable_interrupts();
+    Width_x100 = width;
+    Cycle_Ticks = cycle;
+    for (i = 0; i < N_Windows; ++i) {
+        Window_Open[i] = open[i];
+        Window_Cyl[i] = cyl[i];
+        Close_Tick[i] = (uint32_t)(((uint64_t)((open[i] + width) % 72000) * cycle) / 72000);
+    }
+    os_enable_interrupts();
+}
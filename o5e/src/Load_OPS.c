@@ -23,19 +23,21 @@
 #include "Variable_OPS.h"
 
 float gram_flow;
+static struct table_hint TPS_Flow_Hint;   // last cell used in TPS_Flow_Table
   
 void Get_Reference_VE(void)
 {  
      
   if (Load_Sense <= 3){
-      Reference_VE = MAP[1];//  using MAP 2 until angle reading fixed on MAP1 (MAP[0])
+      // newest intake stroke MAP, MAP 2 from the Q0 scan until the MAP windows are running
+      Reference_VE = MAP_Angle_OK ? MAP[0] : MAP[1];
       // Air temperature correction.
       Reference_VE = Reference_VE  * Ref_IAT;	
   }else if (Load_Sense == 4){
       Reference_VE = TPS * Ref_Baro;
       //correct for TPS flow if used.
       if (TPS_Flow_Cal_On == 1){
-	  Reference_VE = Reference_VE  * table_lookup(RPM, TPS, TPS_Flow_Table);
+	  Reference_VE = Reference_VE  * table_lookup_hint(RPM, TPS, TPS_Flow_Table, &TPS_Flow_Hint);
       }//if
       //Air temperature correction.
       Reference_VE = Reference_VE  * Ref_IAT;	
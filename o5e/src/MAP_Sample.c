@@ -0,0 +1,223 @@
+/*********************************************************************************
+
+    @file      MAP_Sample.c
+    @brief     Open5xxxECU - angle triggered MAP bursts, averaged per cylinder event
+    @note      www.Open5xxxECU.org
+    @version   1.0
+
+**********************************************************************************/
+
+#include <stdint.h>
+#include "typedefs.h" /**< pickup vuint_xxx */
+#include "config.h"
+#include "cocoos.h"
+#include "bsp.h"
+#include "variables.h"
+#include "err.h"
+#include "etpu_util.h"
+#include "etpu_struct.h"
+#include "etpu_knock_window.h"
+#include "eTPU_OPS.h"
+#include "eQADC_OPS.h"
+#include "Table_Lookup.h"
+#include "Angle_Events.h"
+#include "MAP_Sample.h"
+
+#define MAP_WINDOWS ANGLE_MAX_CYL
+#define MAP_ANGLE_DEADBAND 25           // deg*100 the table has to move before the windows are rewritten
+
+volatile uint16_t MAP_Cyl_Count[MAP_WINDOWS];
+
+static uint8_t N_Windows;               // 0 if the channel didn't start
+static uint8_t Window_Cyl[MAP_WINDOWS]; // cylinder per window, windows in TDC order
+static int32_t TDC_x100[MAP_WINDOWS];   // each window's cylinder TDC in the engine cycle, deg*100
+static uint32_t Open_Tick[MAP_WINDOWS]; // TCR2 at each window opening, for the interrupt
+static uint32_t Cycle_Ticks;            // TCR2 ticks per 720 degrees
+static int32_t Angle_x100;              // MAP_Angle_Table value the windows are at
+static uint32_t Window_Generation;      // Page_Generation TDC_x100 came from
+static struct table_hint MAP_Angle_Hint;
+
+static struct map_sample Sample_Out[2]; // newest burst and the one being filled
+static volatile uint8_t Sample_Cur;     // Sample_Out[] holding the newest burst
+static volatile uint32_t Sample_Seq;    // bursts completed, bumped after Sample_Cur is set
+
+static void Setup_Windows(void);
+static int32_t Get_Angle(void);
+static uint32_t Window_Open(uint8_t w);
+
+/**
+ * @brief  Start the MAP window channel, one window per cylinder
+ * @note   call from init_eTPU() after the engine position channels, the
+ *         window angles come from the cam channel's ticks per cycle
+ */
+
+void MAP_Sample_Init(void)
+{
+    static uint32_t Window_Table[MAP_WINDOWS * 2];     // open, width pairs in degrees*100
+    uint8_t i, n;
+
+    n = N_Cyl;
+    if (n > MAP_WINDOWS) {
+        err_push( CODE_ANGLE_TOO_MANY_CYL );    // no MAP burst for the rest, they get the newest of the others
+        n = MAP_WINDOWS;
+    }
+    N_Windows = n == 0 ? 1 : n;
+    Setup_Windows();
+    Angle_x100 = Get_Angle();
+
+    for (i = 0; i < N_Windows; ++i) {
+        Window_Table[i * 2] = Window_Open(i);
+        Window_Table[i * 2 + 1] = MAP_WINDOW_WIDTH;
+        Open_Tick[i] = (uint32_t)(((uint64_t)Window_Table[i * 2] * Cycle_Ticks) / 72000);
+    }
+
+    // the window output triggers CFIFO5 (SIU.ETISR TSEL5).  The function always
+    // flags the channel interrupt, FM1 only picks which edge, there is no off
+    // setting.  Its interrupt enable is left clear so the CPU never sees it
+    if (fs_etpu_knock_window_init(MAP_WINDOW_CHANNEL,
+                                  FS_ETPU_PRIORITY_LOW,
+                                  N_Windows,
+                                  FS_ETPU_KNOCK_FM0_RISING_EDGE,
+                                  FS_ETPU_KNOCK_FM1_INT_OPEN,
+                                  1,                           // CAM in engine: A; channel: 1
+                                  Window_Table) != 0) {
+        err_push( CODE_MAP_WINDOW_INIT );
+        N_Windows = 0;
+    }
+}
+
+/**
+ * @brief  Move the windows when MAP_Angle_Table(RPM) or the calibration changes
+ * @note   task context, call after RPM is updated
+ */
+
+void MAP_Sample_Update(void)
+{
+    uint32_t open[MAP_WINDOWS];
+    int32_t angle, d;
+    uint8_t i;
+    os_declare_state();
+
+    if (N_Windows == 0)
+        return;
+
+    angle = Get_Angle();
+    d = angle - Angle_x100;
+    if (Window_Generation == Page_Generation && d < MAP_ANGLE_DEADBAND && d > -MAP_ANGLE_DEADBAND)
+        return;
+
+    // the interrupt reads the window order and angles, change them together
+    os_disable_interrupts();
+    if (Window_Generation != Page_Generation)
+        Setup_Windows();
+    Angle_x100 = angle;
+    for (i = 0; i < N_Windows; ++i) {
+        open[i] = Window_Open(i);
+        Open_Tick[i] = (uint32_t)(((uint64_t)open[i] * Cycle_Ticks) / 72000);
+    }
+    os_enable_interrupts();
+
+    // the eTPU takes each new window at its next opening, window numbers count from 0
+    for (i = 0; i < N_Windows; ++i)
+        (void)fs_etpu_knock_window_update(MAP_WINDOW_CHANNEL, 1, i, open[i], MAP_WINDOW_WIDTH);
+}
+
+/**
+ * @brief  Average and publish a MAP burst, called from the RFIFO5 DMA interrupt
+ * @param  buf  the half of ADC_Q5_Buf the DMA just finished, it is now
+ *              writing the other one
+ */
+
+void MAP_Burst_Done(uint8_t buf)
+{
+    struct map_sample *const sample = &Sample_Out[Sample_Cur ^ 1];
+    uint32_t sum, tcr2, since, best;
+    uint8_t i, w;
+
+    sum = 0;
+    for (i = 0; i < ADC_Q5_SIZE; ++i)
+        sum += ADC_Q5_Buf[buf][i];
+
+    // the burst belongs to the window that opened most recently
+    tcr2 = angle_clock() & 0xffffff;
+    best = 0xffffffff;
+    w = 0;
+    for (i = 0; i < N_Windows; ++i) {
+        since = tcr2 >= Open_Tick[i] ? tcr2 - Open_Tick[i] : tcr2 + Cycle_Ticks - Open_Tick[i];
+        if (since < best) {
+            best = since;
+            w = i;
+        }
+    }
+
+    sample->count = (uint16_t)((sum + ADC_Q5_SIZE / 2) / ADC_Q5_SIZE);
+    sample->cyl = Window_Cyl[w];
+    sample->time = systime;
+    sample->seq = Sample_Seq + 1;
+    MAP_Cyl_Count[sample->cyl] = sample->count;
+
+    Sample_Cur ^= 1;
+    Sample_Seq = sample->seq;
+}
+
+/**
+ * @brief  Copy the newest MAP burst average
+ * @return 1 if it is a newer burst than the one already in *sample
+ * @note   same retry as ADC_Scan_Read(), a burst is far longer than the copy
+ */
+
+uint8_t MAP_Sample_Read(struct map_sample *sample)
+{
+    uint32_t const prev = sample->seq;
+    uint32_t seq;
+
+    do {
+        seq = Sample_Seq;
+        *sample = Sample_Out[Sample_Cur];
+    } while (seq != Sample_Seq || seq != sample->seq);
+
+    return seq != prev;
+}
+
+/* Cylinder TDCs from the calibration, and the windows put in TDC order.  Moving every window by the same angle keeps that order,
+   which is the order the eTPU opens them in */
+
+static void Setup_Windows(void)
+{
+    uint8_t i, j;
+    int32_t tdc;
+
+    Window_Generation = Page_Generation;
+    Cycle_Ticks = (uint32_t)Ticks_Per_Tooth * Total_Teeth * 2;
+
+    for (i = 0; i < N_Windows; ++i) {
+        tdc = Angle_Cyl_TDC(i);
+
+        // insertion sort, a handful of entries
+        for (j = i; j > 0 && TDC_x100[j - 1] > tdc; --j) {
+            TDC_x100[j] = TDC_x100[j - 1];
+            Window_Cyl[j] = Window_Cyl[j - 1];
+        }
+        TDC_x100[j] = tdc;
+        Window_Cyl[j] = i;
+    }
+}
+
+// MAP_Angle_Table(RPM) in deg*100, 0-71999
+
+static int32_t Get_Angle(void)
+{
+    float a;
+
+    a = table_lookup_hint(RPM, 1, MAP_Angle_Table, &MAP_Angle_Hint);
+    if (!(a >= 0.0f))                   // also catches blank flash (NaN)
+        a = 0.0f;
+    if (a > 719.99f)
+        a = 719.99f;
+    return (int32_t)(a * 100.0f + 0.5f);
+}
+
+static uint32_t Window_Open(uint8_t w)
+{
+    return (uint32_t)((TDC_x100[w] + Angle_x100) % 72000);
+}
@@ -101,7 +101,7 @@ void init_SIU(void)
         SIU.PCR[140].R = GPIO  | UNUSED; 	// eTPU[26] pin available, eTPU26 used for MAP window internal
         SIU.PCR[141].R = B0001 | OUTPUT; 	// eTPU[27] Stepper PWM signal  Fuel Pump & etpu channel
         SIU.PCR[142].R = GPIO  | UNUSED; 	// eTPU[28] pin available, & Knock window internal
-        SIU.PCR[143].R = B0001 | OUTPUT; 	// eTPU[29] PWM_Pad &  
+        SIU.PCR[143].R = GPIO  | UNUSED; 	// eTPU[29] pin available, eTPU29 used for angle clock windows internal
         SIU.PCR[144].R = B0011 | OUTPUT;    // eTPU[30] toothgen simulator, eTPU30 hardwired to eTPU1 
         SIU.PCR[145].R = B0011 | OUTPUT;    // eTPU[31] toothgen simulator, eTPU31 hardwired to eTPU0
 
@@ -13,11 +13,29 @@
 
 @brief		updated to support variable length floating point 1D or 2D tables only
 
+@brief		table_lookup_hint() remembers the last cell per call site, RPM and load rarely
+			move more than a cell between passes so most lookups skip the binary search
+
+@brief		split into table_locate() (find cell + ratios) and table_interp() so tables that
+			share axes can be looked up with one search, see table_lookup_group()
+
+@brief		evenly spaced axes are detected when the tables change and their cell is found
+			with one multiply (min and 1/spacing kept in the hint), no search or divide
+
+@brief		1/width of every axis cell is kept in the hint too, so interpolating never divides
+
+@brief		table_lookup_q() - fixed point copy of a table for the integer eTPU paths
+
+@brief		table_lookup_3d() - 3D tables with trilinear interpolation
+
+@brief		table_lookup_array() - many points at once for offline replay, same results as table_lookup()
+
 @note Generic, portable 1D or 2D table lookup
 Table entries are float (32 bit single precision IEEE 754)
 Uses a binary search for the variable axis increments (faster)
 Logs errors if desired
-Does range and error checks.  Error codes changed to negative numbers.
+Range and axis checks are done once by table_check() when a page changes, not on every lookup
+(define PARANOIA to put them back in the lookup).
 ISO C90 compatible (yuck, check with "gcc -Wall -pedantic -Wextra")
 
 To use this, you need to fill out a table structure and then pass the lookup 
@@ -33,7 +51,9 @@ stay the same as you go down (rows) or to the right (cols).
    Copyright (c) 2013 Mark Eberhardt				*/
 
 #include <stdint.h>
+#include <string.h>
 #include "Table_Lookup.h"
+#include "variables.h"
 #include "err.h"
 
 #ifndef FALSE
@@ -43,7 +63,10 @@ stay the same as you go down (rows) or to the right (cols).
 
 
 /* generic binary search for a int8_t array */
-/* does not do bounds checking */
+/* does not do bounds checking, value must be strictly inside the array */
+/* returns the cell holding value, array[i] <= value < array[i + 1], so a value
+   on a duplicate axis value always gets the last of the duplicates - the same
+   cell hint_search(), q_axis_locate() and lut_point() pick */
 
 static inline uint8_t bsearch(const float value, const float * const array, uint8_t n)
 {
@@ -61,17 +84,36 @@ static inline uint8_t bsearch(const float value, const float * const array, uint
 		if (middle == lower)
 			break;       	/* done */
 
-		if (array[middle] < value)
+		if (array[middle] <= value)
 			lower = middle;
-		else if (array[middle] > value)
+		else
 			upper = middle;
-		else				/* equal */
-			break;				/* done */
 	}
-	return middle;     
+	return lower;     
 
 } // bsearch()
 
+/* find the axis cell holding value, trying the cell used last time (and its neighbours)
+   before falling back to a binary search.  Value must be strictly inside the axis. */
+
+static inline uint8_t hint_search(const float value, const float * const array, const uint8_t n, uint8_t * const hint)
+{
+	uint8_t i = *hint;
+
+	if (i < n - 1) {
+		if (array[i] <= value) {
+			if (value < array[i + 1])					/* same cell as last time */
+				return i;
+			if (i + 2 < n && value < array[i + 2])		/* moved up one cell */
+				return *hint = i + 1;
+		} else if (i > 0 && array[i - 1] <= value)		/* moved down one cell */
+			return *hint = i - 1;
+	}
+
+	return *hint = bsearch(value, array, n);			/* big jump, search for it */
+
+} // hint_search()
+
 /* Linear interpolation between two points on a line. */
 inline static float interpolate(const float fraction, const float value1, const float value2)
 {
@@ -85,161 +127,765 @@ inline static float interpolate(const float fraction, const float value1, const
 }
 
 
+/* rows and cols the lookups can index without running off the table */
+static inline uint8_t table_size_ok(const struct table * const table)
+{
+	return table != 0 && table->rows >= 1 && table->cols >= 2 && table->rows <= MAX_ROWS && table->cols <= MAX_COLS;
+}
+
+/************************************************************************
+
+@param pointer to table structure
+@return CODE_NONE if the table is usable, otherwise the error code
+
+Checks the size and axis sorting.  The lookups no longer do this, so
+call it whenever a table's contents change (see Page_Changed()).
+
+************************************************************************/
+
+uint32_t table_check(const struct table * const table)
+{
+	uint8_t i;
+
+	/* check for sane values */
+	if (!table_size_ok(table))
+		return CODE_OLDJUNK_FC;
+
+	/* check for proper x axis sorting (must be ascending) */
+	for (i = 1; i < table->cols; ++i) {
+		if (table->col_axis[i] < table->col_axis[i - 1])
+			return CODE_OLDJUNK_FB;
+	}
+	/* check for proper y axis sorting (must be ascending) */
+	for (i = 1; i < table->rows; ++i) {
+		if (table->row_axis[i] < table->row_axis[i - 1])
+			return CODE_OLDJUNK_FA;
+	}
+	return CODE_NONE;
+
+} // table_check()
+
 /************************************************************************
 
 @param x value
 @param y value (optional)
 @param pointer to table structure
-@return lookup value from table
+@return lookup value from table, 255 if the table has a bad size
 
 ************************************************************************/
 
-
 float table_lookup(const float col_value, const float row_value, const struct table * const table)
-{	
-	uint8_t col_index;
-	uint8_t row_index; 
-	float value1;
-	float value2;
-	float value3;
-	float value4;
-	float ratio;
-	uint8_t i;
-	float *ptr;
+{
+	/* a one-off hint that is already current with nothing worked out, so the setup is skipped
+	   and the lookup binary searches and divides like it always did - the evenly spaced axis
+	   and 1/width shortcuts are only for a hint that lasts, use table_lookup_hint() for those */
+	struct table_hint hint;
+
+	hint.col.index = hint.row.index = 0;
+	hint.col.inv_step = hint.row.inv_step = 0;
+	hint.col.widths = hint.row.widths = 0;
+	hint.table = table;
+	hint.generation = Page_Generation;
+	hint.valid = table_size_ok(table);
+
+	return table_lookup_hint(col_value, row_value, table, &hint);
+}
+
+/************************************************************************
+
+@param x value
+@param y value (optional)
+@param pointer to table structure
+@param pointer to the caller's hint, updated with the cell found
+@return lookup value from table, 255 if the table has a bad size
 
+A bad size (ie. a tuner write that failed Page_Changed()) is caught by
+the hint setup, so the lookup never runs off the table.
+
+************************************************************************/
 
-	/* for readability */
-#define rows (table->rows)
-#define cols (table->cols)
+float table_lookup_hint(const float col_value, const float row_value, const struct table * const table, struct table_hint * const hint)
+{	
+	struct table_pos pos;
 
-#define PARANOIA
 #ifdef PARANOIA
+	if (table_check(table) != CODE_NONE)
+		return 255;
+#endif
 
-	/* check for sane values */
-	if (table == 0 || rows < 1 || cols < 2 || rows > MAX_ROWS || cols > MAX_COLS) {     /* error check */
+	table_locate(col_value, row_value, table, hint, &pos);
+	if (!hint->valid) {
 		err_push( CODE_OLDJUNK_FC );
 		return 255;
 	}
-	/* check for proper x axis sorting (must be ascending) */
-	for (i = 1; i < cols; ++i) {
-		if (table->col_axis[i] < table->col_axis[i - 1]) {
-			err_push( CODE_OLDJUNK_FB );
-			return 15123;
-		}
+	return table_interp(table, &pos);
+
+} /* table_lookup_hint() */
+
+/* work out 1/width of every cell so the ratio is a multiply instead of a divide, and if the
+   axis is evenly spaced (within float rounding) remember where it starts and 1/spacing so the
+   cell can be found with a multiply instead of a search */
+
+#define UNIFORM_TOLERANCE 1.0e-5f
+
+static void axis_setup(const float * const axis, const uint8_t n, struct axis_hint * const hint)
+{
+	float step;
+	float diff;
+	uint8_t i;
+
+	hint->min = axis[0];
+	hint->inv_step = 0;					/* assume variable spacing */
+
+	for (i = 0; i + 1 < n; ++i) {
+		diff = axis[i + 1] - axis[i];
+		hint->inv_width[i] = (diff == 0) ? 0 : 1.0f / diff;	/* duplicate axis value, don't interpolate */
 	}
-	/* check for proper y axis sorting (must be ascending) */
-	for (i = 1; i < rows; ++i) {
-		if (table->row_axis[i] < table->row_axis[i - 1]) {
-			err_push( CODE_OLDJUNK_FA );
-			return 16123;
-		}
+	hint->widths = 1;
+
+	if (n < 3)							/* nothing to search anyway */
+		return;
+
+	step = (axis[n - 1] - axis[0]) / (float)(n - 1);
+	if (step <= 0)
+		return;
+
+	for (i = 1; i < n; ++i) {
+		diff = (axis[i] - axis[i - 1]) - step;
+		if (diff > step * UNIFORM_TOLERANCE || diff < -step * UNIFORM_TOLERANCE)
+			return;
 	}
-#endif
+	hint->inv_step = 1.0f / step;
 
-	/* find  indexes that point into the table */
-	// check for within table
-	
-	if (row_value <= table->row_axis[0])            			/* < first */ 
-		row_index = 0; 
-	else if (row_value >= table->row_axis[rows-1])   /* > last */ 
-		row_index = rows - 1;
-	else   /* In the table somewhere...  */
-		row_index = bsearch(row_value, table->row_axis, rows);	/* Find the closest row_value index in the table*/
-
-	/* do col_value axis if this is a 2D lookup */
-	if ( col_value <= table->col_axis[0])						/* < first value */
-		col_index = 0;
-	else if ( col_value >= table->col_axis[cols-1])		/* > last value */
-		col_index = cols - 1;
-	else
-		col_index = bsearch(col_value, table->col_axis, cols);
+} // axis_setup()
 
-	/* Is this a 1D table? (1 col only) */
-	if ( rows == 1 )  /* 1D only, so we only interpolate along the single row */
-	{
-		if ( col_value == table->col_axis[col_index] || col_index == cols - 1 ) /* No need to interpolate */
-		{
-			/* Calculate the correct pointer location for our data point */
-            ptr = (float *) table->data + col_index ;
-            return value(ptr);
-			 
+/* find the cell holding value on one axis and how far across it value is (0 = on the cell, no interpolation) */
+
+static inline float axis_locate(const float value, const float * const axis, const uint8_t n, struct axis_hint * const hint, uint8_t * const index)
+{
+	uint8_t i;
+	float width;
+
+	if (n == 1 || value <= axis[0]) {				/* 1D or < first */
+		*index = hint->index = 0;
+		return 0;
+	}
+	if (value >= axis[n - 1]) {						/* > last */
+		*index = n - 1;
+		hint->index = n - 2;
+		return 0;
+	}
+
+	/* In the table somewhere...  */
+	if (hint->inv_step != 0) {						/* evenly spaced, compute the cell */
+		i = (uint8_t)((value - hint->min) * hint->inv_step);
+		if (i > n - 2)
+			i = n - 2;
+		/* rounding can put us one cell off right at a boundary */
+		if (value < axis[i])
+			--i;
+		else if (value >= axis[i + 1] && i < n - 2)
+			++i;
+		*index = hint->index = i;
+		return (value - axis[i]) * hint->inv_width[i];
+	}
+
+	*index = i = hint_search(value, axis, n, &hint->index);
+	if (hint->widths)								/* precomputed, no divide */
+		return (value - axis[i]) * hint->inv_width[i];
+	width = axis[i + 1] - axis[i];
+	if (width == 0)									/* duplicate axis value */
+		return 0;
+	return (value - axis[i]) / width;
+
+} // axis_locate()
+
+/************************************************************************
+
+@param x value
+@param y value (optional)
+@param pointer to table structure
+@param pointer to the caller's hint, updated with the cell found
+@param where to put the cell and ratios found
+
+Finds the cell and interpolation ratios for a pair of axis values.
+The result can be fed to table_interp() for any table with the same axes.
+A table with a bad size clears hint->valid and gives the first cell.
+
+************************************************************************/
+
+void table_locate(const float col_value, const float row_value, const struct table * const table, struct table_hint * const hint, struct table_pos * const pos)
+{
+	/* first use of this hint, a different table or the tables changed - redo the axis setup */
+	if (hint->generation != Page_Generation || hint->table != table) {
+		hint->valid = table_size_ok(table);
+		if (hint->valid) {
+			axis_setup(table->col_axis, table->cols, &hint->col);
+			axis_setup(table->row_axis, table->rows, &hint->row);
 		}
-		else
-		{
-			ratio = (col_value - table->col_axis[col_index])/(table->col_axis[col_index + 1] - table->col_axis[col_index]);
-			ptr = (float *) (unsigned int)( table->data + col_index );
-			value1 = value(ptr);
-			ptr = (float *) (unsigned int)( table->data + col_index + 1);
-			value2 = value(ptr);
-			return interpolate(ratio, value1, value2);
+		hint->table = table;
+		hint->generation = Page_Generation;
+	}
+
+	if (!hint->valid) {
+		pos->row_index = pos->col_index = 0;
+		pos->row_ratio = pos->col_ratio = 0;
+		return;
+	}
+
+	pos->row_ratio = axis_locate(row_value, table->row_axis, table->rows, &hint->row, &pos->row_index);
+	pos->col_ratio = axis_locate(col_value, table->col_axis, table->cols, &hint->col, &pos->col_index);
+
+} /* table_locate() */
+
+/* Interpolate between the four cells from ptr (2D) using bilinear method.
+   A ratio of 0 means that axis is not interpolated, so edges and 1D tables
+   never touch the cell past the end. */
+
+static inline float cell_interp(const float * const ptr, const uint8_t cols, const float col_ratio, const float row_ratio)
+{
+	float value3;
+	float value4;
+
+	if (row_ratio == 0) {
+		if (col_ratio == 0)
+			return ptr[0];
+		return interpolate(col_ratio, ptr[0], ptr[1]);
+	}
+
+	value3 = interpolate(row_ratio, ptr[0], ptr[cols]);
+	if (col_ratio == 0)
+		return value3;
+	value4 = interpolate(row_ratio, ptr[1], ptr[cols + 1]);
+
+	return interpolate(col_ratio, value3, value4);
+}
+
+/************************************************************************
+
+@param pointer to table structure
+@param cell and ratios from table_locate()
+@return interpolated value from table
+
+************************************************************************/
+
+float table_interp(const struct table * const table, const struct table_pos * const pos)
+{
+	/* Calculate the correct pointer location for our data point */
+	return cell_interp(table->data + ((table->cols * pos->row_index) + pos->col_index), table->cols, pos->col_ratio, pos->row_ratio);
+
+} /* table_interp() */
+
+/************************************************************************
+
+@param array of n x values
+@param array of n y values (0 for a 1D table)
+@param where to put the n results
+@param number of values
+@param pointer to table structure
+
+Looks up a whole array of points, ie. replaying a datalog against a new
+calibration.  Gives exactly the same results as calling table_lookup()
+on each point (same search result, same divide) but works in blocks:
+first every point in the block is located into separate index/ratio
+arrays, then all of them are interpolated.  Consecutive log samples are
+close together so the hint makes the search nearly free.
+
+************************************************************************/
+
+#define ARRAY_BLOCK 32
+
+void table_lookup_array(const float * const col_values, const float * const row_values, float * const results, const uint32_t n, const struct table * const table)
+{
+	struct axis_hint col_hint;
+	struct axis_hint row_hint;
+	uint16_t offset[ARRAY_BLOCK];		/* start cell of each point */
+	float col_ratio[ARRAY_BLOCK];
+	float row_ratio[ARRAY_BLOCK];
+	uint8_t col_index;
+	uint8_t row_index;
+	uint32_t done;
+	uint32_t i;
+	uint32_t count;
+
+	if (!table_size_ok(table)) {		/* same as table_lookup() */
+		err_push( CODE_OLDJUNK_FC );
+		for (i = 0; i < n; ++i)
+			results[i] = 255;
+		return;
+	}
+
+	/* same as table_lookup() - no even spacing or 1/width, so the ratios are divided exactly the same way */
+	col_hint.index = row_hint.index = 0;
+	col_hint.inv_step = row_hint.inv_step = 0;
+	col_hint.widths = row_hint.widths = 0;
+
+	for (done = 0; done < n; done += count) {
+		count = (n - done < ARRAY_BLOCK) ? n - done : ARRAY_BLOCK;
+
+		/* locate the block */
+		for (i = 0; i < count; ++i) {
+			row_ratio[i] = axis_locate(row_values ? row_values[done + i] : 0, table->row_axis, table->rows, &row_hint, &row_index);
+			col_ratio[i] = axis_locate(col_values[done + i], table->col_axis, table->cols, &col_hint, &col_index);
+			offset[i] = (uint16_t)((table->cols * row_index) + col_index);
 		}
+
+		/* interpolate the block */
+		for (i = 0; i < count; ++i)
+			results[done + i] = cell_interp(table->data + offset[i], table->cols, col_ratio[i], row_ratio[i]);
 	}
 
-	/* Interpolate between the four nearest cells (2D) using bilinear method */
+} /* table_lookup_array() */
+
+/* same as table_size_ok() plus the layers */
+static inline uint8_t table3d_size_ok(const struct table3d * const table)
+{
+	return table != 0 && table->cols >= 2 && table->rows >= 1 && table->layers >= 1
+	    && table->cols <= MAX_3D_COLS && table->rows <= MAX_3D_ROWS && table->layers <= MAX_3D_LAYERS;
+}
+
+/************************************************************************
+
+@param pointer to 3D table structure
+@return CODE_NONE if the table is usable, otherwise the error code
 
-	/* Make sure we are not above or below the  &&  && 
-	columns   row_value > table->row_axis[row_index] && col_value > table->col_axis[col_index] && */
-	if ( ( row_index >= rows -1) ||  (row_value <= table->row_axis[row_index] && row_index == 0))
-	{		/* Upper or lower most row, no interpolation on row_value */
-		if ( (col_index >= cols - 1) || (col_value <= table->col_axis[col_index] && col_index == 0) )
-		{ /* No interprolation on col_value either */
-			/* Calculate the correct pointer location for our data point */
-			ptr = (float *) table->data + ((cols * row_index) + col_index) ;
-			return value(ptr);
+Same checks as table_check() plus the layer axis.
+
+************************************************************************/
+
+uint32_t table3d_check(const struct table3d * const table)
+{
+	uint8_t i;
+
+	/* check for sane values */
+	if (!table3d_size_ok(table))
+		return CODE_OLDJUNK_FC;
+
+	/* check for proper axis sorting (must be ascending) */
+	for (i = 1; i < table->cols; ++i) {
+		if (table->col_axis[i] < table->col_axis[i - 1])
+			return CODE_OLDJUNK_FB;
+	}
+	for (i = 1; i < table->rows; ++i) {
+		if (table->row_axis[i] < table->row_axis[i - 1])
+			return CODE_OLDJUNK_FA;
+	}
+	for (i = 1; i < table->layers; ++i) {
+		if (table->layer_axis[i] < table->layer_axis[i - 1])
+			return CODE_OLDJUNK_FA;
+	}
+	return CODE_NONE;
+
+} // table3d_check()
+
+/************************************************************************
+
+@param x value
+@param y value (optional)
+@param z value (optional)
+@param pointer to 3D table structure
+@param pointer to the caller's hint
+@return lookup value from table
+
+One fused trilinear lookup - each axis is searched once (with the same
+hints, even spacing and 1/width as the 2D lookups) and the two nearest
+layers are blended.  Replaces a 2D lookup times one or more 1D
+correction lookups.
+
+************************************************************************/
+
+float table_lookup_3d(const float col_value, const float row_value, const float layer_value, const struct table3d * const table, struct table3d_hint * const hint)
+{
+	const float *ptr;
+	uint8_t col_index;
+	uint8_t row_index;
+	uint8_t layer_index;
+	float col_ratio;
+	float row_ratio;
+	float layer_ratio;
+	float value1;
+	const uint16_t layer_size = (uint16_t)table->cols * table->rows;
+
+#ifdef PARANOIA
+	if (table3d_check(table) != CODE_NONE)
+		return 255;
+#endif
+
+	/* first use of this hint, a different table or the tables changed - redo the axis setup */
+	if (hint->generation != Page_Generation || hint->table != table) {
+		hint->valid = table3d_size_ok(table);
+		if (hint->valid) {
+			axis_setup(table->col_axis, table->cols, &hint->col);
+			axis_setup(table->row_axis, table->rows, &hint->row);
+			axis_setup(table->layer_axis, table->layers, &hint->layer);
 		}
+		hint->table = table;
+		hint->generation = Page_Generation;
+	}
+
+	if (!hint->valid) {
+		err_push( CODE_OLDJUNK_FC );
+		return 255;
+	}
+
+	col_ratio = axis_locate(col_value, table->col_axis, table->cols, &hint->col, &col_index);
+	row_ratio = axis_locate(row_value, table->row_axis, table->rows, &hint->row, &row_index);
+	layer_ratio = axis_locate(layer_value, table->layer_axis, table->layers, &hint->layer, &layer_index);
+
+	/* Calculate the correct pointer location for our data point */
+	ptr = table->data + (layer_size * layer_index) + (table->cols * row_index) + col_index;
+
+	value1 = cell_interp(ptr, table->cols, col_ratio, row_ratio);
+	if (layer_ratio == 0)					/* on a layer, no need for the next one */
+		return value1;
+
+	return interpolate(layer_ratio, value1, cell_interp(ptr + layer_size, table->cols, col_ratio, row_ratio));
+
+} /* table_lookup_3d() */
+
+/************************************************************************
+
+Fixed point lookups - see struct table_q
+
+************************************************************************/
+
+/* float to nearest int */
+static inline int32_t q_round(const float x)
+{
+	return (int32_t)(x >= 0 ? x + 0.5f : x - 0.5f);
+}
+
+/* scale one axis and work out 2^32/width of each cell */
+
+static void q_axis_build(const float * const axis, const uint8_t n, const float scale, int32_t * const q_axis, uint32_t * const inv)
+{
+	uint8_t i;
+	int32_t width;
+
+	for (i = 0; i < n; ++i)
+		q_axis[i] = q_round(axis[i] * scale);
+
+	for (i = 0; i + 1 < n; ++i) {
+		width = q_axis[i + 1] - q_axis[i];
+		if (width <= 0)									/* duplicate or unsorted, don't interpolate */
+			inv[i] = 0;
+		else if (width == 1)
+			inv[i] = 0xffffffff;
 		else
-		{
-			/* No interporlation on row_value, but we are interpolating on col_value */
-			ratio = (col_value - table->col_axis[col_index])/(table->col_axis[col_index + 1] - table->col_axis[col_index]);
-			/* Calculate the correct pointer location for our data point */
-			ptr = (float *) table->data + ((cols * row_index) + col_index);
-			value1 = value(ptr);
-			/* Calculate the correct pointer location for our data point */
-			ptr = (float *) table->data + ((cols * (row_index )) + col_index + 1 );
-			value2 = value(ptr);
-			return interpolate(ratio, value1, value2);
-		}
+			inv[i] = (uint32_t)(0x100000000ULL / (uint32_t)width);
 	}
-	else /* We are interpolating on row_value 
-	(col_value > table->col_axis[col_index] &&  && */
-	{
-		if (  (col_index >= cols - 1) || ( col_value <= table->col_axis[col_index] && col_index == 0) )
-		{ /* No interprolation on col_value, but we are still interpolating on row_value */
-			ratio = (row_value - table->row_axis[row_index])/(table->row_axis[row_index + 1] - table->row_axis[row_index]);
-			/* Calculate the correct pointer location for our data point */
-			ptr = (float *) table->data + ((cols * row_index) + col_index);
-			value1 = value(ptr);
-			/* Calculate the correct pointer location for our data point */
-			ptr = (float *) table->data + ((cols * (row_index +1) ) + (col_index));
-			value2 = value(ptr);
-			return interpolate(ratio, value1, value2);
+}
+
+/* rebuild the fixed point copy from the float table, called when the table or page changes */
+
+static void table_q_build(const struct table * const table, struct table_q * const q)
+{
+	uint16_t i;
+	uint16_t cells;
+
+	q->table = table;
+	q->generation = Page_Generation;
+	q->col_index = q->row_index = 0;
+
+	cells = (uint16_t)table->cols * table->rows;
+	if (table->cols > MAX_COLS || table->rows > MAX_ROWS || cells == 0 || cells > q->max_cells) {
+		q->valid = 0;
+		return;
+	}
+
+	q->cols = table->cols;
+	q->rows = table->rows;
+	q_axis_build(table->col_axis, q->cols, q->col_scale, q->col_axis, q->col_inv);
+	q_axis_build(table->row_axis, q->rows, q->row_scale, q->row_axis, q->row_inv);
+	for (i = 0; i < cells; ++i)
+		q->data[i] = q_round(table->data[i] * q->data_scale);
+
+	q->valid = 1;
+}
+
+/* integer version of axis_locate() - returns the ratio in Q16 (65536 = 1.0, 0 = no interpolation) */
+
+static inline uint32_t q_axis_locate(const int32_t value, const int32_t * const axis, const uint32_t * const inv, const uint8_t n, uint8_t * const hint)
+{
+	uint8_t i = *hint;
+	uint8_t lower;
+	uint8_t upper;
+
+	if (n == 1 || value <= axis[0]) {				/* 1D or < first */
+		*hint = 0;
+		return 0;
+	}
+	if (value >= axis[n - 1]) {						/* > last, hint points past the last cell */
+		*hint = n - 1;
+		return 0;
+	}
+
+	/* try last time's cell and its neighbours, else binary search */
+	if (i < n - 1 && axis[i] <= value && value < axis[i + 1])
+		;
+	else if (i + 1 < n - 1 && axis[i + 1] <= value && value < axis[i + 2])
+		++i;
+	else if (i > 0 && i < n && axis[i - 1] <= value && value < axis[i])
+		--i;
+	else {
+		lower = 0;
+		upper = n - 1;
+		while (upper - lower > 1) {
+			i = (uint8_t)((upper + lower) / 2);
+			if (axis[i] <= value)
+				lower = i;
+			else
+				upper = i;
 		}
-		else /* Most complex case, we are interpolating on both row_value and col_value... */
-		{
-			/* Interpolate along current col_value row first */
-			ratio = (row_value - table->row_axis[row_index])/(table->row_axis[row_index + 1] - table->row_axis[row_index]);
-			/* Calculate the correct pointer location for our data point */
-			ptr = (float *) table->data + ((cols * row_index) + col_index) ;
-			value1 = value(ptr);
-			/* Calculate the correct pointer location for our data point */
-			ptr = (float *) table->data + ((cols * (row_index + 1)) + col_index);
-			
-			
-			value2 = *ptr;
-			value3 = interpolate(ratio, value1, value2);
-
-			/* Interpolate along next col_value row */
-			/* Calculate the correct pointer location for our data point */
-			ptr = (float *) table->data + ((cols * (row_index)) + col_index + 1);
-			value1 = value(ptr);
-			/* Calculate the correct pointer location for our data point */
-			ptr = (float *) table->data + ((cols * (row_index + 1)) + (col_index + 1));
-			value2 = value(ptr);
-			value4 = interpolate(ratio, value1, value2);
-
-			/* Now we can interpolate along the row_value column to get our final value */
-			ratio = (col_value - table->col_axis[col_index])/(table->col_axis[col_index + 1] - table->col_axis[col_index]);
-			return interpolate(ratio, value3, value4); /* Return our final result */
+		i = lower;
+	}
+	*hint = i;
+
+	return (uint32_t)(((uint64_t)(uint32_t)(value - axis[i]) * inv[i]) >> 16);
+}
+
+/* a + (b - a) * ratio with ratio in Q16 */
+static inline int32_t q_interpolate(const uint32_t ratio, const int32_t value1, const int32_t value2)
+{
+	if (ratio == 0 || value1 == value2)
+		return value1;
+	return value1 + (int32_t)(((int64_t)(value2 - value1) * (int32_t)ratio) >> 16);
+}
+
+/* integer version of table_interp()'s cell blend, ratios in Q16 */
+static inline int32_t q_cell_interp(const int32_t * const ptr, const uint8_t cols, const uint32_t col_ratio, const uint32_t row_ratio)
+{
+	int32_t value3;
+	int32_t value4;
+
+	if (row_ratio == 0) {
+		if (col_ratio == 0)
+			return ptr[0];
+		return q_interpolate(col_ratio, ptr[0], ptr[1]);
+	}
+
+	value3 = q_interpolate(row_ratio, ptr[0], ptr[cols]);
+	if (col_ratio == 0)
+		return value3;
+	value4 = q_interpolate(row_ratio, ptr[1], ptr[cols + 1]);
+
+	return q_interpolate(col_ratio, value3, value4);
+}
+
+/************************************************************************
+
+@param x value, in the table's axis units times col_scale
+@param y value (optional), in the table's axis units times row_scale
+@param pointer to the float table
+@param the fixed point copy (static, from TABLE_Q())
+@return lookup value times data_scale, rounded
+
+Same result as table_lookup() scaled, but without float math once the
+copy is built.  The copy is rebuilt when the table or Page_Generation
+changes.  A table bigger than the copy's data space falls back to the
+float lookup.
+
+************************************************************************/
+
+int32_t table_lookup_q(const int32_t col_value, const int32_t row_value, const struct table * const table, struct table_q * const q)
+{
+	uint32_t col_ratio;
+	uint32_t row_ratio;
+	uint8_t col_index;
+	uint8_t row_index;
+
+	if (q->generation != Page_Generation || q->table != table)
+		table_q_build(table, q);
+
+	if (!q->valid)
+		return q_round(table_lookup(col_value / q->col_scale, row_value / q->row_scale, table) * q->data_scale);
+
+	row_ratio = q_axis_locate(row_value, q->row_axis, q->row_inv, q->rows, &q->row_index);
+	col_ratio = q_axis_locate(col_value, q->col_axis, q->col_inv, q->cols, &q->col_index);
+	row_index = q->row_index;
+	col_index = q->col_index;
+
+	return q_cell_interp(q->data + ((q->cols * row_index) + col_index), q->cols, col_ratio, row_ratio);
+
+} /* table_lookup_q() */
+
+/* the tables have the same size and axes, so one cell and ratio fits them all */
+static uint8_t same_axes(const struct table * const t1, const struct table * const t2)
+{
+	return t1->cols == t2->cols && t1->rows == t2->rows
+	    && memcmp(t1->col_axis, t2->col_axis, t1->cols * sizeof(float)) == 0
+	    && memcmp(t1->row_axis, t2->row_axis, t1->rows * sizeof(float)) == 0;
+}
+
+/************************************************************************
+
+@param the group - x,y and the tables, see struct table_group
+
+Looks up several tables at the same x,y.  If the tables really do share
+axes, the cell is found and the ratios worked out once, then every table
+is interpolated at that cell - the fixed point copies with the ratios in
+Q16, so they still interpolate in integers.  Whether the axes are the
+same is worked out again only when Page_Generation changes.  Tables
+that don't share axes are each looked up on their own, with x and y
+scaled and rounded for the fixed point copies the way their callers do.
+
+************************************************************************/
+
+void table_lookup_group(struct table_group * const group)
+{
+	struct table_group_member * const member = group->member;
+	const struct table * const first = member[0].table;
+	struct table_pos pos;
+	uint32_t col_ratio;
+	uint32_t row_ratio;
+	uint16_t offset;
+	uint8_t i;
+
+	if (group->generation != Page_Generation || group->table != first) {	/* tables changed, recheck */
+		group->generation = Page_Generation;
+		group->table = first;
+		group->same_axes = table_size_ok(first);
+		for (i = 1; i < group->n && group->same_axes; ++i)
+			group->same_axes = same_axes(first, member[i].table);
+	}
+
+	for (i = 0; i < group->n; ++i) {
+		struct table_q * const q = member[i].q;
+
+		if (q && (q->generation != Page_Generation || q->table != member[i].table))
+			table_q_build(member[i].table, q);
+	}
+
+	if (!group->same_axes) {
+		for (i = 0; i < group->n; ++i) {
+			struct table_q * const q = member[i].q;
+
+			if (q)
+				member[i].q_result = table_lookup_q(q_round(group->col_value * q->col_scale), q_round(group->row_value * q->row_scale), member[i].table, q);
+			else
+				member[i].result = table_lookup_hint(group->col_value, group->row_value, member[i].table, &member[i].hint);
 		}
+		return;
 	}
-} /* table_lookup() */
+
+	table_locate(group->col_value, group->row_value, first, &group->hint, &pos);
+
+	offset = (uint16_t)((first->cols * pos.row_index) + pos.col_index);
+	col_ratio = (uint32_t)(pos.col_ratio * 65536.0f);
+	row_ratio = (uint32_t)(pos.row_ratio * 65536.0f);
+
+	for (i = 0; i < group->n; ++i) {
+		struct table_q * const q = member[i].q;
+
+		if (!q)
+			member[i].result = table_interp(member[i].table, &pos);
+		else if (q->valid)
+			member[i].q_result = q_cell_interp(q->data + offset, q->cols, col_ratio, row_ratio);
+		else				/* didn't fit its copy */
+			member[i].q_result = q_round(table_interp(member[i].table, &pos) * q->data_scale);
+	}
+
+} /* table_lookup_group() */
+
+
+/************************************************************************
+
+Count indexed lookups - see struct table_lut
+
+************************************************************************/
+
+/* value of a 1D table at x.  *i is the cell to start from, x only goes up during a build so the
+   whole table is walked once */
+
+static float lut_point(const struct table * const table, const float x, uint8_t * const i)
+{
+	const float * const axis = table->col_axis;
+	const uint8_t n = table->cols;
+	uint8_t j;
+
+	if (x <= axis[0])
+		return table->data[0];
+	if (x >= axis[n - 1])
+		return table->data[n - 1];
+
+	while (axis[*i + 1] <= x)
+		++*i;
+	j = *i;
+
+	return table->data[j] + (table->data[j + 1] - table->data[j]) * (x - axis[j]) / (axis[j + 1] - axis[j]);
+}
+
+/* resample the float table at every segment boundary, called when the table or page changes */
+
+static void table_lut_build(const struct table * const table, struct table_lut * const lut)
+{
+	uint16_t s;
+	uint8_t i = 0;
+	uint8_t j = 0;
+	float x1;
+	float x2;
+	float value1;
+	float value2;
+
+	lut->table = table;
+	lut->generation = Page_Generation;
+	lut->valid = table_check(table) == CODE_NONE && table->rows == 1;
+	if (!lut->valid)
+		return;
+
+	memset(lut->knee, 0, sizeof(lut->knee));
+	x1 = 0.0f;
+	value1 = lut_point(table, x1, &i);
+	for (s = 0; s < TABLE_LUT_SEGMENTS; ++s) {
+		x2 = (float)((uint32_t)(s + 1) << TABLE_LUT_SHIFT) * lut->x_per_count;
+		value2 = lut_point(table, x2, &i);
+		lut->seg[s].base = value1;
+		lut->seg[s].slope = (value2 - value1) * (1.0f / (1 << TABLE_LUT_SHIFT));
+
+		/* a table point strictly inside the segment bends the line */
+		while (j < table->cols && table->col_axis[j] <= x1)
+			++j;
+		if (j < table->cols && table->col_axis[j] < x2)
+			lut->knee[s >> 5] |= 1ul << (s & 31);
+
+		x1 = x2;
+		value1 = value2;
+	}
+}
+
+/************************************************************************
+
+@param count raw A/D result, 0 to TABLE_LUT_COUNTS - 1
+@param pointer to a 1D float table, x in the units of x_per_count
+@param the count indexed copy (static, from TABLE_LUT())
+@return lookup value
+
+Same result as table_lookup(count * x_per_count, 0, table), to float
+rounding.  The few segments with a table point inside them aren't a
+straight line, so they go to table_lookup() itself.  The copy is
+rebuilt when the table or Page_Generation changes.  A table that fails
+table_check() or has more than one row falls back to the float lookup.
+
+************************************************************************/
+
+float table_lookup_lut(uint16_t count, const struct table * const table, struct table_lut * const lut)
+{
+	const struct table_lut_seg *seg;
+	uint16_t s;
+
+	if (lut->generation != Page_Generation || lut->table != table)
+		table_lut_build(table, lut);
+
+	if (!lut->valid)
+		return table_lookup(count * lut->x_per_count, 0, table);
+
+	if (count > TABLE_LUT_COUNTS - 1)
+		count = TABLE_LUT_COUNTS - 1;
+	s = count >> TABLE_LUT_SHIFT;
+	if (lut->knee[s >> 5] & (1ul << (s & 31)))
+		return table_lookup(count * lut->x_per_count, 0, table);
+	seg = &lut->seg[s];
+
+	return seg->base + seg->slope * (float)(count & ((1 << TABLE_LUT_SHIFT) - 1));
+
+} /* table_lookup_lut() */
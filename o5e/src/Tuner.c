@@ -18,6 +18,7 @@
 #include "mpc563xm.h"
 #include "config.h"
 #include "cocoos.h"
+#include "bsp.h"
 #include "err.h"
 #include "eSCI_DMA.h"
 #include "FLASH_OPS.h"
@@ -26,6 +27,9 @@
 
 #define PAYLOAD_OFFSET 2        // accounts for packet with crc and size
 #define PAGE_OFFSET 1           // page #s start with 1
+#define TASK_STATS_PAGE 0xf4    // read only, cocoOS per task run time statistics
+#define RAM_STATS_PAGE 0xf5     // read only, stack high water and static ram use
+#define ERR_COUNTS_PAGE 0xf6    // read only, per error code counters
 
 #define write_serial_busy()  (EDMA.TCD[18].DONE != 1)     // a macro for speed reasons
 
@@ -50,6 +54,11 @@ Special pages:
 0xf1    ; trigger logger
 0xf2    ; composite tooth logger
 0xf3    ; composite tooth logger loop
+0xf4    ; task statistics, struct os_task_stats per task id (read only)
+0xf5    ; ram use, 6 uint32 in bytes: stack size, stack high water, static ram,
+          serial buffer size, largest packet received, page buffer size (read only)
+0xf6    ; error codes, struct err_counts: dropped, untracked, then ERR_CODES x
+          code, count, first ms, last ms (read only, code 0 is an unused slot)
 
 */
 
@@ -106,6 +115,8 @@ static uint8_t Page_Is_Blank(uint8_t *ptr);
  */
 
 static uint8_t tmp_buf[SERIAL_BUFFER_SIZE];  // this buffer is used to receive and send packets
+static uint16_t Serial_High_Water;           // largest packet received, to size the above
+static uint32_t Ram_Stats[6];                // RAM_STATS_PAGE, filled in when read
 
 void Tuner_Task(void)
 {
@@ -116,6 +127,7 @@ void Tuner_Task(void)
     static uint16_t offset;
     static uint16_t length;
     static uint32_t crc;
+    os_declare_state();         // flash erase/program, no yield in between
 
     task_open();                // standard OS entry - required on all tasks
 
@@ -138,6 +150,9 @@ void Tuner_Task(void)
             task_wait(99);
         }                       // for
 
+        if ((uint16_t)count > Serial_High_Water)
+            Serial_High_Water = (uint16_t)count;
+
         // process received packet
         // don't use switch because we use the OS
 
@@ -215,6 +230,17 @@ void Tuner_Task(void)
                 continue;
             }
 
+            // don't burn a table the lookups can't use
+            for (i = 0; i < NPAGES; ++i) {
+                if (!Page_Valid[i])
+                    break;
+            }
+            if (i < NPAGES) {
+                err_push( CODE_TUNER_BAD_TABLE );
+                make_packet(config_error, "", 0);
+                continue;
+            }
+
             // ignore the page # and burn everything to the other block
             // select unused flash block (ping pongs 0 or 1)
             static uint8_t new_flash_block;
@@ -222,11 +248,11 @@ void Tuner_Task(void)
 
             // erase new flash block
             if (!Page_Is_Blank(Flash_Addr[new_flash_block])) {  // if not already erased
-              asm("wrteei 0");
+              os_disable_interrupts();
                Flash_Erase(new_flash_block);
                while (!Flash_Ready()) { };
                Flash_Finish(new_flash_block);
-              asm("wrteei 1");
+              os_enable_interrupts();
             }
 
             // check erase
@@ -250,11 +276,11 @@ void Tuner_Task(void)
                     static uint64_t tmp;               // 8 bytes, properly aligned in ram
                     tmp = *(uint64_t *)ptr;
 
-                    asm("wrteei 0");
+                    os_disable_interrupts();
                     Flash_Program(new_flash_block, &tmp, flash_index);  // setup + copy
                     while (!Flash_Ready()) { };                         // wait till ready
                     Flash_Finish(new_flash_block);                      // terminate
-                    asm("wrteei 1");
+                    os_enable_interrupts();
 
                     // check it by reading it back
                     if (tmp != *(uint64_t *)(Flash_Addr[new_flash_block] + flash_index)) {
@@ -287,11 +313,11 @@ void Tuner_Task(void)
                 memcpy(header.Cookie, "ABCD", 4);
                 header.Burn_Count = ++Burn_Count;
                 // burn first portion of header
-                asm("wrteei 0");
+                os_disable_interrupts();
                 Flash_Program(new_flash_block, (uint64_t *)&header, 0);
                 while (!Flash_Ready()) { };                // wait till burn is done
                 Flash_Finish(new_flash_block);
-                asm("wrteei 1");
+                os_enable_interrupts();
                 // check for success
                 if (*Flash_Addr[new_flash_block] != 'A') {
                     err_push( CODE_OLDJUNK_F1 );
@@ -305,11 +331,11 @@ void Tuner_Task(void)
 
             // erase old block
             new_flash_block ^= 1;               // the new new one
-            asm("wrteei 0");
+            os_disable_interrupts();
             Flash_Erase(new_flash_block);
             while (!Flash_Ready()) { };
             Flash_Finish(new_flash_block);
-            asm("wrteei 1");
+            os_enable_interrupts();
 
             // we are now running with all variables in the new flash
             make_packet(burn_ok, "", 0);
@@ -347,13 +373,46 @@ void Tuner_Task(void)
 */
             // find page #
             page = *(uint16_t *) (tmp_buf + PAYLOAD_OFFSET + 1) - PAGE_OFFSET;
-            if (page >= NPAGES)
-                continue;
             // find offset
             offset = *(uint16_t *) (tmp_buf + PAYLOAD_OFFSET + 3);
             // find length
             length = *(uint16_t *) (tmp_buf + PAYLOAD_OFFSET + 5);
 
+#ifdef OS_TASK_STATS
+            if (page == TASK_STATS_PAGE - PAGE_OFFSET) {
+                if ((uint32_t)offset + length > N_TASKS * sizeof(struct os_task_stats)) {
+                    make_packet(out_of_range, "", 0);
+                    continue;
+                }
+                make_packet(OK, (const uint8_t *)os_task_stats_get() + offset, length);
+                continue;
+            }
+#endif
+            if (page == RAM_STATS_PAGE - PAGE_OFFSET) {
+                if ((uint32_t)offset + length > sizeof(Ram_Stats)) {
+                    make_packet(out_of_range, "", 0);
+                    continue;
+                }
+                Ram_Stats[0] = bsp_stack_size();
+                Ram_Stats[1] = bsp_stack_used();
+                Ram_Stats[2] = bsp_static_ram();
+                Ram_Stats[3] = sizeof(tmp_buf);
+                Ram_Stats[4] = Serial_High_Water;
+                Ram_Stats[5] = sizeof(Ram_Page_Buffer);
+                make_packet(OK, (const uint8_t *)Ram_Stats + offset, length);
+                continue;
+            }
+            if (page == ERR_COUNTS_PAGE - PAGE_OFFSET) {
+                if ((uint32_t)offset + length > sizeof(struct err_counts)) {
+                    make_packet(out_of_range, "", 0);
+                    continue;
+                }
+                make_packet(OK, (const uint8_t *)err_counts_get() + offset, length);
+                continue;
+            }
+            if (page >= NPAGES)
+                continue;
+
             make_packet(OK, (void *)(Page_Ptr[page] + offset), length);
             continue;
         }
@@ -410,6 +469,7 @@ void Tuner_Task(void)
 
             // copy new data from tuner to ram page buffer
             memcpy(Ram_Page_Buffer + offset, tmp_buf + PAYLOAD_OFFSET + 7, length);
+            Page_Changed((uint8_t)page);                // recheck its tables
 
             // send response
             make_packet(OK, "", 0);
@@ -28,6 +28,9 @@ Portions Copyright 2012, Sean Stasiak <sstasiak at gmail dot com> - BSD 3 Clause
 #include "eQADC_OPS.h"
 #include "eTPU_OPS.h"
 #include "bsp.h" //pickup systime for the clock to work
+#include "cocoos.h"
+#include "MAP_Sample.h"
+#include "AD_Filter.h"
 
 
 /*  eTPU APIs                                                                  */
@@ -40,65 +43,60 @@ Portions Copyright 2012, Sean Stasiak <sstasiak at gmail dot com> - BSD 3 Clause
 #   define MAX_AD_VOLTAGE 5.0f
 
 #   define VBATT_VOLTAGE_DIVIDER 49.0f/10.0f
-#   define V_Batt_AD    ADC_RsltQ0[25]
+// Q0 A/D channel numbers (V_xxx_AD) are in eQADC_OPS.h, the results are read from Scan
 #   define CLT_VOLTAGE_DIVIDER 1.0f
-#   define V_CLT_AD    ADC_RsltQ0[39]
 #   define IAT_VOLTAGE_DIVIDER 1.0f
-#   define V_IAT_AD    ADC_RsltQ0[38]
 #   define TPS_VOLTAGE_DIVIDER 1.0f
-#   define V_TPS_AD    ADC_RsltQ0[31]
 #   define MAP_1_VOLTAGE_DIVIDER 1.0f
-#   define V_MAP_1_AD    ADC_RsltQ5 [0]       
+//  MAP 1 is read in bursts at an angle, see MAP_Sample.h
 #   define MAP_2_VOLTAGE_DIVIDER 1.0f
-#   define V_MAP_2_AD    ADC_RsltQ0 [23]	/* TODO */
 #   define MAF_1_VOLTAGE_DIVIDER 1.0f
-#   define V_MAF_1_AD    ADC_RsltQ0 [35]
 #   define P1_VOLTAGE_DIVIDER 1.0f
-#   define V_P1_AD    ADC_RsltQ0 [17]
 #   define P2_VOLTAGE_DIVIDER 1.0f
-#   define V_P2_AD    ADC_RsltQ0 [31]
 #   define P3_VOLTAGE_DIVIDER 1.0f
-#   define V_P3_AD    ADC_RsltQ0 [32]
 #   define P4_VOLTAGE_DIVIDER 1.0f
-#   define V_P4_AD    ADC_RsltQ0 [33]
 #   define O2_1_VOLTAGE_DIVIDER 1.0f
-#   define V_O2_1_AD    ADC_RsltQ0 [23]
 #   define O2_2_VOLTAGE_DIVIDER 1.0f
-#   define V_O2_2_AD    ADC_RsltQ0 [28]
-#   define Knock_1_VOLTAGE_DIVIDER 1.0f
-#   define V_Knock_1_AD    ADC_RsltQ0 [0]   // TODO
-#   define Knock_2_VOLTAGE_DIVIDER 1.0f
-#   define V_Knock_2_AD    ADC_RsltQ0 [2]   // TODO
+//  knock is read in the knock windows, see Knock.h
 
 float Ref_IAT;
 float Ref_MAP;
 float Ref_Baro;
 float Ref_TPS;
+uint8_t MAP_Angle_OK;
+uint16_t MAP_Angle_Count;
+
+#   define MAP_SAMPLE_TIMEOUT 250      // msec without a MAP burst before MAP[0] is stale, cranking is slower than this
 
 extern uint32_t etpu_a_tcr1_freq;       //Implicit Defn.in eTPU_OPS.c
 extern uint32_t etpu_b_tcr1_freq;       //Implicit Defn.in eTPU_OPS.c
 
 int8_t crank_position_status;
 
-// filter a raw A/D value in ADC_RsltQ0 - done "in place"
-// strength can be 1,2,3,.. for 1/2, 1/4, 1/8, etc
-// WARNING: will not work on values in any other Q 
-// WARNING: effect depends on how often you call it
-static uint16_t prev_value[sizeof(ADC_RsltQ0) / sizeof(uint16_t)];
-
-inline uint16_t
-Filter_AD(vuint16_t * Value, uint16_t Strength)
-{
-register unsigned int index = (unsigned int)(Value - &ADC_RsltQ0[0]);   // 0 to 39 normally
-
-// use, for example (strength = 3), 7/8 of old value and 1/8 of new value
-
-// check that it is in the memory range of RsltQ0, otherwise do nothing
-if (index < (unsigned int)(sizeof(ADC_RsltQ0) / sizeof(uint16_t)))
-   prev_value[index] = *Value = (*Value + (prev_value[index] * ((1<<Strength) - 1))) >> Strength;
-
-return prev_value[index];
-}
+// count indexed copies of the sensor tables, rebuilt when a page changes
+#   define AD_VOLTS (MAX_AD_VOLTAGE / MAX_AD_COUNTS)
+static struct table_lut CLT_LUT = TABLE_LUT(AD_VOLTS * CLT_VOLTAGE_DIVIDER);
+static struct table_lut IAT_LUT = TABLE_LUT(AD_VOLTS * IAT_VOLTAGE_DIVIDER);
+static struct table_lut TPS_LUT = TABLE_LUT(AD_VOLTS * TPS_VOLTAGE_DIVIDER);
+static struct table_lut MAP_1_LUT = TABLE_LUT(AD_VOLTS * MAP_1_VOLTAGE_DIVIDER);
+static struct table_lut MAP_2_LUT = TABLE_LUT(AD_VOLTS * MAP_2_VOLTAGE_DIVIDER);
+static struct table_lut MAF_1_LUT = TABLE_LUT(AD_VOLTS * MAF_1_VOLTAGE_DIVIDER);
+static struct table_lut Lambda_1_LUT = TABLE_LUT(AD_VOLTS * O2_1_VOLTAGE_DIVIDER);
+static struct table_lut Lambda_2_LUT = TABLE_LUT(AD_VOLTS * O2_2_VOLTAGE_DIVIDER);
+
+// the Test_Value = 1 lookups from volts, each remembers its last cell
+static struct table_hint CLT_Hint;
+static struct table_hint IAT_Hint;
+static struct table_hint TPS_Hint;
+static struct table_hint MAP_1_Hint;
+static struct table_hint MAP_2_Hint;
+
+// newest complete Q0 scan, copied once per pass so every channel comes from the same scan
+// the results are already filtered per channel, see AD_Filter.h
+static struct adc_scan Scan;
+
+// newest MAP burst, one per cylinder intake stroke
+static struct map_sample MAP_Sample;
 
 //**********************************************************************************
 // FUNCTION     : Get_Operational_Variables                                       
@@ -113,6 +111,9 @@ void Get_Slow_Op_Vars(void)
 
 /* Slow stuff...10hz or so*/
 
+    // the A/D filter coefficients follow the calibration and the scan rate
+    AD_Filter_Update();
+
     // Code for testing
     // Test_Enable allows real time variables to be set in TunerStudio to test code.
 
@@ -130,10 +131,10 @@ void Get_Slow_Op_Vars(void)
 
             // Test_Value = 1 allows values simulating the ADC to be input 
             V_CLT = Test_V_CLT;
-            CLT = table_lookup(V_CLT, 1, CLT_Table);
+            CLT = table_lookup_hint(V_CLT, 1, CLT_Table, &CLT_Hint);
 
             V_IAT = Test_V_IAT;
-            IAT = table_lookup(V_IAT, 1, IAT_Table);
+            IAT = table_lookup_hint(V_IAT, 1, IAT_Table, &IAT_Hint);
 
 
         } // if
@@ -151,15 +152,15 @@ void Get_Slow_Op_Vars(void)
 
     } else {                    // Run Mode, normal operation
 
+        (void)ADC_Scan_Read(&Scan);
+
         // coolant temperature
-        Filter_AD(&V_CLT_AD,3);  // smooth by 8
-        V_CLT = (V_CLT_AD * ((MAX_AD_VOLTAGE / MAX_AD_COUNTS) * CLT_VOLTAGE_DIVIDER));
-        CLT = table_lookup(V_CLT, 1, CLT_Table);
+        V_CLT = (Scan.result[V_CLT_AD] * ((MAX_AD_VOLTAGE / MAX_AD_COUNTS) * CLT_VOLTAGE_DIVIDER));
+        CLT = table_lookup_lut(Scan.result[V_CLT_AD], CLT_Table, &CLT_LUT);
 
         // intake air temp
-        Filter_AD(&V_IAT_AD,3);  // smooth by 8
-        V_IAT = (V_IAT_AD * ((MAX_AD_VOLTAGE / MAX_AD_COUNTS) * IAT_VOLTAGE_DIVIDER));
-        IAT = table_lookup(V_IAT, 1, IAT_Table);
+        V_IAT = (Scan.result[V_IAT_AD] * ((MAX_AD_VOLTAGE / MAX_AD_COUNTS) * IAT_VOLTAGE_DIVIDER));
+        IAT = table_lookup_lut(Scan.result[V_IAT_AD], IAT_Table, &IAT_LUT);
 
         // manifold absolute pressure 
 
@@ -167,10 +168,10 @@ void Get_Slow_Op_Vars(void)
         //MAP[2] = table_lookup(V_MAP[2], 1, MAP_3_Table);
 
         // O2 sensors 
-        V_O2[0] = (V_O2_1_AD * ((MAX_AD_VOLTAGE / MAX_AD_COUNTS) * O2_1_VOLTAGE_DIVIDER));
-        Lambda[0] = table_lookup (V_O2[0],0, Lambda_1_Table); 	// convert volts to lambda
-        V_O2[1] = (V_O2_2_AD * ((MAX_AD_VOLTAGE / MAX_AD_COUNTS) * O2_2_VOLTAGE_DIVIDER));
-        Lambda[1] = table_lookup (V_O2[0],0, Lambda_2_Table); 	// convert volts to lambda
+        V_O2[0] = (Scan.result[V_O2_1_AD] * ((MAX_AD_VOLTAGE / MAX_AD_COUNTS) * O2_1_VOLTAGE_DIVIDER));
+        Lambda[0] = table_lookup_lut(Scan.result[V_O2_1_AD], Lambda_1_Table, &Lambda_1_LUT); 	// convert to lambda
+        V_O2[1] = (Scan.result[V_O2_2_AD] * ((MAX_AD_VOLTAGE / MAX_AD_COUNTS) * O2_2_VOLTAGE_DIVIDER));
+        Lambda[1] = table_lookup_lut(Scan.result[V_O2_2_AD], Lambda_2_Table, &Lambda_2_LUT); 	// convert to lambda
 
     }  // if normal run mode
     //Convert sensor reading to a form more easily used in the corrections code
@@ -199,6 +200,7 @@ void Get_Fast_Op_Vars(void)
             TPS = Test_TPS;            
             MAP[0] = Test_MAP_Array[0];
             MAP[1] = Test_MAP_Array[1];
+            MAP_Angle_OK = 1;
             MAF[0] = Test_MAF_Array[0];
 
         } else {                // Test_Value = 1 allows values simulating the ADC to be input 
@@ -210,52 +212,70 @@ void Get_Fast_Op_Vars(void)
 
 
             V_TPS = Test_V_TPS;
-            TPS = table_lookup(V_TPS, 1, TPS_Table);
+            TPS = table_lookup_hint(V_TPS, 1, TPS_Table, &TPS_Hint);
             V_MAP[1] = Test_V_MAP_Array[1];
-            MAP[1] = table_lookup(V_MAP[1], 1, MAP_2_Table);
+            MAP[1] = table_lookup_hint(V_MAP[1], 1, MAP_2_Table, &MAP_2_Hint);
             /* Angle based stuff */
             V_MAP[0] = Test_V_MAP_Array[0];
-            MAP[0] = table_lookup(V_MAP[0], 1, MAP_1_Table);
+            MAP[0] = table_lookup_hint(V_MAP[0], 1, MAP_1_Table, &MAP_1_Hint);
+            MAP_Angle_OK = 1;
         }
 
     } else {                    //Run Mode, normal operation
 
+        (void)ADC_Scan_Read(&Scan);
+
         /* On fast for now, but should be medium speed ...100hz or so */
-        Filter_AD(&V_Batt_AD,3);  // smooth by 8
-        V_Batt = (V_Batt_AD * ((MAX_AD_VOLTAGE / MAX_AD_COUNTS) * VBATT_VOLTAGE_DIVIDER));
+        V_Batt = (Scan.result[V_Batt_AD] * ((MAX_AD_VOLTAGE / MAX_AD_COUNTS) * VBATT_VOLTAGE_DIVIDER));
 		if(crank_position_status == 0) //if status = 0 the TCR2 clock in not valid so set rpm to 0
 			RPM = 0;
 		else
         	RPM = (float)fs_etpu_eng_pos_get_engine_speed(etpu_a_tcr1_freq);       // Read RPM from eTPU
 
         /* Fast speed stuff...1000hz or so */
-        Filter_AD(&V_TPS_AD,3);  // smooth by 8
-        V_TPS = (V_TPS_AD * ((MAX_AD_VOLTAGE / MAX_AD_COUNTS) * TPS_VOLTAGE_DIVIDER));
-        TPS = table_lookup(V_TPS, 1, TPS_Table);
+        V_TPS = (Scan.result[V_TPS_AD] * ((MAX_AD_VOLTAGE / MAX_AD_COUNTS) * TPS_VOLTAGE_DIVIDER));
+        TPS = table_lookup_lut(Scan.result[V_TPS_AD], TPS_Table, &TPS_LUT);
         
-        Filter_AD(&V_MAP_2_AD,3);  // smooth by 8
-        V_MAP[1] = (V_MAP_2_AD * ((MAX_AD_VOLTAGE / MAX_AD_COUNTS) * MAP_2_VOLTAGE_DIVIDER));
-        MAP[1] = table_lookup(V_MAP[1], 1, MAP_2_Table);
+        V_MAP[1] = (Scan.result[V_MAP_2_AD] * ((MAX_AD_VOLTAGE / MAX_AD_COUNTS) * MAP_2_VOLTAGE_DIVIDER));
+        MAP[1] = table_lookup_lut(Scan.result[V_MAP_2_AD], MAP_2_Table, &MAP_2_LUT);
         
-        Filter_AD(&V_MAF_1_AD,3);  // smooth by 8
-        V_MAF[0] = (V_MAF_1_AD * ((MAX_AD_VOLTAGE / MAX_AD_COUNTS) * MAF_1_VOLTAGE_DIVIDER));
-        MAF[0] = table_lookup(V_MAF[0], 1, MAF_1_Table);
-
-        /* Angle based stuff */
-        Filter_AD(&V_MAP_1_AD,3);  // smooth by 8
-        V_MAP[0] = (V_MAP_1_AD * ((MAX_AD_VOLTAGE / MAX_AD_COUNTS) * MAP_1_VOLTAGE_DIVIDER));
-        MAP[0] = table_lookup(V_MAP[0], 1, MAP_1_Table);
+        V_MAF[0] = (Scan.result[V_MAF_1_AD] * ((MAX_AD_VOLTAGE / MAX_AD_COUNTS) * MAF_1_VOLTAGE_DIVIDER));
+        MAF[0] = table_lookup_lut(Scan.result[V_MAF_1_AD], MAF_1_Table, &MAF_1_LUT);
+
+        /* Angle based stuff, the newest intake stroke burst */
+        (void)MAP_Sample_Read(&MAP_Sample);
+        MAP_Angle_OK = MAP_Sample.seq != 0 && systime - MAP_Sample.time < MAP_SAMPLE_TIMEOUT;
+        MAP_Angle_Count = MAP_Sample.count;
+        V_MAP[0] = (MAP_Sample.count * ((MAX_AD_VOLTAGE / MAX_AD_COUNTS) * MAP_1_VOLTAGE_DIVIDER));
+        MAP[0] = table_lookup_lut(MAP_Sample.count, MAP_1_Table, &MAP_1_LUT);
         
         
         /* convert P1*/
-        Filter_AD(&V_P1_AD,3);  // smooth by 8
-        Pot_RPM = (V_P1_AD * ((MAX_AD_VOLTAGE / MAX_AD_COUNTS) * P1_VOLTAGE_DIVIDER ) ); 
+        Pot_RPM = (Scan.result[V_P1_AD] * ((MAX_AD_VOLTAGE / MAX_AD_COUNTS) * P1_VOLTAGE_DIVIDER ) );
         Pot_RPM=  3000* Pot_RPM;
         
     }
     
     Ref_MAP = MAP[0] * Inv_Ref_Pres;
-    Ref_Baro = MAP[2] *  Inv_Ref_Pres;
+    Ref_Baro = MAP[1] *  Inv_Ref_Pres;
     Ref_TPS = TPS * Inverse100;
 
 }                               // Get_Fast_Op_Vars()
+
+/**
+ * @brief  kPa per A/D count of the MAP 1 sensor around MAP[0]
+ * @note   for the per cylinder updates, which move the pass's fuel and spark along it
+ */
+
+#   define MAP_SLOPE_COUNTS 256
+
+float Get_MAP_Slope(void)
+{
+    uint16_t lo = MAP_Angle_Count;
+    uint16_t hi;
+
+    if (lo > (uint16_t)MAX_AD_COUNTS - 1 - MAP_SLOPE_COUNTS)
+        lo = (uint16_t)MAX_AD_COUNTS - 1 - MAP_SLOPE_COUNTS;
+    hi = lo + MAP_SLOPE_COUNTS;
+    return (table_lookup_lut(hi, MAP_1_Table, &MAP_1_LUT) - table_lookup_lut(lo, MAP_1_Table, &MAP_1_LUT)) * (1.0f / MAP_SLOPE_COUNTS);
+}
@@ -24,11 +24,25 @@ Portions Copyright 2011 Jon Zeeff - All rights reserved
 
 #include <stdint.h>
 #include "mpc563xm.h"
+#include "bsp.h"
 #include "eDMA_OPS.h"
 #include "err.h"
 #include "eQADC_OPS.h"
-
-static void Init_AD_DMA(int DMA_chan, void *cmd_source, void *cmd_dest, int cmd_count, void *rec_source, void *rec_dest, int rec_count);
+#include "cocoos.h"
+#include "MAP_Sample.h"
+
+#define ADC_Q0_DMA_CHAN    1             // RFIFO0 drain
+#define ADC_Q0_DMA_VECTOR  (11 + ADC_Q0_DMA_CHAN)    // eDMA channel n interrupts on INTC vector 11 + n
+#define ADC_Q0_DMA_PRIORITY 4           // below the angle clock
+#define ADC_Q3_DMA_CHAN    7             // RFIFO3 drain
+#define ADC_Q5_DMA_CHAN    11            // RFIFO5 drain
+#define ADC_Q5_DMA_VECTOR  (11 + ADC_Q5_DMA_CHAN)
+#define ADC_Q5_DMA_PRIORITY 5           // below the angle clock, a MAP burst is wanted sooner than a Q0 scan
+#define EQADC_FISR_RFOF    0x00080000    // FISR bit 12, write 1 to clear
+
+static void Init_AD_DMA(int DMA_chan, void *cmd_source, void *cmd_dest, int cmd_count, void *rec_source, vuint16_t *rec_dest, int rec_count, int ping_pong);
+static void ADC_Q0_DMA_ISR(void);
+static void ADC_Q5_DMA_ISR(void);
 
 /******************************************************************************************/
 /* FUNCTION     :  init_eDMA                                                              */
@@ -77,12 +91,18 @@ void init_eDMA(void)
 
     // Initialize A/D DMA channels that are being used (caution - time stamps are not supported)
     // Note: commands are 4 bytes, results are 2 bytes
-    Init_AD_DMA(0,  &ADC_CmdQ0, (void *)CFIFO0_PUSH, sizeof(ADC_CmdQ0) / 4, (void *)RFIFO0_POP, &ADC_RsltQ0, sizeof(ADC_RsltQ0) / 2);
-    Init_AD_DMA(2,  &ADC_CmdQ1, (void *)CFIFO1_PUSH, sizeof(ADC_CmdQ1) / 4, (void *)RFIFO1_POP, &ADC_RsltQ1, sizeof(ADC_RsltQ1) / 2);
-    Init_AD_DMA(4,  &ADC_CmdQ2, (void *)CFIFO2_PUSH, sizeof(ADC_CmdQ2) / 4, (void *)RFIFO2_POP, &ADC_RsltQ2, sizeof(ADC_RsltQ2) / 2);
-    Init_AD_DMA(6,  &ADC_CmdQ3, (void *)CFIFO3_PUSH, sizeof(ADC_CmdQ3) / 4, (void *)RFIFO3_POP, &ADC_RsltQ3, sizeof(ADC_RsltQ3) / 2);
-    Init_AD_DMA(8,  &ADC_CmdQ4, (void *)CFIFO4_PUSH, sizeof(ADC_CmdQ4) / 4, (void *)RFIFO4_POP, &ADC_RsltQ4, sizeof(ADC_RsltQ4) / 2);
-    Init_AD_DMA(10, &ADC_CmdQ5, (void *)CFIFO5_PUSH, sizeof(ADC_CmdQ5) / 4, (void *)RFIFO5_POP, &ADC_RsltQ5, sizeof(ADC_RsltQ5) / 2);
+    // Q0 results alternate between the two halves of ADC_Q0_Buf, one scan each, Q5 the same with one MAP window each
+    (void)bsp_vector_install(ADC_Q0_DMA_VECTOR, ADC_Q0_DMA_ISR);
+    bsp_vector_set_pri(ADC_Q0_DMA_VECTOR, ADC_Q0_DMA_PRIORITY);
+    (void)bsp_vector_install(ADC_Q5_DMA_VECTOR, ADC_Q5_DMA_ISR);
+    bsp_vector_set_pri(ADC_Q5_DMA_VECTOR, ADC_Q5_DMA_PRIORITY);
+    Init_AD_DMA(0,  &ADC_CmdQ0, (void *)CFIFO0_PUSH, sizeof(ADC_CmdQ0) / 4, (void *)RFIFO0_POP, ADC_Q0_Buf[0], sizeof(ADC_Q0_Buf[0]) / 2, 1);
+    Init_AD_DMA(2,  &ADC_CmdQ1, (void *)CFIFO1_PUSH, sizeof(ADC_CmdQ1) / 4, (void *)RFIFO1_POP, ADC_RsltQ1, sizeof(ADC_RsltQ1) / 2, 0);
+    Init_AD_DMA(4,  &ADC_CmdQ2, (void *)CFIFO2_PUSH, sizeof(ADC_CmdQ2) / 4, (void *)RFIFO2_POP, ADC_RsltQ2, sizeof(ADC_RsltQ2) / 2, 0);
+    Init_AD_DMA(6,  &ADC_CmdQ3, (void *)CFIFO3_PUSH, sizeof(ADC_CmdQ3) / 4, (void *)RFIFO3_POP, ADC_Q3_Buf[0], sizeof(ADC_CmdQ3) / 4, 0);
+    ADC_Q3_DMA_Start(0);        // Q3 results are a window at a time, see below
+    Init_AD_DMA(8,  &ADC_CmdQ4, (void *)CFIFO4_PUSH, sizeof(ADC_CmdQ4) / 4, (void *)RFIFO4_POP, ADC_RsltQ4, sizeof(ADC_RsltQ4) / 2, 0);
+    Init_AD_DMA(10, &ADC_CmdQ5, (void *)CFIFO5_PUSH, sizeof(ADC_CmdQ5) / 4, (void *)RFIFO5_POP, ADC_Q5_Buf[0], sizeof(ADC_Q5_Buf[0]) / 2, 1);
 
     // Check for DMA errors
     if (EDMA.ESR.R != 0)
@@ -92,13 +112,17 @@ void init_eDMA(void)
 
 
 // Set up the DMA controller for A/D
+// ping_pong: rec_dest is two scans long, results go to the first rec_count
+// entries then the next rec_count, with an interrupt as each half completes
 
 void
-Init_AD_DMA(int DMA_chan, void *cmd_source, void *cmd_dest, int cmd_count, void *rec_source, void *rec_dest, int rec_count)
+Init_AD_DMA(int DMA_chan, void *cmd_source, void *cmd_dest, int cmd_count, void *rec_source, vuint16_t *rec_dest, int rec_count, int ping_pong)
 {
     if (cmd_count != rec_count) {
        err_push( CODE_OLDJUNK_FE );       
     }
+    if (ping_pong)
+       rec_count *= 2;
 
     // Think of these as memcpy() subroutines that gets executed whenever a given DMA channel is triggered
 
@@ -106,8 +130,8 @@ Init_AD_DMA(int DMA_chan, void *cmd_source, void *cmd_dest, int cmd_count, void
     EDMA.CERQR.R = (uint8_t)DMA_chan+1;     		// disable this channel
 
     /* Transfer Control Descriptor for CFIFO 00 - CH0-see RM 9.3.1.16, 9-23, pg 335          */
-    EDMA.TCD[DMA_chan].SADDR = (uint32_t)cmd_source;   //Start Address
-    EDMA.TCD[DMA_chan].DADDR = (uint32_t)cmd_dest;    //Destination Address
+    EDMA.TCD[DMA_chan].SADDR = (uint32_t)(uintptr_t)cmd_source;   //Start Address
+    EDMA.TCD[DMA_chan].DADDR = (uint32_t)(uintptr_t)cmd_dest;    //Destination Address
     EDMA.TCD[DMA_chan].DSIZE = 0x02;   //Destination Transfer Size:32 bits
     EDMA.TCD[DMA_chan].SSIZE = 0x02;   //Source Transfer Size:32 bits
     EDMA.TCD[DMA_chan].SOFF = 0x4;     //Signed Source Address Offset in bytes
@@ -121,8 +145,8 @@ Init_AD_DMA(int DMA_chan, void *cmd_source, void *cmd_dest, int cmd_count, void
     Zero_DMA_Channel(DMA_chan);
 
     /* Transfer Control Descriptor for RFIFO 00 - CH1-see RM 9.3.1.16, 9-23, pg 335          */
-    EDMA.TCD[DMA_chan+1].SADDR = (uint32_t)rec_source;     //Start Address
-    EDMA.TCD[DMA_chan+1].DADDR = (uint32_t)rec_dest;       //Destination Address
+    EDMA.TCD[DMA_chan+1].SADDR = (uint32_t)(uintptr_t)rec_source;     //Start Address
+    EDMA.TCD[DMA_chan+1].DADDR = (uint32_t)(uintptr_t)rec_dest;       //Destination Address
     EDMA.TCD[DMA_chan+1].DSIZE = 0x01;   //Destination Transfer Size:16 bits
     EDMA.TCD[DMA_chan+1].SSIZE = 0x01;   //Source Transfer Size:16 bits
     EDMA.TCD[DMA_chan+1].SOFF = 0x0;     //Signed Source Address Offset
@@ -134,6 +158,10 @@ Init_AD_DMA(int DMA_chan, void *cmd_source, void *cmd_dest, int cmd_count, void
     EDMA.TCD[DMA_chan+1].CITER = rec_count; 	//Current 'Major' Iteration Count:  Disabled
     EDMA.TCD[DMA_chan+1].D_REQ = 0x0;    //Disables DMA Channel When Done
     Zero_DMA_Channel(DMA_chan+1);
+    if (ping_pong) {
+        EDMA.TCD[DMA_chan+1].INT_HALF = 1;  // first scan done
+        EDMA.TCD[DMA_chan+1].INT_MAJ = 1;   // second scan done
+    }
 
     //EDMA.CPR[DMA_chan].R   = 0x04;      // Priority x, Channel Preemption is Disabled
     //EDMA.CPR[DMA_chan+1].R = 0x05;      // Priority x, Channel Preemption is Disabled
@@ -142,6 +170,56 @@ Init_AD_DMA(int DMA_chan, void *cmd_source, void *cmd_dest, int cmd_count, void
     EDMA.SERQR.R = (uint8_t)DMA_chan+1;     	    // enable this channel
 }
 
+// Q0 result DMA finished a scan, CITER tells which half it is writing now
+
+static void
+ADC_Q0_DMA_ISR(void)
+{
+    EDMA.CIRQR.R = ADC_Q0_DMA_CHAN;
+    ADC_Scan_Done(EDMA.TCD[ADC_Q0_DMA_CHAN].CITER > ADC_Q0_SIZE ? 1 : 0);
+}
+
+// Q5 result DMA finished a MAP window's burst, same halves as Q0
+
+static void
+ADC_Q5_DMA_ISR(void)
+{
+    EDMA.CIRQR.R = ADC_Q5_DMA_CHAN;
+    MAP_Burst_Done(EDMA.TCD[ADC_Q5_DMA_CHAN].CITER > ADC_Q5_SIZE ? 1 : 0);
+}
+
+// Point the Q3 (knock) result DMA at the start of ADC_Q3_Buf[buf].  It stops by itself
+// when the buffer is full, the RFIFO then overflows until the next start
+
+void
+ADC_Q3_DMA_Start(uint8_t buf)
+{
+    EDMA.CERQR.R = ADC_Q3_DMA_CHAN;     // disable this channel
+
+    // results left over from the last window would start this one
+    while (EQADC.FISR[3].B.RFCTR != 0)
+        (void)EQADC.RFPR[3].R;
+    // FISR flags are write 1 to clear, a bit-field write would clear any other flag that is set
+    EQADC.FISR[3].R = EQADC_FISR_RFOF;
+
+    EDMA.TCD[ADC_Q3_DMA_CHAN].DADDR = (uint32_t)(uintptr_t)&ADC_Q3_Buf[buf][0];
+    EDMA.TCD[ADC_Q3_DMA_CHAN].DLAST_SGA = 0x0;
+    EDMA.TCD[ADC_Q3_DMA_CHAN].BITER = ADC_Q3_SIZE;
+    EDMA.TCD[ADC_Q3_DMA_CHAN].CITER = ADC_Q3_SIZE;
+    EDMA.TCD[ADC_Q3_DMA_CHAN].D_REQ = 0x1;      // disable this channel when the buffer is full
+    EDMA.TCD[ADC_Q3_DMA_CHAN].DONE = 0x0;
+
+    EDMA.SERQR.R = ADC_Q3_DMA_CHAN;     // enable this channel
+}
+
+// Results the Q3 DMA has put in ADC_Q3_Buf[buf] since ADC_Q3_DMA_Start(buf)
+
+uint16_t
+ADC_Q3_DMA_Count(uint8_t buf)
+{
+    return (uint16_t)((EDMA.TCD[ADC_Q3_DMA_CHAN].DADDR - (uint32_t)(uintptr_t)&ADC_Q3_Buf[buf][0]) / 2);
+}
+
 // The values we don't use
 
 void
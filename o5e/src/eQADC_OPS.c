@@ -20,21 +20,23 @@ Portions Copyright 2011, 2012  Jon Zeeff - All rights reserved
 
 #include <stdint.h>
 #include "mpc563xm.h"
+#include "bsp.h"
 #include "eQADC_OPS.h"
+#include "AD_Filter.h"
 
-uint32_t ADC_CmdQ0[40];
+uint32_t ADC_CmdQ0[ADC_Q0_SIZE];
 uint32_t ADC_CmdQ1[1];
 uint32_t ADC_CmdQ2[1];
 uint32_t ADC_CmdQ3[1];
 uint32_t ADC_CmdQ4[1];
-uint32_t ADC_CmdQ5[1];
+uint32_t ADC_CmdQ5[ADC_Q5_SIZE];
 
-vuint16_t ADC_RsltQ0[40];
+vuint16_t ADC_Q0_Buf[2][ADC_Q0_SIZE];
 vuint16_t ADC_RsltQ1[1];
 vuint16_t ADC_RsltQ2[1];
-vuint16_t ADC_RsltQ3[1];
+vuint16_t ADC_Q3_Buf[2][ADC_Q3_SIZE];
 vuint16_t ADC_RsltQ4[1];
-vuint16_t ADC_RsltQ5[1];
+vuint16_t ADC_Q5_Buf[2][ADC_Q5_SIZE];
 
 /*******************************************************************************************
  FUNCTION     : init_ADC                                                                   
@@ -63,18 +65,22 @@ void init_ADC(void)
 #define EOQ 		(1UL << (31-0))
 
     // Convert all 40 A/D channels (CmdQ 0 -> ResultQ 0), triggered by eMIOS10
-    for (i = 0; i < 39;  ++i) 
+    for (i = 0; i < ADC_Q0_SIZE - 1;  ++i) 
         ADC_CmdQ0[i] = (uint32_t)(ADC(0) | LST(1) | RFIFO(0) | CHANNEL(i));
-    ADC_CmdQ0[39] = ADC(0) | RFIFO(0) | CHANNEL(39) | PAUSE;
+    ADC_CmdQ0[ADC_Q0_SIZE - 1] = ADC(0) | RFIFO(0) | CHANNEL((ADC_Q0_SIZE - 1)) | PAUSE;
 
     // ADC1, Q1 is triggered by eMIOS11
     ADC_CmdQ1[0] = ADC(1) | RFIFO(1) | CHANNEL(17) | PAUSE;     // Convert POT, AN17
     ADC_CmdQ2[0] = ADC(1) | RFIFO(2) | CHANNEL(40) | PAUSE;     // Convert VRH
-    ADC_CmdQ3[0] = ADC(1) | RFIFO(3) | CHANNEL(41) | PAUSE;     // Convert VRL
+    // Q3 converts knock back to back for as long as the eTPU knock window is high, ADC_Q3_RATE
+    // (about 47k samples/sec) at 64 sample clocks.  Q5 (MAP) shares ADC1 and waits if it lands in a knock window
+    ADC_CmdQ3[0] = ADC(1) | LST(2) | RFIFO(3) | CHANNEL(ADC_KNOCK_CHANNEL);
     ADC_CmdQ4[0] = ADC(1) | RFIFO(4) | CHANNEL(17) | PAUSE;     // Convert POT
 
-    // Q5 is triggered by the eTPU knock window for MAP
-    ADC_CmdQ5[0] = ADC(1) | LST(1) | RFIFO(5) | CHANNEL(27) | PAUSE;     // Convert POT, AN17.  TODO change
+    // Q5 is triggered by the eTPU window on MAP_WINDOW_CHANNEL, a burst of MAP conversions per window
+    for (i = 0; i < ADC_Q5_SIZE - 1; ++i)
+        ADC_CmdQ5[i] = (uint32_t)(ADC(1) | LST(1) | RFIFO(5) | CHANNEL(ADC_MAP_CHANNEL));
+    ADC_CmdQ5[ADC_Q5_SIZE - 1] = ADC(1) | LST(1) | RFIFO(5) | CHANNEL(ADC_MAP_CHANNEL) | PAUSE;
 
     // Angle triggered Queue-On ADC2=B/N=1, RFIFO2=Msg Tag=1 , eMIOS 14 trigger
     //ADC_CmdQ3[0] = (3 << 20) | (96 << 8);             // Disable Time Stamp ; 
@@ -126,9 +132,9 @@ void init_ADC(void)
     // EQADC.CFPR[0].R = ADC_ADDRESS(3) | 0;        // ADC_TBCR = 0x0000     
 
     // eQADC Initialize ADC0 Control Register, set A/D clock
-    EQADC.CFPR[0].R = ADC_ADDRESS(1) | BN(0) | ADC_REGISTER(AD_ENABLE | AD_CLOCK(0xA));
+    EQADC.CFPR[0].R = ADC_ADDRESS(1) | BN(0) | ADC_REGISTER(AD_ENABLE | AD_CLOCK(ADC_CLOCK_PS));
     // eQADC Initialize ADC1 Control Register, set A/D clock
-    EQADC.CFPR[0].R = ADC_ADDRESS(1) | BN(1) | ADC_REGISTER(AD_ENABLE | AD_CLOCK(0xA)) | EOQ;
+    EQADC.CFPR[0].R = ADC_ADDRESS(1) | BN(1) | ADC_REGISTER(AD_ENABLE | AD_CLOCK(ADC_CLOCK_PS)) | EOQ;
 
     // CFIFO Trigger Mode Constants
 #define DISABLE_Q 0x0
@@ -191,7 +197,7 @@ void init_ADC(void)
     EQADC.CFCR[0].B.MODE = RISING_EXT_SS;       // Rising Edge Ext.Trigger, Single Scan
     EQADC.CFCR[1].B.MODE = RISING_EXT_SS;       // Rising Edge Ext.Trigger, Single Scan
     EQADC.CFCR[2].B.MODE = RISING_EXT_SS;       // Rising Edge Ext.Trigger, Single Scan
-    EQADC.CFCR[3].B.MODE = RISING_EXT_SS;       // Rising Edge Ext.Trigger, Single Scan
+    EQADC.CFCR[3].B.MODE = HIGH_GATED_EXT_CS;   // Knock, continuous scan while the window is open
     EQADC.CFCR[4].B.MODE = RISING_EXT_SS;       // Rising Edge Ext.Trigger, Single Scan
     EQADC.CFCR[5].B.MODE = RISING_EXT_SS;       // Rising Edge Ext.Trigger, Single Scan
 
@@ -220,3 +226,49 @@ void init_ADC(void)
     SIU.ETISR.B.TSEL5 = 0x1;    // eTPU 26 or eMIOS 12  MAP
 
 }                               // init_ADC()
+
+static struct adc_scan Scan_Out[2];    // newest complete scan and the one being built
+static volatile uint8_t Scan_Cur;       // Scan_Out[] holding the newest complete scan
+static volatile uint32_t Scan_Seq;      // scans completed, bumped after Scan_Cur is set
+
+/**
+ * @brief  Filter and publish a complete Q0 scan, called from the RFIFO0 DMA interrupt
+ * @param  buf  the half of ADC_Q0_Buf the DMA just finished, it is now
+ *              writing the other one
+ */
+
+void ADC_Scan_Done(uint8_t buf)
+{
+    struct adc_scan *const scan = &Scan_Out[Scan_Cur ^ 1];
+    uint8_t i;
+
+    for (i = 0; i < ADC_Q0_SIZE; ++i)
+        scan->raw[i] = ADC_Q0_Buf[buf][i];
+    AD_Filter_Scan(scan->raw, scan->result, bsp_get_timebase_lower());
+    scan->time = systime;
+    scan->seq = Scan_Seq + 1;
+
+    Scan_Cur ^= 1;
+    Scan_Seq = scan->seq;
+}
+
+/**
+ * @brief  Copy the newest complete Q0 scan
+ * @return 1 if it is a newer scan than the one already in *scan
+ * @note   the interrupt only rewrites a published scan after the next one
+ *         is out, so if a scan completes during the copy it is done again.
+ *         A scan takes far longer than the copy, so it is never done more than twice
+ */
+
+uint8_t ADC_Scan_Read(struct adc_scan *scan)
+{
+    uint32_t const prev = scan->seq;
+    uint32_t seq;
+
+    do {
+        seq = Scan_Seq;
+        *scan = Scan_Out[Scan_Cur];
+    } while (seq != Scan_Seq || seq != scan->seq);
+
+    return seq != prev;
+}
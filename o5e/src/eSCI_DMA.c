@@ -40,7 +40,7 @@ void init_eSCI_DMA(void)
     EDMA.TCD[18].SSIZE = 0;     /* Read 2**0 = 1 byte per transfer */
     EDMA.TCD[18].SOFF = 1;      /* After transfer, add 1 to src addr */
     EDMA.TCD[18].SLAST = 0;     /* COUNT After major loop, reset src addr */
-    EDMA.TCD[18].DADDR = (uint32_t) & ESCI_A.DR.B.D;    /* Load address of destination */
+    EDMA.TCD[18].DADDR = (uint32_t) & ESCI_A.DR + 1;   /* Load address of destination, DR.B.D */
     EDMA.TCD[18].DSIZE = 0;     /* Write 2**0 = 1 byte per transfer */
     EDMA.TCD[18].DOFF = 0;      /* Do not increment destination addr */
     EDMA.TCD[18].DLAST_SGA = 0; /* After major loop, no dest addr change */
@@ -52,7 +52,7 @@ void init_eSCI_DMA(void)
 
     // receive for SCI A
     EDMA.CERQR.R = 19;          /* stop DMA on this channel */
-    EDMA.TCD[19].SADDR = (uint32_t) & ESCI_A.DR.B.D;    /* Load address of source data */
+    EDMA.TCD[19].SADDR = (uint32_t) & ESCI_A.DR + 1;   /* Load address of source data, DR.B.D */
     EDMA.TCD[19].SSIZE = 0;     /* Read 2**0 = 1 byte per transfer */
     EDMA.TCD[19].SOFF = 0;      /* After transfer, add 0 to src addr */
     EDMA.TCD[19].SLAST = 0;     /* After major loop, don't reset src addr */
@@ -33,6 +33,10 @@
 #include "eTPU_OPS.h"
 #include "etpu_fpm.h"
 #include "main.h"   /**< pickup msec_clock */
+#include "Angle_Clock.h"
+#include "cocoos.h"
+#include "MAP_Sample.h"
+#include "Knock.h"
 
 uint8_t N_Injectors;
 uint8_t N_Coils;
@@ -248,6 +252,11 @@ int32_t init_eTPU()
     if (error_code != 0) 
         err_push( CODE_OLDJUNK_DE );
 
+    // crank angle clock interrupts, MAP and knock windows, all need the cam channel set up above
+    Angle_Clock_Init();
+    MAP_Sample_Init();
+    Knock_Init();
+
 #ifdef SIMULATOR
     // Engine crank/cam simulator for testing
     // Note: uses only rising edges
@@ -33,11 +33,11 @@ Copyright (c) 2012 Sean Stasiak <sstasiak at gmail dot com>
 #include "Testing_OPS.h"
 #include "Fake_Cam_Signal.h"
 #include "Optional_Output_Ops.h"
+#include "Angle_Clock.h"
 
 
 
 static void Angle_Clock_Task(void);
-static Evt_t event;             // dummy event for angle task
 static void LED_Task(void);
 
 // Note: CocoOS allows less critical tasks to run less frequently and prevents spagetti code caused by state machines
@@ -60,6 +60,7 @@ void main( void )
     /* classic misunderstanding above TODO: remove */
     
     if (Flash_OK != 0) {        // don't run these with nonsense flash values 
+        Cyl_Events_Init();      // per cylinder fuel and spark on the crank angle, before os_start()
         (void)task_create(Engine10_Task, 0 + 128, 0, 0, 0);      // create the task
         (void)task_create(Fuel_Pump_Task, 1 + 128, 0, 0, 0);     // create the task
         (void)task_create(Slow_Vars_Task, 2 + 128, 0, 0, 0);     // create the task
@@ -87,61 +88,45 @@ void main( void )
     (void)task_create(LED_Task, 11 + 128, 0, 0, 0);             // create the task 
 
     //this should always be last
-    (void)task_create(Angle_Clock_Task, 254, 0, 0, 0);         // task to update angle clock, always last
+    (void)task_create(Angle_Clock_Task, 254, 0, 0, 0);         // task to watch crank sync for the angle clock, always last
 
   os_start();
 }
 
 static void Angle_Clock_Task(void)
 {
-    static uint32_t prev_angle; // previous cam position in ticks
-    static uint32_t i;   
-    register uint64_t j =0;
     static int8_t status;
     static int8_t Previous_Status;
     static uint32_t Start_Time;     // time when start started
 	static uint32_t Start_Degrees;  // engine position when start started
 
-    
-#define ANGLE_TICKS_PER_DEGREE ((Ticks_Per_Tooth * (N_Teeth + Missing_Teeth)) / 360)
     task_open();                // NOTE: must be first line
 
-
-// previous cam position in ticks
-
+    // Degree_Clock and the os angle clock are moved by the angle clock interrupt (Angle_Clock.c),
+    // this only restarts them when sync changes and keeps the post start counters
     for (;;) {
 
         status = fs_etpu_eng_pos_get_engine_position_status ();
       	if  (Previous_Status != status || status != FS_ETPU_ENG_POS_FULL_SYNC){  //position known so fuel and spark have started
-            Degree_Clock = 0;;
-            prev_angle = angle_clock();
+            Angle_Clock_Restart();
             Start_Time = systime;
             Start_Degrees = Degree_Clock;
             Post_Start_Time = 0;
             Post_Start_Cycles = 0;
             Previous_Status = status;
         }
+        Angle_Clock_Update();   // windows follow the angle events
 
-        
-        // update crank shaft degree/angle clock (free running, not synced to an absolute engine position)
-//Match the degrees per tic to the eTPU settings
-        i = (angle_clock() - prev_angle) & 0xffffff;    // 24 bit hw counter 
-        j = i * (((uint64_t)1 << 32) / ANGLE_TICKS_PER_DEGREE);        // avoid a run time divide
-        i = (uint32_t) (j >> 32);       // convert back to bin 0
-        if (i > 0) {            // delta full degrees
-            Degree_Clock += i;
-            prev_angle = (prev_angle + i * ANGLE_TICKS_PER_DEGREE) & 0xffffff;
-            os_task_tick(1, (uint16_t) i);      // increment os angle clock value
-        } 
                       // maintain some timers for use by enrichment
-         //update + make sure the timers don't overflow  - TODO eliminate divides
+         //update + make sure the timers don't overflow
+         // x/1000 == (x * 274877907) >> 38 and x/720 == ((x >> 4) * 95443718) >> 32, exact for any 32 bit x
         if (Post_Start_Time < 10000)
-           Post_Start_Time = (uint32_t)(systime - Start_Time) / 1000;
+           Post_Start_Time = (uint32_t)(((uint64_t)(systime - Start_Time) * 274877907) >> 38);
         if (Post_Start_Cycles < 10000)
-            Post_Start_Cycles = (uint16_t)(Degree_Clock - Start_Degrees) / 720;
-        event_signal(event);    // dummy to cause task change - all higher priority tasks will be run
+            Post_Start_Cycles = (uint16_t)((((uint64_t)((Degree_Clock - Start_Degrees) >> 4)) * 95443718) >> 32);
+
+        task_wait(10);          // sync is lost in far less than this and nothing here needs it sooner
 
-        
      } // for ever
     
     task_close();
@@ -16,12 +16,13 @@
 
 #include <stdint.h>
 #include "variables.h"
+#include "Table_Lookup.h"
 #include "err.h"
 #include "FLASH_OPS.h"    /**< pickup xx_BASE #define's */
 
 struct Outputs Output_Channels;
 
-uint16_t const pageSize[NPAGES] = {1768,1664,1756,1760,1620,1668,1668,1668,1668,1808,1808,1808 };
+uint16_t const pageSize[NPAGES] = {1768,1664,1756,1760,1832,1668,1668,1668,1668,1808,1808,1808 };
 // Current flash or ram location of each page
 volatile uint8_t *Page_Ptr[NPAGES];
 // Ram buffer to store a single page before writing to flash
@@ -29,6 +30,8 @@ uint8_t Ram_Page_Buffer[MAX_PAGE_SIZE];
 int8_t Ram_Page_Buffer_Page;	// which page # is in the buffer (-1 means none)
 int Flash_OK;		// is flash empty or has values
 uint8_t Burn_Count;		// how many flash burns 
+uint8_t Page_Valid[NPAGES];	// all tables on the page are a usable size
+volatile uint32_t Page_Generation;	// bumped every time any page moves or changes
 
 uint8_t Flash_Block;		// flash block currently being used - 0=BLK1B_BASE or 1=BLK2A_BASE
 uint8_t *Flash_Addr[2] = { (uint8_t *)BLK1B_BASE, (uint8_t *)BLK2A_BASE };
@@ -66,7 +69,16 @@ init_variables(void)
      for (;;) {}
   }
 
-  // TODO - perform sanity checks on all of flash
+  // check every table once here so the lookups don't have to
+  if (Flash_OK) {
+      uint8_t i;
+
+      for (i = 0; i < NPAGES; ++i) {
+          Page_Changed(i);
+          if (!Page_Valid[i])
+              Flash_OK = 0;      // don't run the engine on a broken table
+      }
+  }
 
 } // init_variables()
 
@@ -87,4 +99,62 @@ Set_Page_Locations(uint8_t block)
 
   Flash_Block = block;		        // save which block we are using
   Ram_Page_Buffer_Page = -1;            // mark as unused
+  ++Page_Generation;                    // contents are the same but every table moved
+}
+
+
+// Call after anything on a page is changed (boot, tuner write).
+// Checks the page's tables and bumps Page_Generation so anything
+// cached from the tables gets rebuilt
+
+void
+Page_Changed(uint8_t page)
+{
+  Page_Valid[page] = (Check_Page_Tables(page) == 0);
+  ++Page_Generation;
+}
+
+
+// Run table_check() on every table that lives on this page, logging any problems.
+// Returns the number of tables with a bad size (0 is good).  Unsorted axes are only
+// logged - the lookup stays inside the table, the values are just wrong, same as before.
+// (the example tune ships with an unsorted Lambda_Set_Point axis)
+// A problem is logged once when it shows up, not again on every tuner write after.
+
+uint8_t
+Check_Page_Tables(uint8_t page)
+{
+  uint8_t i;
+  uint8_t bad = 0;
+  uint32_t code;
+  const uint8_t *start = (const uint8_t *)Page_Ptr[page];
+
+  // from variables.h, order doesn't matter
+  CONST struct table * const tables[] = {
+      sqrt_Table, Prime_Corr_Table, Prime_Decay_Table, Man_Crank_Corr_Table,
+      Fuel_Temp_Corr_Table, IAT_Fuel_Corr_Table, Dwell_Table, Inj_Dead_Time_Table, MAP_Angle_Table,
+      Accel_Limit_Table, Accel_Decay_Table, Accel_Sensativity_Table,
+      Decel_Limit_Table, Decel_Decay_Table, Decel_Sensativity_Table,
+      TPS_Flow_Table, CLT_Table, IAT_Table, TPS_Table, Lambda_1_Table,
+      Lambda_2_Table, MAF_1_Table, MAF_2_Table, MAP_1_Table, MAP_2_Table,
+      Inj_Time_Corr_Table, Inj_End_Angle_Table, Spark_Advance_Table, Lambda_Set_Point_Table,
+      Cyl_Trim_1_Table, Cyl_Trim_2_Table, Cyl_Trim_3_Table, Cyl_Trim_4_Table,
+      Cyl_Trim_5_Table, Cyl_Trim_6_Table, Cyl_Trim_7_Table, Cyl_Trim_8_Table,
+      Coil_Trim_1_Table, Coil_Trim_2_Table, Coil_Trim_3_Table, Coil_Trim_4_Table
+  };
+  static uint32_t last_code[sizeof(tables) / sizeof(tables[0])];   // CODE_NONE to start
+
+  for (i = 0; i < sizeof(tables) / sizeof(tables[0]); ++i) {
+      // skip tables on other pages
+      if ((const uint8_t *)tables[i] < start || (const uint8_t *)tables[i] >= start + MAX_PAGE_SIZE)
+          continue;
+      code = table_check(tables[i]);
+      if (code != CODE_NONE && code != last_code[i])
+          err_push( code );
+      last_code[i] = code;
+      if (code == CODE_OLDJUNK_FC)      // rows/cols out of range, lookup would run off the table
+          ++bad;
+  }
+
+  return bad;
 }
@@ -73,6 +73,11 @@ __start:
     lis     r13, _SDA_BASE_@ha              # defined by linker
     addi    r13, r13, _SDA_BASE_@l
 
+    # fill the rest of the stack with a known pattern, the first
+    # word found changed is the high water mark (bsp_stack_used)
+    .extern bsp_stack_paint
+    bl      bsp_stack_paint
+
     # c/c++ runtime init
     .extern __init
     bl      __init
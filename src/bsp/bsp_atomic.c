@@ -0,0 +1,74 @@
+/**
+ * @file       bsp_atomic.c
+ * @headerfile bsp.h
+ * @brief      lock free word operations
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ */
+
+#include <stdint.h>
+#include "bsp.h"
+
+/* --| TYPES    |--------------------------------------------------------- */
+/* --| STATICS  |--------------------------------------------------------- */
+/* --| INLINES  |--------------------------------------------------------- */
+/* --| INTERNAL |--------------------------------------------------------- */
+/* --| PUBLIC   |--------------------------------------------------------- */
+#if __CWCC__
+/**
+ * @public
+ * @brief *p += v without masking interrupts
+ * @retval uint32_t the new value
+ * @note an interrupt that writes *p between the lwarx and stwcx. takes
+ *       the reservation with it, so the stwcx. fails and we go again
+ */
+asm uint32_t
+  bsp_atomic_add( volatile uint32_t *p, uint32_t v )
+{
+  nofralloc
+@retry:
+  lwarx   r5, 0, r3
+  add     r5, r5, r4
+  stwcx.  r5, 0, r3
+  bne-    @retry
+  mr      r3, r5
+  blr
+}
+
+/**
+ * @public
+ * @brief *p = new if *p == old, without masking interrupts
+ * @retval int !0 if the swap was made
+ */
+asm int
+  bsp_atomic_cas( volatile uint32_t *p, uint32_t old, uint32_t new_ )
+{
+  nofralloc
+@retry:
+  lwarx   r6, 0, r3
+  cmpw    r6, r4
+  bne-    @fail
+  stwcx.  r5, 0, r3
+  bne-    @retry
+  li      r3, 1
+  blr
+@fail:
+  li      r3, 0
+  blr
+}
+#else
+uint32_t
+  bsp_atomic_add( volatile uint32_t *p, uint32_t v )
+{
+  return __sync_add_and_fetch( p, v );
+}
+
+int
+  bsp_atomic_cas( volatile uint32_t *p, uint32_t old, uint32_t new_ )
+{
+  return __sync_bool_compare_and_swap( p, old, new_ );
+}
+#endif
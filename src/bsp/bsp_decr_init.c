@@ -27,7 +27,7 @@
 asm void
   bsp_decr_init( void )
 {
-  enum { RATE = ((80000000/1000)-1) }; /**< 1000Hz at 80MHz                */
+  enum { RATE = (BSP_DECR_PERIOD-1) };  /**< 1000Hz at 80MHz                */
   fralloc
 
   xor     r0, r0, r0
@@ -0,0 +1,45 @@
+/**
+ * @file       bsp_decr_set.c
+ * @headerfile bsp.h
+ * @brief      one-shot decrementer reloads for tickless idle
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ */
+
+#include <stdint.h>
+#include "bsp.h"
+
+/* --| TYPES    |--------------------------------------------------------- */
+/* --| STATICS  |--------------------------------------------------------- */
+/* --| INLINES  |--------------------------------------------------------- */
+/* --| INTERNAL |--------------------------------------------------------- */
+/* --| PUBLIC   |--------------------------------------------------------- */
+/**
+ * @public
+ * @brief load the decrementer, next tick in 'ticks' core clocks
+ * @note the periodic reload value is left alone, so ticks carry on
+ *       every BSP_DECR_PERIOD after this one fires
+ */
+asm void
+  bsp_decr_set( uint32_t ticks )
+{
+  nofralloc
+  mtdec   r3
+  blr
+}
+
+/**
+ * @public
+ * @brief drop a pending decrementer interrupt
+ */
+asm void
+  bsp_decr_ack( void )
+{
+  nofralloc
+  lis     r0, (1<<11)
+  mttsr   r0                           /**< TSR[DIS] is write 1 to clear   */
+  blr
+}
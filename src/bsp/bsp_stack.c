@@ -0,0 +1,80 @@
+/**
+ * @file       bsp_stack.c
+ * @headerfile bsp.h
+ * @brief      stack painting and ram usage
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ */
+
+#include <stdint.h>
+#include "bsp.h"
+
+/* --| TYPES    |--------------------------------------------------------- */
+/* --| STATICS  |--------------------------------------------------------- */
+/**
+ * linker script supplied, see lcf/mpc5634.lcf
+ */
+extern uint32_t _stack_end[];           /**< lowest stack address          */
+extern uint32_t _stack_addr[];          /**< initial sp, stack grows down  */
+extern uint8_t  _static_ram_start[];
+extern uint8_t  _static_ram_end[];
+
+/* --| INLINES  |--------------------------------------------------------- */
+/* --| INTERNAL |--------------------------------------------------------- */
+/* --| PUBLIC   |--------------------------------------------------------- */
+/**
+ * @public
+ * @brief fill the unused stack with BSP_STACK_PAINT
+ * @note called from __start before the c runtime is up, so no statics.
+ *       stops a little short of our own frame
+ */
+void
+  bsp_stack_paint( void )
+{
+  volatile uint32_t here;
+  uint32_t *p   = _stack_end;
+  uint32_t *end = (uint32_t *)&here - 16;
+
+  while( p < end )
+    *p++ = BSP_STACK_PAINT;
+}
+
+/**
+ * @public
+ * @brief stack size in bytes
+ */
+uint32_t
+  bsp_stack_size( void )
+{
+  return (uint32_t)((uint8_t *)_stack_addr - (uint8_t *)_stack_end);
+}
+
+/**
+ * @public
+ * @brief deepest stack use since reset, in bytes
+ * @note scans up from the bottom for the first word that isn't paint,
+ *       interrupts share the stack so they are included
+ */
+uint32_t
+  bsp_stack_used( void )
+{
+  uint32_t const *p = _stack_end;
+
+  while( p < _stack_addr && *p == BSP_STACK_PAINT )
+    ++p;
+  return (uint32_t)((uint8_t *)_stack_addr - (uint8_t *)p);
+}
+
+/**
+ * @public
+ * @brief bytes of ram taken by vectors, ramfuncs and .sdata/.sbss/.data/.bss
+ * @note the 32k map cache below them is not included
+ */
+uint32_t
+  bsp_static_ram( void )
+{
+  return (uint32_t)(_static_ram_end - _static_ram_start);
+}
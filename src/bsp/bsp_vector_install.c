@@ -2,7 +2,8 @@
  * @file       bsp_vector_install.c
  * @headerfile bsp.h
  * @author     sstasiak
- * @brief      install caller suppplied vector handler dynamically
+ * @brief      install caller suppplied vector handler dynamically, and
+ *             set its priority
  * @attention  { not for use in safety critical systems       }
  * @attention  { not for use in pollution controlled vehicles }
  *
@@ -11,6 +12,7 @@
  */
  
 #include <stdint.h>
+#include "mpc563xm.h"
 #include "trap.h"
 #include "bsp.h"
 #include "bsp_prv.h"
@@ -48,4 +50,20 @@ vector_fptr_t
   bsp_enable_interrupts();
 
   return prev_fptr;
-}
\ No newline at end of file
+}
+/**
+ * @public
+ * @brief set priority of designated vector
+ * @param[in] vector vector number as specified by RM
+ * @param[in] pri priority of 0 to 15
+ * @retval none
+ */
+void
+  bsp_vector_set_pri( int vector,
+                      unsigned pri )
+{
+  trap( vector < 210 );
+  trap( pri <= 15 );
+
+  INTC.PSR[vector].R = (uint8_t)pri;  /**< 0 leaves the source masked    */
+}
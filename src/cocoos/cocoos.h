@@ -110,6 +110,16 @@
 								OS_SCHEDULE;\
 						   	   } while ( 0 )
 
+#define OS_WAIT_UNTIL(t)	do {\
+								os_task_wait_until_set( running_tid, t );\
+								OS_SCHEDULE;\
+						   	   } while ( 0 )
+
+#define OS_WAIT_PERIOD(p)	do {\
+								os_task_wait_period_set( running_tid, p );\
+								OS_SCHEDULE;\
+						   	   } while ( 0 )
+
 
 
 extern uint8_t running_tid;
@@ -139,7 +139,7 @@ static void myTask(void) {
 *   When the wait time has expired, the task is ready to execute again and will continue
 *   at the next statement when the task is scheduled to run.
 *
-*       @param id Sub clock id. Valid range 1-255.		
+*       @param id Sub clock id. Valid range 1 to N_CLOCKS-1.		
 *       
 *       @param x Number of sub clock ticks to wait, 16 bit value.
 *		
@@ -158,6 +158,65 @@ static void myTask(void) {
  *******************************************************************************/
 #define task_wait_id(id,x)                OS_WAIT_TICKS(x,id)
 
+
+/*********************************************************************************/
+/*  task_wait_until(t)                                                 *//**
+*   
+*   Macro for suspending a task until the master clock reaches an absolute count.
+*   If that count has already gone by the task is ready again straight away.
+*
+*       @param t Master clock count to wait for, at most 65535 ticks ahead. The
+*       current count is os_task_clock_get( 0 ).
+*		
+*		@remarks \b Usage: @n 
+* @code 
+
+
+static void myTask(void) {
+ static uint32_t next;
+ task_open();	
+  next = os_task_clock_get( 0 );
+  ...
+  next += 10;
+  task_wait_until( next );
+  ...
+ task_close();
+}
+ @endcode 
+ *******************************************************************************/
+#define task_wait_until(t)          OS_WAIT_UNTIL(t)
+
+
+/*********************************************************************************/
+/*  task_period(p)                                                 *//**
+*   
+*   Macro for running a task at a fixed rate. Suspends the task until its next
+*   release, releases are p master clock ticks apart starting from the first call,
+*   so the task's own run time doesn't stretch the period the way task_wait() does.
+*   Asking after the next release has already gone by counts an overrun in the
+*   task statistics, see os_task_stats_get().
+*
+*		@param p Period in master clock ticks, 16 bit value. Changing it restarts
+*       the releases from now, so does an event wait or task_wait_until() in
+*       between - a task can switch between task_period() and event_wait_timeout()
+*       without the time spent on events counting as overruns.
+*
+*		@remarks \b Usage: @n Call once per period at the end of the work.
+* @code 
+
+
+static void myTask(void) {
+ task_open();	
+  for (;;) {
+   ...
+   task_period( 10 );
+  }
+ task_close();
+}
+ @endcode 
+ *******************************************************************************/
+#define task_period(p)              OS_WAIT_PERIOD(p)
+
 /*********************************************************************************/
 /*  task_suspend( taskproc )                                                 *//**
 *   
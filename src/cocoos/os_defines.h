@@ -74,6 +74,17 @@
 #define N_EVENTS            0
 
 
+/** Number of clocks, the master clock (id 0) plus the sub clocks
+* @remarks Must be defined. @n Allowed range: 1-255. Each clock keeps its own list of waiting tasks */
+#define N_CLOCKS            2
+
+
+/** Per task run time and latency statistics
+* @remarks If defined, every task slice is timestamped and os_task_stats_get() returns the
+* statistics. Costs two timebase reads and a few compares per slice */
+#define OS_TASK_STATS
+
+
 /** Round Robin scheduling
 * @remarks If defined, tasks will be scheduled ignoring the priorities */
 //#define ROUND_ROBIN
@@ -83,6 +83,7 @@ void os_init( void ) {
 	running_tid = NO_TID;
     last_running_task = NO_TID;
     running = 0;
+    os_task_init();
 }
 
 /*********************************************************************************/
@@ -130,12 +131,12 @@ static void os_schedule( void ) {
     running_tid = os_task_highest_prio_ready_task();   
 #endif
     
-//    if ( running_tid != NO_TID ) {
+    if ( running_tid != NO_TID ) {
         os_task_run();
-//    }
-//    else {
-//        os_idle();
-//    }
+    }
+    else {
+        os_idle();
+    }
 }
 
 /*********************************************************************************/
@@ -171,7 +172,7 @@ void os_tick( void ) {
 *   
 *   Tick function driving the sub clocks
 *
-*       @param id sub clock id, allowed range 1-255
+*       @param id sub clock id, allowed range 1 to N_CLOCKS-1
 *
 *		@return None.
 *
@@ -203,7 +204,7 @@ void os_sub_tick( uint8_t id ) {
 *   
 *   Tick function driving the sub clocks. Increments the tick count with nTicks.
 *
-*       @param id sub clock id, allowed range 1-255.
+*       @param id sub clock id, allowed range 1 to N_CLOCKS-1.
 *       @param nTicks increment size, 16 bit value.
 *
 *		@return None.
@@ -50,4 +50,25 @@
 #define os_enable_interrupts()     bsp_enable_interrupts()
 #define os_disable_interrupts()    bsp_disable_interrupts()
 
+/* free running timestamp for the task statistics */
+#define os_timestamp()             bsp_get_timebase_lower()
+
+/* count leading zeros of a non-zero 32 bit word, used by the ready bitmap */
+#if __CWCC__
+#define os_clz32( x )              ( (uint8_t)__cntlzw( x ) )
+#elif defined(__GNUC__)
+#define os_clz32( x )              ( (uint8_t)__builtin_clz( x ) )
+#else
+#define os_clz32( x )              os_clz32_soft( x )
+static uint8_t os_clz32_soft( uint32_t x ) {
+    uint8_t n = 0;
+    if ( ( x & 0xffff0000ul ) == 0 ) { n += 16; x <<= 16; }
+    if ( ( x & 0xff000000ul ) == 0 ) { n += 8;  x <<= 8;  }
+    if ( ( x & 0xf0000000ul ) == 0 ) { n += 4;  x <<= 4;  }
+    if ( ( x & 0xc0000000ul ) == 0 ) { n += 2;  x <<= 2;  }
+    if ( ( x & 0x80000000ul ) == 0 ) { n += 1; }
+    return n;
+}
+#endif
+
 #endif
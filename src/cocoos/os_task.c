@@ -114,6 +114,7 @@
 #include "cocoos.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 static uint8_t os_task_wait_queue_empty( uint8_t tid );
 
@@ -129,9 +130,35 @@ struct tcb {
     uint8_t waitSingleEvent;
     uint16_t time;
   uint8_t clockId;
+    uint8_t rank;
+    uint8_t nextTimer;
+    uint32_t deadline;
+    uint16_t period;
+    uint32_t release;
+#ifdef OS_TASK_STATS
+    uint8_t released;
+    uint32_t releaseTime;
+    uint8_t periodWait;
+    uint8_t jobActive;
+    uint32_t jobRelease;
+#endif
     taskproctype taskproc;
 };
 
+/* The ready set is a bitmap with one bit per task, ordered by priority rank so that
+   the highest prio ready task is the most significant set bit. NO_TID is 32, so no
+   more than 32 tasks fit. */
+#if N_TASKS > 32
+#error "N_TASKS must not exceed 32, the ready set is a single 32 bit word"
+#endif
+
+#define RANK_BIT( rank )    ( 0x80000000ul >> (rank) )
+
+/* Tasks waiting on a clock are kept on a per clock list sorted by deadline, so a
+   tick only touches the tasks that expire. A task in WAITING_TIME or
+   WAITING_EVENT_TIMEOUT is on its clock's list, otherwise it is not. */
+#define TIMED_STATE( state )    (( (state) == WAITING_TIME ) || ( (state) == WAITING_EVENT_TIMEOUT ))
+
 
 static void task_wait_sem_set( uint8_t tid, Sem_t sem );
 static void task_suspended_set( uint8_t tid );
@@ -140,9 +167,33 @@ static void task_waiting_event_set( tcb *task );
 static void task_waiting_event_timeout_set( tcb *task );
 static void task_ready_set( uint8_t tid );
 static void task_killed_set( uint8_t tid );
+static void task_state_set( tcb *task, TaskState_t state );
+static void task_timer_insert( tcb *task );
+static void task_timer_remove( tcb *task );
+static void task_wait_deadline( tcb *task, uint32_t deadline );
+static void task_period_stop( tcb *task );
+#ifdef OS_TASK_STATS
+static void task_stats_update( tcb *task, uint32_t start, uint32_t end );
+#endif
 
 static tcb task_list[ N_TASKS ];
 static uint8_t nTasks = 0;
+static volatile uint32_t ready_set = 0;
+static uint8_t rank_tid[ N_TASKS ];
+static uint8_t nMsgQ = 0;
+
+static uint32_t clock_now[ N_CLOCKS ];
+/* Empty from reset: the bsp can tick before main() gets to os_init() */
+static uint8_t timer_head[ N_CLOCKS ] = { NO_TID, NO_TID };
+#if N_CLOCKS != 2
+#error "timer_head needs a NO_TID for each clock"
+#endif
+static uint16_t tick_count = 0;
+
+#ifdef OS_TASK_STATS
+/* Indexed by task id, kept apart from the tcbs so it can be read out as one block */
+static struct os_task_stats task_stats[ N_TASKS ];
+#endif
 
 
 /************************************************************** *******************/
@@ -196,15 +247,19 @@ uint8_t task_create( taskproctype taskproc, uint8_t prio, Msg_t *msgPool, uint8_
 
     task->tid = nTasks;
     task->prio = prio;
-    task->state = READY;
+    task->state = KILLED;
     task->savedState = READY;
     task->semaphore = 0;
     task->internal_state = 0;
     task->taskproc = taskproc;
     task->waitSingleEvent = 0;
     task->time = 0;
+    task->clockId = 0;
+    task->nextTimer = NO_TID;
+    task->period = 0;
     if ( poolSize > 0 ) {
         task->msgQ = os_msgQ_create( msgPool, poolSize, msgSize );
+        nMsgQ++;
     }
     else {
         task->msgQ = NO_QUEUE;
@@ -212,7 +267,26 @@ uint8_t task_create( taskproctype taskproc, uint8_t prio, Msg_t *msgPool, uint8_
 
     os_task_clear_wait_queue( nTasks );
 
+    /* Insert the task into the priority ranking, lower ranks shift down one bit */
+    taskId = nTasks;
+    while (( taskId != 0 ) && ( task_list[ rank_tid[ taskId - 1 ] ].prio > prio )) {
+        rank_tid[ taskId ] = rank_tid[ taskId - 1 ];
+        task_list[ rank_tid[ taskId ] ].rank = taskId;
+        --taskId;
+    }
+    rank_tid[ taskId ] = nTasks;
+    task->rank = taskId;
+    ready_set = ( ready_set & ~( 0xfffffffful >> taskId ) ) | ( ( ready_set & ( 0xfffffffful >> taskId ) ) >> 1 );
+
     nTasks++;
+    task_state_set( task, READY );
+#ifdef OS_TASK_STATS
+    task->released = 0;
+    task->periodWait = 0;
+    task->jobActive = 0;
+    memset( &task_stats[ task->tid ], 0, sizeof( task_stats[ 0 ] ) );
+    task_stats[ task->tid ].run_min = 0xffffffff;
+#endif
     return task->tid;
 }
 
@@ -383,34 +457,27 @@ void task_kill( taskproctype taskproc ) {
 }
 
 
+/* Empties the clock lists, called from os_init() */
+void os_task_init( void ) {
+    uint8_t id;
+
+    for ( id = 0; id != N_CLOCKS; ++id ) {
+        clock_now[ id ] = 0;
+        timer_head[ id ] = NO_TID;
+    }
+}
+
+
 /* Finds the task with highest prio that are ready to run */
 uint8_t os_task_highest_prio_ready_task( void ) {
-    uint16_t index;
-    tcb *task;
-    uint8_t highest_prio_task = NO_TID;
-    uint8_t highest_prio = 255;
-    TaskState_t state;
-    uint8_t prio;
-	
-	os_declare_state();
-    os_disable_interrupts();
-
-    for ( index = 0; index != nTasks; ++index ) {
-        task = &task_list[ index ];
-        prio = task->prio;
-        state = task->state;
+    uint32_t ready;
 
-        if ( READY == state ) {
-            if ( prio < highest_prio ) {
-                highest_prio = prio;
-            	os_assert( index <= 0xff );
-                highest_prio_task = (uint8_t)index;
-            }
-        }
+    /* A single word read, no need to lock out the tick */
+    ready = ready_set;
+    if ( ready == 0 ) {
+        return NO_TID;
     }
-
-  os_enable_interrupts();
-    return highest_prio_task;
+    return rank_tid[ os_clz32( ready ) ];
 }
 
 
@@ -460,10 +527,13 @@ uint8_t os_task_next_ready_task( void ) {
 
 /* Finds the task with highest prio waiting for sem, and makes it ready to run */
 void os_task_release_waiting_task( Sem_t sem ) {
-    uint8_t highestPrio = 255;
+  #ifdef ROUND_ROBIN
   uint16_t longestWaitTime = 0;
-    uint8_t tid;
   uint8_t lastCheckedTask = NO_TID;
+  #else
+    uint8_t highestPrio = 255;
+  #endif
+    uint8_t tid;
     uint8_t foundTask = NO_TID;
     uint8_t taskIsWaitingForThisSemaphore;
     tcb *task;
@@ -476,8 +546,8 @@ void os_task_release_waiting_task( Sem_t sem ) {
       #ifdef ROUND_ROBIN
           /* Release the task that has waited longest */
         lastCheckedTask = tid;
-          if ( task->time > longestWaitTime ) {
-          longestWaitTime = task->time;
+          if ( (uint16_t)( tick_count - task->time ) > longestWaitTime ) {
+          longestWaitTime = (uint16_t)( tick_count - task->time );
           foundTask = tid;
         }
       #else
@@ -498,7 +568,7 @@ void os_task_release_waiting_task( Sem_t sem ) {
     }
   #endif
     if ( NO_TID != foundTask ) {
-        task_list[ foundTask ].state = READY;
+        task_ready_set( foundTask );
     }
 }
 
@@ -529,8 +599,8 @@ void os_task_wait_sem_set( uint8_t tid, Sem_t sem ) {
     os_assert( tid < nTasks );
     task_wait_sem_set( tid, sem );
 
-  /* The time is ticked to measure waiting time */
-  task_list[ tid ].time = 0;
+  /* The tick count at the start of the wait, used to measure waiting time */
+  task_list[ tid ].time = tick_count;
 }
 
 
@@ -571,7 +641,7 @@ void os_task_resume( uint8_t tid ) {
     os_assert( tid < nTasks );
 
     if ( task_list[ tid ].state == SUSPENDED ) {
-      task_list[ tid ].state = task_list[ tid ].savedState;
+      task_state_set( &task_list[ tid ], task_list[ tid ].savedState );
     }
 }
 
@@ -630,6 +700,7 @@ static uint8_t os_task_wait_queue_empty( uint8_t tid ) {
 
 void os_task_wait_time_set( uint8_t tid, uint8_t id, uint16_t time ) {
     os_assert( tid < nTasks );
+    os_assert( id < N_CLOCKS );
     os_assert( time > 0 );
 
     task_list[ tid ].clockId = id;
@@ -638,6 +709,83 @@ void os_task_wait_time_set( uint8_t tid, uint8_t id, uint16_t time ) {
 }
 
 
+/* Waits until clock 0 reaches deadline, see task_wait_until() */
+void os_task_wait_until_set( uint8_t tid, uint32_t deadline ) {
+    os_assert( tid < nTasks );
+
+    task_period_stop( &task_list[ tid ] );
+    task_wait_deadline( &task_list[ tid ], deadline );
+}
+
+
+/* Waits for the next release of a fixed rate task, see task_period(). Releases are
+   spaced exactly period ticks apart on clock 0 whatever the task's run time. A
+   release that has already gone by when the task asks for it is an overrun: the
+   task runs again straight away if only the latest release was missed, releases
+   missed entirely are dropped, and either way the next one stays on the grid. */
+void os_task_wait_period_set( uint8_t tid, uint16_t period ) {
+    tcb *task;
+    uint32_t now;
+    uint32_t late;
+    os_declare_state();
+
+    os_assert( tid < nTasks );
+    os_assert( period > 0 );
+
+    task = &task_list[ tid ];
+
+    os_disable_interrupts();
+
+    now = clock_now[ 0 ];
+    if ( task->period != period ) {
+        /* First period, or the rate changed - the grid starts from now */
+        task->period = period;
+        task->release = now;
+    }
+    task->release += period;
+
+    if ( (int32_t)( now - task->release ) >= 0 ) {
+        late = now - task->release;
+#ifdef OS_TASK_STATS
+        task_stats[ tid ].overruns += 1 + late / period;
+#endif
+        task->release += ( late / period ) * period;
+    }
+
+#ifdef OS_TASK_STATS
+    /* Response time of the job that just finished */
+    if ( task->jobActive ) {
+        late = os_timestamp() - task->jobRelease;
+        if ( late > task_stats[ tid ].response_max ) {
+            task_stats[ tid ].response_max = late;
+        }
+    }
+    task->jobActive = 0;
+    task->periodWait = 1;
+#endif
+
+    task_wait_deadline( task, task->release );
+
+#ifdef OS_TASK_STATS
+    if ( task->state == READY ) {
+        /* Overrun, the next job starts now */
+        task->periodWait = 0;
+        task->jobActive = 1;
+        task->jobRelease = os_timestamp();
+    }
+#endif
+
+    os_enable_interrupts();
+}
+
+
+/* Current count of clock id, the time base of task_wait_until() for clock 0 */
+uint32_t os_task_clock_get( uint8_t id ) {
+    os_assert( id < N_CLOCKS );
+    return clock_now[ id ];
+}
+
+
 void os_task_wait_event( uint8_t tid, Evt_t eventId, uint8_t waitSingleEvent, uint16_t timeout ) {
     uint8_t eventListIndex;
     uint8_t shift;
@@ -646,6 +794,7 @@ void os_task_wait_event( uint8_t tid, Evt_t eventId, uint8_t waitSingleEvent, ui
     os_assert( tid < nTasks );
 
     task = &task_list[ tid ];
+    task_period_stop( task );
 
     eventListIndex = eventId / 8;
     shift = eventId & 0x07;
@@ -665,42 +814,72 @@ void os_task_wait_event( uint8_t tid, Evt_t eventId, uint8_t waitSingleEvent, ui
 
 
 void os_task_tick( uint8_t id, uint16_t tickSize ) {
-    uint8_t index;
+    uint8_t tid;
+    MsgQ_t queue;
+    tcb *task;
 
-    /* Search all tasks and decrement time for waiting tasks */
-    for ( index = 0; index != nTasks; ++index ) {
-      TaskState_t state;
-      state = task_list[ index ].state;
-      if (( state == WAITING_TIME ) || ( state == WAITING_EVENT_TIMEOUT )){
-        /* Found a waiting task, is it ready? */
-        if ( task_list[ index ].clockId == id ) {
-          if ( task_list[ index ].time <= tickSize ) {
-            task_list[ index ].time = 0;
-            if ( state == WAITING_EVENT_TIMEOUT ) {
-              os_task_clear_wait_queue( index );
-            }
-          task_ready_set( index );
+    os_assert( id < N_CLOCKS );
+
+    os_declare_state();
+    os_disable_interrupts();
+
+    /* Counts ticks of any clock, measures semaphore waiting time */
+    tick_count++;
+
+    /* Release the tasks at the head of the list whose deadline has passed */
+    clock_now[ id ] += tickSize;
+    tid = timer_head[ id ];
+    while ( tid != NO_TID ) {
+        task = &task_list[ tid ];
+        if ( (int32_t)( task->deadline - clock_now[ id ] ) > 0 ) {
+            break;
         }
-        else {
-          task_list[ index ].time -= tickSize;
+        if ( task->state == WAITING_EVENT_TIMEOUT ) {
+            os_task_clear_wait_queue( tid );
         }
+#ifdef OS_TASK_STATS
+        if ( task->periodWait ) {
+            task->periodWait = 0;
+            task->jobActive = 1;
+            task->jobRelease = os_timestamp();
         }
-      }
-      else
-      if ( state ==  WAITING_SEM ) {
-        task_list[ index ].time++;
-      }
-
-      /* If the task has a message queue, decrement the delayed message timers */
-      if ( id == 0 ) {
-        if ( task_list[ index ].msgQ != NO_QUEUE ) {
-          os_msgQ_tick( task_list[ index ].msgQ );
+#endif
+        task_ready_set( tid );
+        tid = timer_head[ id ];
+    }
+
+    os_enable_interrupts();
+
+    /* Decrement the delayed message timers, queues are numbered in creation order */
+    if ( id == 0 ) {
+        for ( queue = 0; queue != nMsgQ; ++queue ) {
+            os_msgQ_tick( queue );
         }
-      }
     }
 }
 
 
+/* Ticks until the first task waiting on clock id is due, OS_NO_TIMEOUT if none */
+uint32_t os_task_next_timeout( uint8_t id ) {
+    uint32_t ticks;
+    int32_t remaining;
+
+    os_assert( id < N_CLOCKS );
+
+    os_declare_state();
+    os_disable_interrupts();
+
+    ticks = OS_NO_TIMEOUT;
+    if ( timer_head[ id ] != NO_TID ) {
+        remaining = (int32_t)( task_list[ timer_head[ id ] ].deadline - clock_now[ id ] );
+        ticks = ( remaining > 0 ) ? (uint32_t)remaining : 0;
+    }
+
+    os_enable_interrupts();
+    return ticks;
+}
+
+
 void os_task_signal_event( Evt_t eventId ) {
     uint8_t index;
 
@@ -739,9 +918,72 @@ void os_task_signal_event( Evt_t eventId ) {
 
 /* Runs the next task ready for execution. Assumes running_tid has been assigned */
 void os_task_run( void ) {
+#ifdef OS_TASK_STATS
+    tcb *task;
+    uint32_t start;
+
+    os_assert( running_tid < nTasks );
+
+    /* The task clears running_tid when it yields, so keep hold of the tcb */
+    task = &task_list[ running_tid ];
+    start = os_timestamp();
+    task->taskproc();
+    task_stats_update( task, start, os_timestamp() );
+#else
     os_assert( running_tid < nTasks );
     task_list[ running_tid ].taskproc();
+#endif
+}
+
+
+#ifdef OS_TASK_STATS
+/* Returns the statistics of all tasks, indexed by task id */
+const struct os_task_stats *os_task_stats_get( void ) {
+    return task_stats;
+}
+
+
+static void task_stats_update( tcb *task, uint32_t start, uint32_t end ) {
+    struct os_task_stats *stats;
+    uint32_t run;
+    uint32_t latency;
+    uint8_t bucket;
+
+    stats = &task_stats[ task->tid ];
+    run = end - start;
+
+    stats->runs++;
+    if ( run < stats->run_min ) {
+        stats->run_min = run;
+    }
+    if ( run > stats->run_max ) {
+        stats->run_max = run;
+    }
+    stats->run_mean = stats->run_mean - ( stats->run_mean >> 4 ) + ( run >> 4 );
+
+    bucket = 0;
+    if (( run >> OS_STATS_HIST_SHIFT ) != 0 ) {
+        bucket = (uint8_t)( 32 - os_clz32( run >> OS_STATS_HIST_SHIFT ) );
+        if ( bucket >= OS_STATS_HIST_SIZE ) {
+            bucket = OS_STATS_HIST_SIZE - 1;
+        }
+    }
+    if ( stats->run_hist[ bucket ] != 0xffff ) {
+        stats->run_hist[ bucket ]++;
+    }
+
+    /* First slice since the task was made ready. Made ready again during this
+       slice (a deadline already past) counts toward the next one */
+    if ( task->released && (int32_t)( start - task->releaseTime ) >= 0 ) {
+        task->released = 0;
+        latency = start - task->releaseTime;
+        if ( latency > stats->latency_max ) {
+            stats->latency_max = latency;
+        }
+        stats->latency_mean = stats->latency_mean - ( stats->latency_mean >> 4 ) + ( latency >> 4 );
+    }
 }
+#endif
 
 
 uint16_t os_task_internal_state_get( uint8_t tid ) {
@@ -759,37 +1001,150 @@ MsgQ_t os_task_msgQ_get( uint8_t tid ) {
 }
 
 
+/* All task state changes go through here to keep the ready set in step. The tick
+   can change states from interrupt level, so the update is a critical section. */
+static void task_state_set( tcb *task, TaskState_t state ) {
+    os_declare_state();
+    os_disable_interrupts();
+
+    if ( TIMED_STATE( task->state ) && !TIMED_STATE( state ) ) {
+        task_timer_remove( task );
+    }
+    else if ( !TIMED_STATE( task->state ) && TIMED_STATE( state ) ) {
+        task_timer_insert( task );
+    }
+
+#ifdef OS_TASK_STATS
+    if (( READY == state ) && ( READY != task->state )) {
+        task->released = 1;
+        task->releaseTime = os_timestamp();
+    }
+#endif
+
+    task->state = state;
+    if ( READY == state ) {
+        ready_set |= RANK_BIT( task->rank );
+    }
+    else {
+        ready_set &= ~RANK_BIT( task->rank );
+    }
+
+    os_enable_interrupts();
+}
+
+
+/* Puts the task on its clock's list, task->time ticks from now. Called with interrupts off. */
+static void task_timer_insert( tcb *task ) {
+    uint8_t *link;
+    uint32_t now;
+
+    now = clock_now[ task->clockId ];
+    task->deadline = now + task->time;
+
+    /* Equal deadlines keep their arrival order */
+    link = &timer_head[ task->clockId ];
+    while (( *link != NO_TID ) &&
+           ( (int32_t)( task_list[ *link ].deadline - now ) <= (int32_t)task->time )) {
+        link = &task_list[ *link ].nextTimer;
+    }
+    task->nextTimer = *link;
+    *link = task->tid;
+}
+
+
+/* Takes the task off its clock's list and leaves the remaining ticks in task->time,
+   so a resumed task waits out the rest. Called with interrupts off. */
+static void task_timer_remove( tcb *task ) {
+    uint8_t *link;
+    int32_t remaining;
+
+    link = &timer_head[ task->clockId ];
+    while ( *link != task->tid ) {
+        os_assert( *link != NO_TID );
+        link = &task_list[ *link ].nextTimer;
+    }
+    *link = task->nextTimer;
+    task->nextTimer = NO_TID;
+
+    remaining = (int32_t)( task->deadline - clock_now[ task->clockId ] );
+    task->time = ( remaining > 0 ) ? (uint16_t)remaining : 0;
+}
+
+
+/* Makes the task wait on clock 0 until deadline, or ready if that has passed. The
+   remaining time is worked out and queued in one critical section so a tick can't
+   slip in between. */
+static void task_wait_deadline( tcb *task, uint32_t deadline ) {
+    int32_t remaining;
+    os_declare_state();
+    os_disable_interrupts();
+
+    remaining = (int32_t)( deadline - clock_now[ 0 ] );
+    if ( remaining <= 0 ) {
+        task_state_set( task, READY );
+    }
+    else {
+        os_assert( remaining <= 0xffff );
+        task->clockId = 0;
+        task->time = (uint16_t)remaining;
+        task_state_set( task, WAITING_TIME );
+    }
+
+    os_enable_interrupts();
+}
+
+
+/* A deadline or event wait ends a fixed rate run. The next task_period() starts a
+   new grid from then instead of counting the time since the last release as
+   overruns, and the job in progress is closed now so its response time is right. */
+static void task_period_stop( tcb *task ) {
+#ifdef OS_TASK_STATS
+    uint32_t response;
+
+    if ( task->jobActive ) {
+        response = os_timestamp() - task->jobRelease;
+        if ( response > task_stats[ task->tid ].response_max ) {
+            task_stats[ task->tid ].response_max = response;
+        }
+    }
+    task->jobActive = 0;
+    task->periodWait = 0;
+#endif
+    task->period = 0;
+}
+
+
 static void task_wait_sem_set( uint8_t tid, Sem_t sem ) {
-    task_list[ tid ].state = WAITING_SEM;
     task_list[ tid ].semaphore = sem;
+    task_state_set( &task_list[ tid ], WAITING_SEM );
 }
 
 
 static void task_ready_set( uint8_t tid ) {
-    task_list[ tid ].state = READY;
+    task_state_set( &task_list[ tid ], READY );
 }
 
 
 static void task_suspended_set( uint8_t tid ) {
-    task_list[ tid ].state = SUSPENDED;
+    task_state_set( &task_list[ tid ], SUSPENDED );
 }
 
 
 static void task_waiting_time_set( uint8_t tid ) {
-    task_list[ tid ].state = WAITING_TIME;
+    task_state_set( &task_list[ tid ], WAITING_TIME );
 }
 
 
 static void task_waiting_event_set( tcb *task ) {
-    task->state = WAITING_EVENT;
+    task_state_set( task, WAITING_EVENT );
 }
 
 
 static void task_waiting_event_timeout_set( tcb *task ) {
-    task->state = WAITING_EVENT_TIMEOUT;
+    task_state_set( task, WAITING_EVENT_TIMEOUT );
 }
 
 
 static void task_killed_set( uint8_t tid ) {
-    task_list[ tid ].state = KILLED;
+    task_state_set( &task_list[ tid ], KILLED );
 }
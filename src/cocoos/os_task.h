@@ -71,6 +71,32 @@
 
 typedef struct tcb tcb;
 
+#define OS_NO_TIMEOUT   0xffffffffUL
+
+#ifdef OS_TASK_STATS
+/* Log2 run time histogram, bucket 0 is below 64 timebase ticks and bucket n
+   counts slices from 2^(n+5) up to 2^(n+6) ticks, the last bucket holds the rest */
+#define OS_STATS_HIST_SHIFT     6
+#define OS_STATS_HIST_SIZE      16
+
+/* Per task statistics, times in timebase ticks. The means are running averages
+   with a 1/16 weight. Latency is from the tick or signal that made the task ready
+   to the start of its next slice. Interrupts during a slice count as run time.
+   The last two are only kept for task_period() tasks: releases missed, and the
+   worst time from a release to the task asking for the next one. */
+struct os_task_stats {
+    uint32_t runs;
+    uint32_t run_min;
+    uint32_t run_max;
+    uint32_t run_mean;
+    uint32_t latency_max;
+    uint32_t latency_mean;
+    uint16_t run_hist[ OS_STATS_HIST_SIZE ];
+    uint32_t overruns;
+    uint32_t response_max;
+};
+#endif
+
 typedef enum {
     SUSPENDED,
     WAITING_SEM,
@@ -104,6 +130,7 @@ typedef enum {
 
 
 
+void os_task_init( void );
 uint8_t os_task_highest_prio_ready_task( void );
 uint8_t os_task_next_ready_task( void );
 void os_task_ready_set( uint8_t tid );
@@ -114,8 +141,12 @@ void os_task_kill( uint8_t tid );
 uint8_t os_task_prio_get( uint8_t tid );
 void os_task_clear_wait_queue( uint8_t tid );
 void os_task_wait_time_set( uint8_t tid, uint8_t id, uint16_t time );
+void os_task_wait_until_set( uint8_t tid, uint32_t deadline );
+void os_task_wait_period_set( uint8_t tid, uint16_t period );
+uint32_t os_task_clock_get( uint8_t id );
 void os_task_wait_event( uint8_t tid, Evt_t eventId, uint8_t waitSingleEvent, uint16_t timeout );
 void os_task_tick( uint8_t id, uint16_t tickSize );
+uint32_t os_task_next_timeout( uint8_t id );
 void os_task_signal_event( Evt_t eventId );
 void os_task_run( void );
 uint16_t os_task_internal_state_get( uint8_t tid );
@@ -123,6 +154,9 @@ void os_task_internal_state_set( uint8_t tid, uint16_t state );
 void os_task_release_waiting_task( Sem_t sem );
 uint8_t os_task_waiting_this_semaphore( Sem_t sem );
 MsgQ_t os_task_msgQ_get( uint8_t tid );
+#ifdef OS_TASK_STATS
+const struct os_task_stats *os_task_stats_get( void );
+#endif
 
 
 
@@ -0,0 +1,30 @@
+/**
+ * @file       err_counts_get.c
+ * @headerfile err.h
+ * @brief      per code counters
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ */
+
+#include <stdint.h>
+#include "err.h"
+#include "err_prv.h"
+
+/* --| TYPES    |--------------------------------------------------------- */
+/* --| STATICS  |--------------------------------------------------------- */
+/* --| INLINES  |--------------------------------------------------------- */
+/* --| INTERNAL |--------------------------------------------------------- */
+/* --| PUBLIC   |--------------------------------------------------------- */
+/**
+ * @public
+ * @brief per code counters and first/last times
+ * @retval struct err_counts const* live table
+ */
+struct err_counts const *
+  err_counts_get( void )
+{
+  return &err_counts;
+}
\ No newline at end of file
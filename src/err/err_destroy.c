@@ -11,10 +11,7 @@
  */
 
 #include <stdint.h>
-#include "bsp.h"
 #include "trap.h"
-#include "lifo.h"
-#include "fifo.h"
 #include "err.h"
 #include "err_prv.h"
 
@@ -28,16 +25,26 @@
  * @brief return err_t back to the free pool
  * @param[in] e previously pop'd err
  * @retval none
- * @note { threadsafe }
+ * @note { single consumer, same context as err_pop() }
  */
 void
   err_destroy( err_t const *e )
 {
+  uint32_t i = err_hash( e->code );
+  uint32_t n;
+
   trap( e );
-  bsp_declare_state();
-  bsp_disable_interrupts();
-  err_free_root =
-    lifo_push( err_free_root,
-               e );
-  bsp_enable_interrupts();
+  trap( e == &err_ring[err_tail % ERR_DEPTH] );   /**< oldest first      */
+
+  /* the next push of this code queues a new record */
+  for( n = 0; n < ERR_CODES; n++ )
+  {
+    if( err_counts.codes[i].code == e->code )
+    {
+      err_pending[i] = 0;
+      break;
+    }
+    i = (i + 1) % ERR_CODES;
+  }
+  err_tail = err_tail + 1;
 }
\ No newline at end of file
@@ -11,7 +11,6 @@
  */
 
 #include <stdint.h>
-#include "fifo.h"
 #include "trap.h"
 #include "err.h"
 #include "err_prv.h"
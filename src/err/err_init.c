@@ -11,8 +11,7 @@
  */
 
 #include <stdint.h>
-#include "lifo.h"
-#include "fifo.h"
+#include <string.h>
 #include "trap.h"
 #include "led.h"
 #include "err.h"
@@ -20,11 +19,13 @@
 
 /* --| TYPES    |--------------------------------------------------------- */
 /* --| STATICS  |--------------------------------------------------------- */
-err_t err_pool[ERR_DEPTH];
+err_t err_ring[ERR_DEPTH];
 /* --| INLINES  |--------------------------------------------------------- */
 /* --| INTERNAL |--------------------------------------------------------- */
-err_t *err_free_root = 0;
-fifo_t err_fifo_root;
+volatile uint32_t err_head;
+volatile uint32_t err_tail;
+struct err_counts err_counts;
+volatile uint32_t err_pending[ERR_CODES];
 /* --| PUBLIC   |--------------------------------------------------------- */
 /**
  * @public
@@ -35,14 +36,10 @@ fifo_t err_fifo_root;
 void
   err_init( void )
 {
-  trap( ERR_DEPTH );
-  fifo_init( &err_fifo_root );
-  for(register i=0; i < ERR_DEPTH ;i++)    /**< loadup free pool          */
-  {
-    err_free_root =
-      lifo_push( err_free_root,
-                 &err_pool[i] );
-    trap( err_free_root );
-  }
+  trap( ERR_DEPTH && !(ERR_DEPTH & (ERR_DEPTH-1)) );  /**< ring index wraps */
+  memset( err_ring, 0, sizeof(err_ring) );
+  memset( &err_counts, 0, sizeof(err_counts) );
+  memset( (void *)err_pending, 0, sizeof(err_pending) );
+  err_head = err_tail = 0;
   led_off( ERR_LED );
 }
\ No newline at end of file
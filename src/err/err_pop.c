@@ -12,8 +12,6 @@
 
 #include <stdint.h>
 #include "led.h"
-#include "bsp.h"
-#include "fifo.h"
 #include "err.h"
 #include "err_prv.h"
 
@@ -27,17 +25,22 @@
  * @brief pop oldest error from the stack
  * @param none
  * @retval err_t* err or 0 if none
- * @note { threadsafe }
+ * @note { single consumer, err_destroy() it before the next pop }
+ * @note a record that is claimed but still being filled in by an
+ *       interrupted err_push reads as empty until it is published
  */
 err_t const *
   err_pop( void )
 {
-  bsp_declare_state();
-  bsp_disable_interrupts();
-  err_t const * const e =
-    fifo_pop( &err_fifo_root );
-  if( !e )
+  uint32_t const t = err_tail;
+  err_t const * const e = &err_ring[t % ERR_DEPTH];
+
+  if( err_head == t )
+  {
     led_off( ERR_LED );           /**< clear led when stack is pop'd clean */
-  bsp_enable_interrupts();
-  return e;
+    if( err_head != t )           /**< unless a push just beat us to it    */
+      led_on( ERR_LED );
+    return 0;
+  }
+  return e->seq == t + 1 ? e : 0;
 }
\ No newline at end of file
@@ -19,19 +19,43 @@ extern "C"
 
 #define ERR_LED   LED3        /**< default LED to indicate code is present */
 
-struct err_t                  /**< err item                                */
+/**
+ * err_push may be called from any context at any time, including from an
+ * interrupt that lands in the middle of another err_push. Nothing masks
+ * interrupts, every shared word is claimed with bsp_atomic_cas/add:
+ *
+ * - the ring is err_ring[], indexed by the free running err_head/err_tail
+ *   counters. a producer claims index 'h' by moving err_head h -> h+1,
+ *   fills the record, then publishes it by setting seq = h+1. the single
+ *   consumer (err_pop/err_destroy) owns err_tail and only reads a record
+ *   once its seq matches
+ * - each code owns a slot in err_counts.codes[], claimed once by moving
+ *   code CODE_NONE -> code. a code only goes in the ring when its pending
+ *   flag moves 0 -> 1, and err_destroy puts it back to 0, so a code that
+ *   repeats before anyone reads it is just counted
+ */
+struct err_t                  /**< err ring record                         */
 {
-  fifo_t;                     /**< required super to leverage fifo api     */
   uint32_t code;
+  volatile uint32_t seq;      /**< ring index + 1 once code/ts are valid   */
   uint64_t ts;
 };
 
-extern err_t err_pool[ERR_DEPTH];
-extern err_t *err_free_root;              /**< pool of free err_t blocks   */
-extern fifo_t err_fifo_root;              /**< code fifo stack             */
+extern err_t err_ring[ERR_DEPTH];
+extern volatile uint32_t err_head;        /**< next index to claim         */
+extern volatile uint32_t err_tail;        /**< next index to pop           */
+extern struct err_counts err_counts;
+extern volatile uint32_t err_pending[ERR_CODES]; /**< code is in the ring  */
+
+/* --| INLINES  |--------------------------------------------------------- */
+static inline uint32_t
+  err_hash( uint32_t code )
+{
+  return (code ^ (code >> 8) ^ (code >> 16)) % ERR_CODES;
+}
 
 #ifdef __cplusplus
 }
 #endif
 
-#endif // __err_prv_h
\ No newline at end of file
+#endif // __err_prv_h
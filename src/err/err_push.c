@@ -12,8 +12,6 @@
 
 #include <stdint.h>
 #include "led.h"
-#include "lifo.h"
-#include "fifo.h"
 #include "bsp.h"
 #include "trap.h"
 #include "err.h"
@@ -23,42 +21,101 @@
 /* --| STATICS  |--------------------------------------------------------- */
 /* --| INLINES  |--------------------------------------------------------- */
 /* --| INTERNAL |--------------------------------------------------------- */
+/**
+ * @internal
+ * @brief find the slot for code, claiming a free one the first time
+ * @retval int slot or -1 if the table is full
+ */
+static int
+  err_slot( uint32_t code )
+{
+  uint32_t i = err_hash( code );
+  uint32_t n;
+
+  for( n = 0; n < ERR_CODES; n++ )
+  {
+    struct err_count *const c = &err_counts.codes[i];
+    if( c->code == code )
+      return i;
+    if( c->code == CODE_NONE &&
+        bsp_atomic_cas( &c->code, CODE_NONE, code ) )
+    {
+      c->first = systime;
+      return i;
+    }
+    if( c->code == code )       /**< lost the claim to a push of this code */
+      return i;
+    i = (i + 1) % ERR_CODES;
+  }
+  return -1;
+}
+
+/**
+ * @internal
+ * @brief claim the next ring record and publish code in it
+ * @retval int !0 if queued, 0 if the ring is full
+ */
+static int
+  err_queue( uint32_t code )
+{
+  uint32_t h;
+  err_t *e;
+
+  do
+  {
+    h = err_head;
+    if( h - err_tail >= ERR_DEPTH )
+      return 0;
+  } while( !bsp_atomic_cas( &err_head, h, h + 1 ) );
+
+  e = &err_ring[h % ERR_DEPTH];
+  e->ts = bsp_get_timebase();         /**< store off info               */
+  e->code = code;
+  e->seq = h + 1;                     /**< visible to err_pop from here */
+  return 1;
+}
+
 /* --| PUBLIC   |--------------------------------------------------------- */
 /**
  * @public
  * @brief push an error code into the stack
  * @param[in] code error code
  * @retval none
- * @note { threadsafe }
+ * @note { threadsafe, lock free, callable from interrupts }
  */
 void
   err_push( uint32_t code )
 {
-  bsp_declare_state();
+  int i;
   trap( code != CODE_NONE );       /**< why are you pushing CODE_NONE ? */
 
-  /* the lifo/fifo api is not threadsafe, and I want any context to feel free
-   * to call this api. wrapping in a critical section ensures threadsafety.
-   */
-
-  bsp_disable_interrupts();
-  err_t *const e =
-    lifo_pop( &err_free_root );
-  bsp_enable_interrupts();
+  i = err_slot( code );
 
-  if( e )
+  if( i >= 0 )
   {
-    e->ts = bsp_get_timebase();       /**< store off info               */
-    e->code = code;
+    struct err_count *const c = &err_counts.codes[i];
+    bsp_atomic_add( &c->count, 1 );
+    c->last = systime;
 
-    bsp_disable_interrupts();
-    fifo_push( &err_fifo_root,
-               e );
-    led_on( ERR_LED );
-    bsp_enable_interrupts();
+    /* already in the ring and not pop'd yet, the count is enough */
+    if( !bsp_atomic_cas( &err_pending[i], 0, 1 ) )
+      return;
+    if( !err_queue( code ) )
+    {
+      err_pending[i] = 0;
+      bsp_atomic_add( &err_counts.dropped, 1 );
+      return;
+    }
   }
   else
   {
-    /* no more blocks - signalling an error won't help much either */
+    bsp_atomic_add( &err_counts.untracked, 1 );
+    if( !err_queue( code ) )
+    {
+      /* no more room - signalling an error won't help much either */
+      bsp_atomic_add( &err_counts.dropped, 1 );
+      return;
+    }
   }
+  led_on( ERR_LED );
 }
\ No newline at end of file
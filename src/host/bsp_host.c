@@ -0,0 +1,457 @@
+/**
+ * @file       bsp_host.c
+ * @headerfile bsp_host.h
+ * @brief      linux host bsp, virtual timebase, decrementer and angle clock
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <signal.h>
+#include <sys/time.h>
+#include "mpc563xm.h"
+#include "bsp.h"
+#include "bsp_host.h"
+#include "cocoos.h"
+
+#define CORE_HZ   ( BSP_DECR_PERIOD * 1000ull )
+#define STALL_US  ( 200 )       /**< host time without an os call = spin  */
+
+/* --| TYPES    |--------------------------------------------------------- */
+/**
+ * @internal
+ * @brief lateness of one interrupt source
+ */
+typedef struct
+{
+  uint32_t count;
+  uint32_t late;      /**< taken a whole period or more after it was due */
+  uint64_t late_max;  /**< core clocks                                  */
+} irq_stats_t;
+
+/* --| STATICS  |--------------------------------------------------------- */
+uint32_t systime = 0;
+
+vector_fptr_t vectors[210];           /**< bsp_vector_install() fills it  */
+
+static uint64_t now;                /**< virtual timebase, core clocks    */
+static uint64_t busy;               /**< clocks not spent in os_idle      */
+static uint64_t stop_at;
+static void   (*stop_fn)( void );
+static uint32_t isr_cost;
+static int      masked;
+static int      in_isr;
+
+static uint64_t    decr_due;
+static irq_stats_t decr_stats;
+
+static float             rpm;
+static double            angle_due;     /**< fractional, so speed is exact */
+static double            angle_period;  /**< clocks per window             */
+static uint8_t           angle_windows;
+static uint32_t          angle_x100;
+static bsp_host_angle_fn angle_fn;
+static int               angle_vector;  /**< 0 for the built in os tick   */
+static irq_stats_t       angle_stats;
+
+static void            (*tick_fn)( void );
+static void            (*mask_fn)( void );
+static volatile sig_atomic_t os_calls;  /**< charge() calls, for stall()  */
+static volatile sig_atomic_t stalled;
+static sig_atomic_t          stall_seen;
+
+static double            cpu_scale;
+static uint64_t          cpu_last;      /**< host ns at the last charge    */
+static int               charging;
+
+/* --| INLINES  |--------------------------------------------------------- */
+static inline uint64_t
+  angle_due_clocks( void )
+{
+  return rpm > 0.0f ? (uint64_t)angle_due : UINT64_MAX;
+}
+
+static inline uint64_t
+  next_due( void )
+{
+  uint64_t a = angle_due_clocks();
+  return a < decr_due ? a : decr_due;
+}
+
+/* --| INTERNAL |--------------------------------------------------------- */
+static void
+  irq_count( irq_stats_t *s, uint64_t due, uint64_t period )
+{
+  uint64_t late = now - due;
+  ++s->count;
+  if( late >= period )
+    ++s->late;
+  if( late > s->late_max )
+    s->late_max = late;
+}
+
+/* with a cpu scale set, the host cpu time used since the last charge goes
+   on virtual time, as if the code had run 'cpu_scale' times slower. time
+   in the handlers is charged to the task they interrupted              */
+static void
+  charge( void )
+{
+  struct timespec t;
+  uint64_t ns, clocks;
+
+  ++os_calls;
+  if( cpu_scale <= 0.0 || in_isr || charging )
+    return;
+  clock_gettime( CLOCK_THREAD_CPUTIME_ID, &t );
+  ns = (uint64_t)t.tv_sec * 1000000000ull + (uint64_t)t.tv_nsec;
+  if( stalled ) {
+    stalled = 0;
+    cpu_last = ns;            /**< a spin on a fake peripheral, not work  */
+    return;
+  }
+  clocks = (uint64_t)((double)(ns - cpu_last) * cpu_scale * CORE_HZ / 1e9);
+  if( clocks == 0 )
+    return;                   /**< keep the remainder for next time       */
+  cpu_last = ns;
+  charging = 1;
+  bsp_host_spend( clocks > UINT32_MAX ? UINT32_MAX : (uint32_t)clocks );
+  charging = 0;
+}
+
+/* SIGALRM every STALL_US: code that went that long without calling into
+   the os is spinning on a peripheral register (Set_Fuel() on HSRR), let
+   the mask hook move the peripheral along and drop the spin from the
+   cpu charge. a false call, the host was busy elsewhere, costs nothing */
+static void
+  stall( int sig )
+{
+  (void)sig;
+  if( os_calls == stall_seen && mask_fn ) {
+    mask_fn();
+    stalled = 1;
+  }
+  stall_seen = os_calls;
+}
+
+/* run an installed INTC handler, as ivor4 would, and the mask hook after
+   it for the requests it made, they don't wait for the next task */
+static void
+  take( int vector )
+{
+  vector_fptr_t const fn = vectors[ vector ];
+  int const was_in_isr = in_isr;
+
+  if( !fn || INTC.PSR[ vector ].R == 0 )
+    return;
+  in_isr = 1;                 /**< no nesting, like deliver()             */
+  fn();
+  if( mask_fn )
+    mask_fn();
+  in_isr = was_in_isr;
+}
+
+/* take every interrupt that is due, oldest first, the same work the
+   target handlers do. nested calls from the os critical sections inside
+   them are ignored, like the single level of EE masking on target      */
+static void
+  deliver( void )
+{
+  uint64_t due;
+
+  if( masked || in_isr )
+    return;
+  in_isr = 1;
+
+  for(;;) {
+    if( decr_due <= now && decr_due <= angle_due_clocks() ) {
+      irq_count( &decr_stats, decr_due, BSP_DECR_PERIOD );
+      decr_due += BSP_DECR_PERIOD;
+      ++systime;
+      os_task_tick( 0, 1 );
+      if( tick_fn )
+        tick_fn();
+    }
+    else if( (due = angle_due_clocks()) <= now ) {
+      irq_count( &angle_stats, due, (uint64_t)angle_period );
+      angle_due += angle_period;
+      angle_x100 = (angle_x100 + 72000 / angle_windows) % 72000;
+      if( angle_vector ) {
+        if( angle_fn )
+          angle_fn( angle_x100 );   /**< sets up what the handler reads   */
+        take( angle_vector );
+      }
+      else {
+        os_task_tick( 1, (uint16_t)(720 / angle_windows) );
+        if( angle_fn )
+          angle_fn( angle_x100 );
+      }
+    }
+    else
+      break;
+    now += isr_cost;
+    busy += isr_cost;
+  }
+
+  in_isr = 0;
+
+  if( stop_fn && stop_at && now >= stop_at ) {
+    void (*fn)( void ) = stop_fn;
+    stop_fn = 0;
+    fn();
+  }
+}
+
+/* --| PUBLIC   |--------------------------------------------------------- */
+void
+  bsp_host_init( uint32_t run_ms, uint32_t isr_clocks, void (*done)( void ) )
+{
+  now = busy = 0;
+  systime = 0;
+  masked = in_isr = 0;
+  stop_at = (uint64_t)run_ms * BSP_DECR_PERIOD;
+  stop_fn = done;
+  isr_cost = isr_clocks;
+  decr_due = BSP_DECR_PERIOD;
+  rpm = 0.0f;
+  angle_x100 = 0;
+  angle_vector = 0;
+  tick_fn = mask_fn = 0;
+  cpu_scale = 0.0;
+}
+
+void
+  bsp_host_angle_init( uint8_t windows, bsp_host_angle_fn fn )
+{
+  angle_windows = windows ? windows : 1;
+  angle_fn = fn;
+}
+
+void
+  bsp_host_angle_vector( int vector )
+{
+  angle_vector = vector;
+}
+
+void
+  bsp_host_tick_hook( void (*fn)( void ) )
+{
+  tick_fn = fn;
+}
+
+void
+  bsp_host_mask_hook( void (*fn)( void ) )
+{
+  struct sigaction sa;
+  struct itimerval it;
+
+  mask_fn = fn;
+  memset( &sa, 0, sizeof( sa ) );
+  sa.sa_handler = stall;
+  sa.sa_flags = SA_RESTART;
+  sigaction( SIGALRM, &sa, 0 );
+  it.it_interval.tv_sec = 0;
+  it.it_interval.tv_usec = fn ? STALL_US : 0;
+  it.it_value = it.it_interval;
+  setitimer( ITIMER_REAL, &it, 0 );
+}
+
+void
+  bsp_host_cpu_scale( float scale )
+{
+  cpu_scale = scale;
+  cpu_last = 0;
+  if( scale > 0.0f ) {
+    struct timespec t;
+    clock_gettime( CLOCK_THREAD_CPUTIME_ID, &t );
+    cpu_last = (uint64_t)t.tv_sec * 1000000000ull + (uint64_t)t.tv_nsec;
+  }
+}
+
+void
+  bsp_host_set_rpm( float new_rpm )
+{
+  if( new_rpm > 0.0f ) {
+    /* clocks per 720/windows degrees: a rev is 60/rpm seconds */
+    angle_period = (double)CORE_HZ * 120.0 / new_rpm / angle_windows;
+    if( rpm <= 0.0f )
+      angle_due = (double)now + angle_period;
+  }
+  rpm = new_rpm;
+}
+
+void
+  bsp_host_spend( uint32_t clocks )
+{
+  uint64_t step;
+  uint64_t due;
+
+  busy += clocks;
+  while( clocks ) {
+    due = next_due();
+    step = due > now ? due - now : 0;
+    if( step == 0 && (masked || in_isr) )
+      step = clocks;          /**< held off, it's taken late on unmask    */
+    if( step > clocks )
+      step = clocks;
+    now += step;
+    clocks -= (uint32_t)step;
+    deliver();
+  }
+}
+
+void
+  bsp_host_vector( int vector )
+{
+  take( vector );
+  now += isr_cost;
+  busy += isr_cost;
+}
+
+void
+  bsp_host_report( void )
+{
+  double ms = (double)now / BSP_DECR_PERIOD;
+
+  printf( "virtual time %.1f ms, rpm %.0f, cpu load %.1f%%\n",
+          ms, rpm, now ? 100.0 * busy / now : 0.0 );
+  printf( "ms tick:  %u taken, %u late, worst %.1f us late\n",
+          decr_stats.count, decr_stats.late,
+          decr_stats.late_max * 1e6 / CORE_HZ );
+  printf( "angle:    %u taken, %u late, worst %.1f us late\n",
+          angle_stats.count, angle_stats.late,
+          angle_stats.late_max * 1e6 / CORE_HZ );
+
+#ifdef OS_TASK_STATS
+  {
+    const struct os_task_stats *s = os_task_stats_get();
+    uint8_t tid;
+
+    printf( "tid     runs   run mean/max us   latency mean/max us   overruns  response max us\n" );
+    for( tid = 0; tid < N_TASKS; ++tid ) {
+      if( s[ tid ].runs == 0 )
+        continue;
+      printf( "%3u %8u   %7.1f %8.1f   %8.1f %8.1f   %8u %8.1f\n", tid, s[ tid ].runs,
+              s[ tid ].run_mean * 1e6 / CORE_HZ, s[ tid ].run_max * 1e6 / CORE_HZ,
+              s[ tid ].latency_mean * 1e6 / CORE_HZ,
+              s[ tid ].latency_max * 1e6 / CORE_HZ,
+              s[ tid ].overruns, s[ tid ].response_max * 1e6 / CORE_HZ );
+    }
+  }
+#endif
+}
+
+/* --| bsp.h and cocoOS hooks |------------------------------------------- */
+int
+  bsp_host_irq_save( void )
+{
+  int state;
+
+  charge();
+  state = masked;
+  if( mask_fn && !masked && !in_isr )
+    mask_fn();
+  masked = 1;
+  return state;
+}
+
+void
+  bsp_host_irq_restore( int state )
+{
+  masked = state;
+  if( !masked )
+    deliver();            /**< whatever came due while masked goes now    */
+}
+
+void
+  bsp_init( void )
+{
+}
+
+void
+  bsp_decr_init( void )
+{
+  decr_due = now + BSP_DECR_PERIOD;
+}
+
+void
+  bsp_decr_set( uint32_t ticks )
+{
+  decr_due = now + ticks;
+}
+
+void
+  bsp_decr_ack( void )
+{
+}
+
+uint64_t
+  bsp_get_timebase( void )
+{
+  charge();
+  return now;
+}
+
+uint32_t
+  bsp_get_timebase_lower( void )
+{
+  charge();
+  return (uint32_t)now;
+}
+
+/**
+ * @brief crt entry, the tuner's restart command jumps here; the host run
+ *        ends instead
+ */
+void
+  __start( void )
+{
+  fprintf( stderr, "bsp_host: restart requested\n" );
+  exit( 3 );
+}
+
+/**
+ * @brief the host has no painted stack, src/bsp/bsp_stack.c
+ */
+void
+  bsp_stack_paint( void )
+{
+}
+
+uint32_t
+  bsp_stack_size( void )
+{
+  return 0;
+}
+
+uint32_t
+  bsp_stack_used( void )
+{
+  return 0;
+}
+
+uint32_t
+  bsp_static_ram( void )
+{
+  return 0;
+}
+
+/**
+ * @brief nothing is ready, so nothing can happen before the next
+ *        interrupt - jump to it
+ */
+void
+  os_idle( void )
+{
+  os_declare_state();
+  charge();
+  os_disable_interrupts();
+  now = next_due();
+  os_enable_interrupts();
+}
@@ -0,0 +1,145 @@
+/**
+ * @file   bsp_host.h
+ * @brief  linux host bsp, runs cocoOS against virtual time
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ */
+
+#ifndef   __bsp_host_h
+#define   __bsp_host_h
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Build with -DBSP_HOST and link bsp_host.c in place of src/bsp and
+ * src/os_idle.c. Time only moves when a task says it used the cpu
+ * (bsp_host_spend) or when every task is waiting, then it jumps straight
+ * to the next interrupt - a minute of engine time runs in well under a
+ * second. The decrementer and the angle clock fire at the same virtual
+ * times on every run, so a given task set and rpm profile is repeatable.
+ *
+ * The 1ms tick is the same as ivor10: systime++ and os_task_tick(0,1).
+ * The angle clock is the same as the eTPU window interrupt in
+ * Angle_Clock.c: os_task_tick(1,deg) every 720/windows degrees. With
+ * bsp_host_angle_vector() set, the window interrupt runs the real handler
+ * through the INTC vector table instead, after the angle hook has put the
+ * eTPU state it reads in place.
+ *
+ * Task code only costs what it spends with bsp_host_spend() unless
+ * bsp_host_cpu_scale() is on, then the host cpu time it takes goes on
+ * virtual time too - how the unmodified main.c task set gets a load.
+ */
+
+/**
+ * @brief called by the angle interrupt after the os tick
+ * @param angle_x100 engine cycle position, 0 to 71999
+ */
+typedef void (*bsp_host_angle_fn)( uint32_t angle_x100 );
+
+/**
+ * @public
+ * @brief start virtual time at 0
+ * @param[in] run_ms virtual run length, 0 for no limit
+ * @param[in] isr_clocks cpu cost charged for every simulated interrupt
+ * @param[in] done called once run_ms is up, should report and exit()
+ */
+void
+  bsp_host_init( uint32_t run_ms, uint32_t isr_clocks, void (*done)( void ) );
+
+/**
+ * @public
+ * @brief set up the virtual angle clock, it stays stopped until rpm > 0
+ * @param[in] windows interrupts per 720 degrees
+ * @param[in] fn extra work for each angle interrupt, may be 0
+ */
+void
+  bsp_host_angle_init( uint8_t windows, bsp_host_angle_fn fn );
+
+/**
+ * @public
+ * @brief take INTC vector 'vector' for the angle interrupt, 0 for the
+ *        built in os_task_tick()
+ * @note the angle hook runs first, so it can set up TCR2 and the channel
+ *       state the handler reads
+ */
+void
+  bsp_host_angle_vector( int vector );
+
+/**
+ * @public
+ * @brief called after every 1ms tick, for the peripherals that run off
+ *        it (A/D scans); 0 for none
+ */
+void
+  bsp_host_tick_hook( void (*fn)( void ) );
+
+/**
+ * @public
+ * @brief called when task code masks interrupts and after each handler,
+ *        for peripheral work that is done long before the cpu could look
+ *        again (eTPU host service requests); 0 for none
+ * @note the scheduler masks on every pass, so nothing the hook finishes
+ *       stays pending from one task to the next. Code spinning on the
+ *       peripheral in between gets the hook from a SIGALRM once it has
+ *       gone 200us without an os call, and the spin isn't charged
+ */
+void
+  bsp_host_mask_hook( void (*fn)( void ) );
+
+/**
+ * @public
+ * @brief charge host cpu time to virtual time, times 'scale'; 0 turns it
+ *        off
+ * @note host thread cpu time, so a scale of a few hundred stands in for
+ *       the e200z3 against a desktop core
+ */
+void
+  bsp_host_cpu_scale( float scale );
+
+/**
+ * @public
+ * @brief engine speed from now on, 0 stops the angle clock
+ */
+void
+  bsp_host_set_rpm( float rpm );
+
+/**
+ * @public
+ * @brief charge the running task 'clocks' core clocks of cpu time
+ * @note interrupts that come due on the way are taken, unless masked,
+ *       and their cost pushes the end of the slice out like on target
+ */
+void
+  bsp_host_spend( uint32_t clocks );
+
+/**
+ * @public
+ * @brief take INTC interrupt 'vector' now, as ivor4 would: run the handler
+ *        bsp_vector_install() put there, if its priority is above 0
+ * @note for the simulated peripherals, call it where the hardware would
+ *       interrupt; the peripherals must be mapped, periph_host.h
+ */
+void
+  bsp_host_vector( int vector );
+
+/**
+ * @public
+ * @brief print the run so far on stdout: load, interrupt lateness and
+ *        the per task statistics when OS_TASK_STATS is on
+ */
+void
+  bsp_host_report( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __bsp_host_h
@@ -0,0 +1,72 @@
+/**
+ * @file       harness.c
+ * @headerfile harness.h
+ * @brief      linux host checks and ns per pass timing for src/host/test
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include "harness.h"
+
+/* --| TYPES    |--------------------------------------------------------- */
+/* --| STATICS  |--------------------------------------------------------- */
+volatile uint32_t harness_sink;
+
+static uint32_t checks;
+static uint32_t failed;
+static uint32_t seed = 2463534242u;
+
+/* --| INLINES  |--------------------------------------------------------- */
+/* --| INTERNAL |--------------------------------------------------------- */
+/* --| PUBLIC   |--------------------------------------------------------- */
+uint64_t
+  harness_ns( void )
+{
+  struct timespec t;
+
+  clock_gettime( CLOCK_MONOTONIC, &t );
+  return (uint64_t)t.tv_sec * 1000000000ull + (uint64_t)t.tv_nsec;
+}
+
+void
+  harness_report( const char *name, uint32_t passes, uint64_t ns, double *per_pass )
+{
+  double const d = passes ? (double)ns / passes : 0.0;
+
+  printf( "%-44s %10.1f ns/pass\n", name, d );
+  if( per_pass )
+    *per_pass = d;
+}
+
+int
+  harness_check( int ok, const char *what, const char *file, int line )
+{
+  ++checks;
+  if( !ok ) {
+    ++failed;
+    printf( "%s:%d: check failed: %s\n", file, line, what );
+  }
+  return ok;
+}
+
+int
+  harness_done( void )
+{
+  printf( "%u checks, %u failed\n", checks, failed );
+  return failed ? 1 : 0;
+}
+
+uint32_t
+  harness_rand( void )
+{
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
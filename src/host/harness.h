@@ -0,0 +1,106 @@
+/**
+ * @file   harness.h
+ * @brief  linux host checks and ns per pass timing for src/host/test
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ */
+
+#ifndef   __harness_h
+#define   __harness_h
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Each test program checks results with HARNESS_CHECK(), times the code
+ * with HARNESS_BENCH() and returns harness_done() from main(). ctest goes
+ * by the exit code, so only the checks gate a build. The times are x86
+ * numbers, good for comparing two versions of the code on one machine;
+ * they say little about the e200z3.
+ */
+
+#define HARNESS_ROUNDS    ( 5 )       /**< a bench keeps its best round   */
+
+/**
+ * @brief results the compiler has to keep, store what a bench computes
+ */
+extern volatile uint32_t harness_sink;
+
+/**
+ * @brief check x, print it with file and line when it fails
+ */
+#define HARNESS_CHECK( x ) \
+  harness_check( !!(x), #x, __FILE__, __LINE__ )
+
+/**
+ * @brief time 'passes' runs of body, best of HARNESS_ROUNDS, and print
+ *        the ns per pass under 'name'
+ * @note the ns per pass also goes in 'ns', a double
+ */
+#define HARNESS_BENCH( name, passes, ns, body )                             \
+  do {                                                                      \
+    uint32_t __round, __pass;                                               \
+    uint64_t __t, __best = UINT64_MAX;                                      \
+    for( __round = 0; __round < HARNESS_ROUNDS; ++__round ) {               \
+      __t = harness_ns();                                                   \
+      for( __pass = 0; __pass < (uint32_t)(passes); ++__pass ) {            \
+        body;                                                               \
+      }                                                                     \
+      __t = harness_ns() - __t;                                             \
+      if( __t < __best )                                                    \
+        __best = __t;                                                       \
+    }                                                                       \
+    harness_report( (name), (passes), __best, &(ns) );                      \
+  } while( 0 )
+
+/**
+ * @public
+ * @brief monotonic clock
+ * @retval uint64_t ns
+ */
+uint64_t
+  harness_ns( void );
+
+/**
+ * @public
+ * @brief print one bench line, see HARNESS_BENCH()
+ */
+void
+  harness_report( const char *name, uint32_t passes, uint64_t ns, double *per_pass );
+
+/**
+ * @public
+ * @brief count a check, see HARNESS_CHECK()
+ * @retval int ok
+ */
+int
+  harness_check( int ok, const char *what, const char *file, int line );
+
+/**
+ * @public
+ * @brief print the check totals
+ * @retval int exit code for main(), 0 if every check passed
+ */
+int
+  harness_done( void );
+
+/**
+ * @public
+ * @brief same inputs on every run
+ * @retval uint32_t next of a xorshift sequence
+ */
+uint32_t
+  harness_rand( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __harness_h
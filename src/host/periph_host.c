@@ -0,0 +1,89 @@
+/**
+ * @file       periph_host.c
+ * @headerfile periph_host.h
+ * @brief      linux host peripherals, plain memory at the MPC5634 addresses
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "mpc563xm.h"
+#include "etpu_struct.h"
+#include "etpu_util.h"
+#include "FLASH_OPS.h"
+#include "periph_host.h"
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+#define BRIDGE_A       0xC3F80000ul   /**< FMPLL .. eTPU code ram         */
+#define BRIDGE_A_SIZE  0x00080000ul
+#define BRIDGE_B       0xFFF00000ul   /**< XBAR .. eSCI, eQADC, INTC, DMA */
+#define BRIDGE_B_SIZE  0x00100000ul
+#define SCM_SIZE       6              /**< 14K eTPU code ram on the 5634  */
+#define ETPU_CHANNELS  32
+
+/* --| TYPES    |--------------------------------------------------------- */
+/* --| STATICS  |--------------------------------------------------------- */
+/* --| INLINES  |--------------------------------------------------------- */
+/* --| INTERNAL |--------------------------------------------------------- */
+static void
+  map( uint32_t addr, uint32_t size, int fill )
+{
+  void *p = mmap( (void *)(uintptr_t)addr, size, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0 );
+
+  if( p != (void *)(uintptr_t)addr ) {
+    fprintf( stderr, "periph_host: can't map 0x%08x, build non-PIE\n", addr );
+    exit( 2 );
+  }
+  memset( p, fill, size );
+}
+
+/* --| PUBLIC   |--------------------------------------------------------- */
+void
+  periph_host_init( void )
+{
+  map( BRIDGE_A, BRIDGE_A_SIZE, 0 );
+  map( BRIDGE_B, BRIDGE_B_SIZE, 0 );
+  map( FLASH_BASE, FLASH_SIZE, 0xff );
+
+  /* reset values the init code checks or waits on */
+  SIU.MIDR.B.PARTNUM = 0x5634;    /**< System_Init() stops on any other */
+  eTPU->MCR.B.SCMSIZE = SCM_SIZE;
+  CFLASH0.MCR.B.DONE = 1;         /**< no program or erase running      */
+  CFLASH0.MCR.B.PEG = 1;
+  EQADC.FISR[0].B.EOQF = 1;       /**< init_ADC()'s config scan is done */
+}
+
+int
+  periph_host_load_cal( const char *path )
+{
+  FILE *f = fopen( path, "rb" );
+  size_t n;
+
+  if( !f ) {
+    perror( path );
+    return -1;
+  }
+  n = fread( (void *)(uintptr_t)BLK1B_BASE, 1, BLK2A_BASE - BLK1B_BASE, f );
+  fclose( f );
+  return n > 0 ? 0 : -1;
+}
+
+void
+  periph_host_etpu_service( void )
+{
+  int ch;
+
+  for( ch = 0; ch < ETPU_CHANNELS; ++ch )
+    eTPU->CHAN[ ch ].HSRR.R = 0;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file   periph_host.h
+ * @brief  linux host peripherals, plain memory at the MPC5634 addresses
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ */
+
+#ifndef   __periph_host_h
+#define   __periph_host_h
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * The peripheral bridges (0xC3F80000 and 0xFFF00000 up, eTPU RAM and code
+ * included) are mapped as ram at their real addresses, so mpc563xm.h,
+ * etpu_util and the *_OPS init code run unchanged: registers read back
+ * what was last written and nothing moves by itself. The flash array is
+ * mapped at FLASH_BASE (FLASH_OPS.h), erased. Link non-PIE so the
+ * (uint32_t)&buffer casts for DMA addresses hold. Under BSP_HOST the
+ * register structs are big-endian (scalar_storage_order in mpc563xm.h and
+ * etpu_struct.h), so a field written through .R reads back through .B the
+ * way it does on target - the FreeScale eTPU code relies on it for CPBA.
+ *
+ * A few status bits are preset so the init code's waits fall through, see
+ * periph_host_init(). Anything that needs a peripheral to do something,
+ * an A/D scan finishing, a window opening, is up to the simulation: it
+ * fills the buffers and registers and takes the vector, bsp_host_vector().
+ */
+
+/**
+ * @public
+ * @brief map the peripherals and flash, and preset them
+ * @note exits if the addresses can't be mapped, call once before anything
+ *       touches a register
+ */
+void
+  periph_host_init( void );
+
+/**
+ * @public
+ * @brief load a calibration block into BLK1B, as a burn would leave it
+ * @param[in] path image from tools/msq_image.py --little
+ * @retval int 0 on success
+ * @note call before init_variables()
+ */
+int
+  periph_host_load_cal( const char *path );
+
+/**
+ * @public
+ * @brief what the eTPU does with a host service request: take it, so the
+ *        channel's HSRR reads 0 again
+ * @note the fuel and spark setters retry while a request is pending, call
+ *       this between engine passes
+ */
+void
+  periph_host_etpu_service( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __periph_host_h
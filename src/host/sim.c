@@ -0,0 +1,367 @@
+/**
+ * @file   sim.c
+ * @brief  runs the o5e main.c task set on the linux host, virtual time
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ *   o5e_sim [-t ms] [-r rpm] [-c cal.bin] [-s cpu_scale] [-i isr_clocks] [-l ms]
+ *           [-a ms] [-e pct] [-g ms]
+ *
+ * main.c builds unchanged as o5e_main(). What the eTPU and the A/D would
+ * do is faked here: every angle window moves TCR2 and holds the crank
+ * channel at full sync and the set speed, then takes the real
+ * Angle_Clock_ISR through the INTC vector, and the first window in each
+ * cylinder event drops a MAP burst in the next Q5 DMA half and takes the
+ * real Q5 DMA interrupt; every 1ms tick drops a Q0 scan in the next DMA
+ * half and takes the real Q0 DMA interrupt; the host
+ * service requests are taken each time the code masks interrupts. At the end
+ * the run is reported and checked: the angle clock counted every degree,
+ * the rpm read back off the crank channel, and every task ran. With -l
+ * the crank loses sync at that ms for SYNC_LOST_MS, and the angle clock
+ * has to have started again from where sync came back. With -a the
+ * throttle opens at that ms over ACCEL_RAMP_MS, the accel and decel tables
+ * are made flat in RPM and without decay, and the biggest enrichment is
+ * reported, and checked against -e. The enrichment works per Engine10
+ * pass, so the same -e has to hold at any rpm.
+ *
+ * Every fuel and spark command is timed from its write (the host service
+ * request) to its use, where the pulse it sets up starts: the injection,
+ * Inj_End_Angle plus the pulse before TDC, and the dwell, the advance plus
+ * the dwell before TDC (a waste spark coil's first cylinder). The mean and
+ * worst ages are reported, and with -g the means are checked against it.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include "config.h"
+#include "mpc563xm.h"
+#include "cocoos.h"
+#include "main.h"
+#include "variables.h"
+#include "etpu_util.h"
+#include "etpu_struct.h"
+#include "etpu_app_eng_pos.h"
+#include "etpu_crank_auto.h"
+#include "eTPU_OPS.h"
+#include "eQADC_OPS.h"
+#include "Angle_Clock.h"
+#include "Table_Lookup.h"
+#include "Angle_Events.h"
+#include "Engine_OPS.h"
+#include "bsp_host.h"
+#include "periph_host.h"
+
+#define ANGLE_VECTOR   ( 68 + ANGLE_CLOCK_CHANNEL )   /**< eTPU A channel */
+#define Q0_VECTOR      ( 11 + 1 )                     /**< eDMA channel 1 */
+#define Q5_VECTOR      ( 11 + 11 )                    /**< eDMA channel 11 */
+#define SYNC_LOST_MS   ( 100 )
+#define ACCEL_RAMP_MS  ( 100 )
+#define TPS_CLOSED     ( 4000 )                       /**< A/D counts  */
+#define TPS_OPEN       ( 12000 )
+#define AGE_FROM_MS    ( 200 )                        /**< settled       */
+#define CHANNELS       ( 32 )                         /**< eTPU A        */
+#define WRITES         ( 4 )                          /**< kept, newest first */
+
+#ifndef HOST_CAL_IMAGE
+#define HOST_CAL_IMAGE "CurrentTune.bin"
+#endif
+
+extern uint32_t etpu_a_tcr1_freq;      /**< eTPU_OPS.c                  */
+extern uint8_t  g_crank_channel;       /**< etpu_app_eng_pos.c          */
+
+void o5e_main( void );
+
+/* --| TYPES    |--------------------------------------------------------- */
+/* --| STATICS  |--------------------------------------------------------- */
+static uint32_t run_ms = 1000;
+static float    rpm = 3000.0f;
+static uint32_t lose_ms;               /**< 0 for sync all the way      */
+static uint32_t accel_ms;              /**< 0 for the throttle wobble   */
+static float    accel_expect = -1.0f;  /**< % from -e, < 0 for no check */
+static float    accel_peak;            /**< biggest |correction|, %     */
+static float    age_limit;             /**< ms from -g, 0 for no check  */
+static uint8_t  q0_buf;
+static uint8_t  q5_buf;
+
+/* command age at use, fuel and spark */
+static struct
+{
+  const char *name;
+  uint32_t    uses;
+  double      sum, max;              /**< ms                          */
+} age[ 2 ] = { { "fuel" }, { "spark" } };
+static double   written[ CHANNELS ][ WRITES ];   /**< ms, newest first  */
+
+/* --| INLINES  |--------------------------------------------------------- */
+/* --| INTERNAL |--------------------------------------------------------- */
+
+/* what the crank channel would show at 'rpm', full sync (or looking for
+   it during the -l gap) and the tooth period
+   fs_etpu_eng_pos_get_engine_speed() works from */
+static void
+  crank( void )
+{
+  uint32_t period = (uint32_t)(etpu_a_tcr1_freq * 60.0 / (rpm * Total_Teeth));
+  int const lost = lose_ms && systime >= lose_ms && systime < lose_ms + SYNC_LOST_MS;
+
+  fs_etpu_set_global_24( FS_ETPU_ENG_POS_SYNC_STATUS_GLOBAL_OFFSET,
+                         lost ? FS_ETPU_ENG_POS_SEEK : FS_ETPU_ENG_POS_FULL_SYNC );
+  fs_etpu_set_chan_local_8( g_crank_channel, FS_ETPU_CRANK_PHYSICAL_CRANK_TEETH_OFFSET, N_Teeth );
+  fs_etpu_set_chan_local_8( g_crank_channel, FS_ETPU_CRANK_MISSING_TOOTH_COUNT_OFFSET, Missing_Teeth );
+  fs_etpu_set_chan_local_24( g_crank_channel, FS_ETPU_CRANK_TOOTH_PERIOD_A_OFFSET, period );
+}
+
+/* virtual time in ms */
+static double
+  now_ms( void )
+{
+  return (double)bsp_get_timebase() / BSP_DECR_PERIOD;
+}
+
+/* the eTPU takes the host service requests, each one a command written */
+static void
+  service( void )
+{
+  uint8_t ch, i;
+
+  for( ch = 0; ch < CHANNELS; ++ch ) {
+    if( eTPU->CHAN[ ch ].HSRR.R == 0 )
+      continue;
+    for( i = WRITES - 1; i > 0; --i )
+      written[ ch ][ i ] = written[ ch ][ i - 1 ];
+    written[ ch ][ 0 ] = now_ms();
+  }
+  periph_host_etpu_service();
+}
+
+/* channel ch's command, used 'btdc_x100' before cylinder cyl's TDC: if
+   that angle came up since the last window, how old the command was */
+static void
+  use( int kind, uint8_t ch, uint8_t cyl, float btdc_x100,
+       uint32_t from_x100, uint32_t to_x100, double from_ms, double to_ms )
+{
+  uint32_t const span = (to_x100 + 72000 - from_x100) % 72000;
+  int32_t at = (Angle_Cyl_TDC( cyl ) - (int32_t)btdc_x100) % 72000;
+  uint32_t past;
+  double t;
+  uint8_t i;
+
+  if( at < 0 )
+    at += 72000;
+  past = ((uint32_t)at + 72000 - from_x100) % 72000;
+  if( past == 0 || past > span || ch >= CHANNELS )
+    return;
+  t = from_ms + (to_ms - from_ms) * past / span;
+  for( i = 0; i < WRITES && written[ ch ][ i ] > t; ++i )
+    ;
+  if( i == WRITES || written[ ch ][ i ] == 0.0 || t < AGE_FROM_MS )
+    return;
+  t -= written[ ch ][ i ];
+  ++age[ kind ].uses;
+  age[ kind ].sum += t;
+  if( t > age[ kind ].max )
+    age[ kind ].max = t;
+}
+
+/* the uses between the last window and this one */
+static void
+  uses( uint32_t angle_x100 )
+{
+  static uint32_t from_x100;
+  static double from_ms;
+  double const to_ms = now_ms();
+  float const deg_per_ms_x100 = RPM * 0.6f;
+  float const inj_x100 = table_lookup( RPM, Reference_VE, Inj_End_Angle_Table ) * 100.0f;
+  uint8_t c;
+
+  if( from_ms > 0.0 && RPM > 0.0f ) {
+    for( c = 0; c < N_Injectors; ++c )
+      use( 0, Fuel_Channels[ c ], c, inj_x100 + Pulse_Width * deg_per_ms_x100,
+           from_x100, angle_x100, from_ms, to_ms );
+    for( c = 0; c < N_Coils; ++c )
+      use( 1, Spark_Channels[ c ], c, Spark_Advance * 100.0f + Dwell * deg_per_ms_x100,
+           from_x100, angle_x100, from_ms, to_ms );
+  }
+  from_x100 = angle_x100;
+  from_ms = to_ms;
+}
+
+/* a MAP window's burst lands in the next DMA half */
+static void
+  map_burst( void )
+{
+  uint8_t i;
+
+  for( i = 0; i < ADC_Q5_SIZE; ++i )
+    ADC_Q5_Buf[ q5_buf ][ i ] = 6000;
+  EDMA.TCD[ 11 ].CITER = q5_buf ? 2 * ADC_Q5_SIZE : ADC_Q5_SIZE;
+  q5_buf ^= 1;
+  bsp_host_vector( Q5_VECTOR );
+}
+
+/* a window opened: TCR2 is the engine angle in cycle ticks, and a MAP
+   burst once per cylinder event while in sync */
+static void
+  angle( uint32_t angle_x100 )
+{
+  static uint32_t last_cyl = ~0u;
+  uint32_t const cycle = (uint32_t)Ticks_Per_Tooth * Total_Teeth * 2;
+  uint32_t const cyl = angle_x100 * (N_Cyl ? N_Cyl : 1) / 72000;
+
+  crank();
+  uses( angle_x100 );
+  eTPU->TB2R_A.R = (uint32_t)((uint64_t)angle_x100 * cycle / 72000);
+  eTPU->CHAN[ ANGLE_CLOCK_CHANNEL ].SCR.B.CIS = 1;
+  if( cyl != last_cyl &&
+      fs_etpu_eng_pos_get_engine_position_status() == FS_ETPU_ENG_POS_FULL_SYNC )
+    map_burst();
+  last_cyl = cyl;
+}
+
+/* accel and decel: same sensitivity at every rpm, no limit, no decay */
+static void
+  flat_enrichment( void )
+{
+  struct table * const t[] = {
+    (struct table *)Accel_Limit_Table, (struct table *)Accel_Sensativity_Table,
+    (struct table *)Accel_Decay_Table, (struct table *)Decel_Limit_Table,
+    (struct table *)Decel_Sensativity_Table, (struct table *)Decel_Decay_Table };
+  static const float value[] = { 100.0f, 10.0f, 0.0f, 100.0f, 10.0f, 0.0f };
+  uint8_t n, i;
+
+  for( n = 0; n < sizeof( t ) / sizeof( t[ 0 ] ); ++n )
+    for( i = 0; i < t[ n ]->cols; ++i )
+      t[ n ]->data[ i ] = value[ n ];
+  Page_Changed( 2 );
+}
+
+/* the throttle, closed then opened over ACCEL_RAMP_MS with -a, a little
+   wobble without */
+static uint16_t
+  throttle( void )
+{
+  if( accel_ms == 0 )
+    return (uint16_t)(4000 + (systime & 0x3ff));
+  if( systime < accel_ms )
+    return TPS_CLOSED;
+  if( systime >= accel_ms + ACCEL_RAMP_MS )
+    return TPS_OPEN;
+  return (uint16_t)(TPS_CLOSED + (TPS_OPEN - TPS_CLOSED) * (systime - accel_ms) / ACCEL_RAMP_MS);
+}
+
+/* a Q0 scan lands in the next DMA half, steady sensors and the throttle
+   so the filters and enrichment see something */
+static void
+  tick( void )
+{
+  uint8_t i;
+
+  if( accel_ms && systime == 1 )
+    flat_enrichment();
+  if( accel_ms && systime >= accel_ms && fabsf( Accel_Decel_Corr - 1.0f ) * 100.0f > accel_peak )
+    accel_peak = fabsf( Accel_Decel_Corr - 1.0f ) * 100.0f;
+
+  for( i = 0; i < ADC_Q0_SIZE; ++i )
+    ADC_Q0_Buf[ q0_buf ][ i ] = 8192;
+  ADC_Q0_Buf[ q0_buf ][ V_MAP_2_AD ] = 6000;
+  ADC_Q0_Buf[ q0_buf ][ V_TPS_AD ] = throttle();
+  EDMA.TCD[ 1 ].CITER = q0_buf ? 2 * ADC_Q0_SIZE : ADC_Q0_SIZE;
+  q0_buf ^= 1;
+  bsp_host_vector( Q0_VECTOR );
+}
+
+static void
+  done( void )
+{
+  const struct os_task_stats *s = os_task_stats_get();
+  uint32_t const synced_ms = lose_ms ? run_ms - (lose_ms + SYNC_LOST_MS) : run_ms;
+  double const degrees = rpm * 6.0 * synced_ms / 1000.0;
+  int failed = 0;
+  uint8_t tid, tasks;
+
+  bsp_host_report();
+  printf( "Degree_Clock %u, %.0f expected; RPM %.0f\n", Degree_Clock, degrees, RPM );
+  if( accel_ms )
+    printf( "accel/decel enrichment peak %.3f%%\n", accel_peak );
+  for( tid = 0; tid < 2; ++tid )
+    printf( "%-5s command age at use: mean %.2f ms, worst %.2f ms, %u uses\n", age[ tid ].name,
+            age[ tid ].uses ? age[ tid ].sum / age[ tid ].uses : 0.0, age[ tid ].max, age[ tid ].uses );
+
+  if( !Flash_OK ) {
+    printf( "check failed: calibration not loaded\n" );
+    failed = 1;
+  }
+  if( fabs( Degree_Clock - degrees ) > 720.0 + degrees * 0.01 ) {
+    printf( "check failed: angle clock\n" );
+    failed = 1;
+  }
+  if( fabsf( RPM - rpm ) > rpm * 0.01f + 1.0f ) {
+    printf( "check failed: rpm read back\n" );
+    failed = 1;
+  }
+  if( accel_expect >= 0.0f && fabsf( accel_peak - accel_expect ) > 0.001f ) {
+    printf( "check failed: enrichment %.3f%%, %.3f%% expected\n", accel_peak, accel_expect );
+    failed = 1;
+  }
+  for( tid = 0; age_limit > 0.0f && tid < 2; ++tid ) {
+    if( age[ tid ].uses == 0 || age[ tid ].sum / age[ tid ].uses > age_limit ) {
+      printf( "check failed: %s commands older than %.2f ms\n", age[ tid ].name, age_limit );
+      failed = 1;
+    }
+  }
+  /* the tasks main.c creates, in tid order */
+  tasks = (uint8_t)((Flash_OK ? 5 + (Sync_Mode_Select == 1) : 0) + 4);
+  for( tid = 0; tid < tasks; ++tid ) {
+    if( s[ tid ].runs == 0 ) {
+      printf( "check failed: task %u never ran\n", tid );
+      failed = 1;
+    }
+  }
+  exit( failed );
+}
+
+/* --| PUBLIC   |--------------------------------------------------------- */
+int
+  main( int argc, char *argv[] )
+{
+  const char *cal = HOST_CAL_IMAGE;
+  float scale = 0.0f;
+  uint32_t isr_clocks = 200;
+  int c;
+
+  while( (c = getopt( argc, argv, "t:r:c:s:i:l:a:e:g:" )) != -1 ) {
+    switch( c ) {
+      case 't': run_ms = (uint32_t)atol( optarg );     break;
+      case 'r': rpm = (float)atof( optarg );           break;
+      case 'c': cal = optarg;                          break;
+      case 's': scale = (float)atof( optarg );         break;
+      case 'i': isr_clocks = (uint32_t)atol( optarg ); break;
+      case 'l': lose_ms = (uint32_t)atol( optarg );    break;
+      case 'a': accel_ms = (uint32_t)atol( optarg );   break;
+      case 'e': accel_expect = (float)atof( optarg );  break;
+      case 'g': age_limit = (float)atof( optarg );     break;
+      default:
+        fprintf( stderr, "usage: %s [-t ms] [-r rpm] [-c cal.bin] [-s cpu_scale] [-i isr_clocks] [-l ms] [-a ms] [-e pct] [-g ms]\n", argv[ 0 ] );
+        return 2;
+    }
+  }
+
+  periph_host_init();
+  if( periph_host_load_cal( cal ) )
+    return 2;
+  bsp_host_init( run_ms, isr_clocks, done );
+  bsp_host_angle_init( ANGLE_CLOCK_WINDOWS, angle );
+  bsp_host_angle_vector( ANGLE_VECTOR );
+  bsp_host_tick_hook( tick );
+  bsp_host_mask_hook( service );
+  bsp_host_cpu_scale( scale );
+  bsp_host_set_rpm( rpm );
+
+  o5e_main();                 /**< os_start() doesn't return, done() exits */
+  return 1;
+}
@@ -0,0 +1,273 @@
+/**
+ * @file   bench_ad_filter.c
+ * @brief  the Q0 A/D filter bank: each filter's response, and ns per scan
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ * Scans are fed straight to AD_Filter_Scan() 1 ms apart. The filter types
+ * and times are written into the tune's page 5 and Page_Changed() picks
+ * them up, the way a tuner write does, then AD_Filter_Update() works out
+ * the coefficients the way Get_Slow_Op_Vars() does. The default filters are held
+ * against the old Filter_AD() 1/8 smoothing, run at the rate
+ * Get_Fast_Op_Vars() and Get_Slow_Op_Vars() read the sensors.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "typedefs.h"
+#include "config.h"
+#include "err.h"
+#include "variables.h"
+#include "eQADC_OPS.h"
+#include "AD_Filter.h"
+#include "periph_host.h"
+#include "harness.h"
+
+#define FILTER_PAGE ( 4 )         /**< variables.h, AD_Filter_Type_Array  */
+#define PERIOD      ( CPU_CLOCK / 1000 )          /**< 1 ms scans, clocks */
+#define SCANS       ( 1024 )      /**< random scans for the bench         */
+#define PASSES      ( 100000 )
+#define CH          ( 0 )         /**< a channel with no default filter   */
+
+#define TYPES  ((uint8_t *)AD_Filter_Type_Array)
+#define TIMES  ((float *)AD_Filter_Time_Array)
+
+static uint16_t raw[ ADC_Q0_SIZE ];
+static uint16_t out[ ADC_Q0_SIZE ];
+static uint16_t random_scans[ SCANS ][ ADC_Q0_SIZE ];
+static uint32_t now;
+static uint32_t scans;
+
+static void
+  scan( const uint16_t *r )
+{
+  now += PERIOD;
+  AD_Filter_Scan( r, out, now );
+}
+
+/* a tuner write, and the slow task's pass that follows it */
+static void
+  retune( void )
+{
+  Page_Changed( FILTER_PAGE );
+  AD_Filter_Update();
+}
+
+static void
+  set_all( uint8_t type, float time )
+{
+  uint8_t ch;
+
+  for( ch = 0; ch < ADC_Q0_SIZE; ++ch ) {
+    TYPES[ ch ] = type;
+    TIMES[ ch ] = time;
+  }
+}
+
+static void
+  set( uint8_t ch, uint8_t type, float time )
+{
+  TYPES[ ch ] = type;
+  TIMES[ ch ] = time;
+}
+
+/* all channels at v, n scans */
+static void
+  hold( uint16_t v, uint32_t n )
+{
+  uint8_t ch;
+
+  for( ch = 0; ch < ADC_Q0_SIZE; ++ch )
+    raw[ ch ] = v;
+  while( n-- )
+    scan( raw );
+}
+
+static int
+  cmp( const void *a, const void *b )
+{
+  return *(const uint16_t *)a - *(const uint16_t *)b;
+}
+
+/* the old Filter_AD( ch, 3 ) */
+static uint16_t
+  old_filter( uint16_t prev, uint16_t v )
+{
+  return (uint16_t)((v + prev * 7) >> 3);
+}
+
+static void
+  bench_scan( void )
+{
+  scan( random_scans[ scans++ % SCANS ] );
+}
+
+int
+  main( void )
+{
+  uint16_t hist[ AD_FILTER_WINDOW ], sorted[ AD_FILTER_WINDOW ];
+  uint16_t tps, clt, before, v;
+  uint32_t i, k, sum, bad;
+  float worst;
+  uint8_t ch;
+  double ns;
+
+  periph_host_init();
+  if( periph_host_load_cal( HOST_CAL_IMAGE ) )
+    return 2;
+  err_init();
+  init_variables();
+  HARNESS_CHECK( Flash_OK );
+
+  /* the scans pass through until the task has coefficients, which needs
+     the rate, which needs two scans */
+  raw[ CH ] = 1234;
+  scan( raw );
+  HARNESS_CHECK( out[ CH ] == 1234 );
+  AD_Filter_Update();
+  scan( raw );
+  HARNESS_CHECK( out[ CH ] == 1234 );
+  AD_Filter_Update();
+
+  /* default (the example tune): EMA on the old Filter_AD() channels, run
+     against the old smoothing at its 10 and 103 msec reads. A channel
+     without one passes through */
+  hold( 1000, 200 );
+  tps = clt = 1000;
+  worst = 0.0f;
+  for( i = 1; i <= 3000; ++i ) {
+    hold( 9000, 1 );
+    if( i % 10 == 0 ) {
+      tps = old_filter( tps, 9000 );
+      if( abs( out[ V_TPS_AD ] - tps ) > worst )
+        worst = abs( out[ V_TPS_AD ] - tps );
+    }
+    if( i % 103 == 0 ) {
+      clt = old_filter( clt, 9000 );
+      if( abs( out[ V_CLT_AD ] - clt ) > worst )
+        worst = abs( out[ V_CLT_AD ] - clt );
+    }
+    HARNESS_CHECK( out[ CH ] == 9000 );
+  }
+  printf( "default filters, worst %.0f counts from the old smoothing on an 8000 step\n", worst );
+  HARNESS_CHECK( worst < 8000 * 0.03f + 8 );
+  HARNESS_CHECK( out[ V_TPS_AD ] > 8990 && out[ V_CLT_AD ] > 8800 );
+
+  /* a tuner write re-primes only the channel it changed: CLT is halfway
+     through a step and keeps going, CH restarts from its next reading */
+  hold( 1000, 3000 );
+  hold( 9000, 500 );
+  before = out[ V_CLT_AD ];
+  HARNESS_CHECK( before > 3000 && before < 7000 );
+  set( CH, AD_FILTER_EMA, 0.1f );
+  retune();
+  raw[ CH ] = 5000;
+  scan( raw );
+  HARNESS_CHECK( out[ CH ] == 5000 );
+  HARNESS_CHECK( out[ V_CLT_AD ] >= before && out[ V_CLT_AD ] < before + 20 );
+
+  /* none: raw */
+  set_all( AD_FILTER_NONE, 0.0f );
+  retune();
+  bad = 0;
+  for( i = 0; i < 1000; ++i ) {
+    for( ch = 0; ch < ADC_Q0_SIZE; ++ch )
+      raw[ ch ] = (uint16_t)(harness_rand() & 0x3fff);
+    scan( raw );
+    bad += memcmp( raw, out, sizeof( out ) ) != 0;
+  }
+  HARNESS_CHECK( bad == 0 );
+
+  /* EMA of 0.1 s: 63% of a step after 0.1 s, settled after 0.6 s */
+  set_all( AD_FILTER_EMA, 0.1f );
+  retune();
+  hold( 0, 10 );
+  hold( 10000, 100 );
+  HARNESS_CHECK( out[ CH ] > 6100 && out[ CH ] < 6400 );
+  hold( 10000, 500 );
+  HARNESS_CHECK( out[ CH ] >= 9970 );
+
+  /* average of 5 ms: the mean of the last 5 readings, rounded */
+  set_all( AD_FILTER_AVERAGE, 0.005f );
+  retune();
+  bad = 0;
+  for( i = 0; i < 1000; ++i ) {
+    v = (uint16_t)(harness_rand() & 0x3fff);
+    hist[ i % 5 ] = raw[ CH ] = v;
+    scan( raw );
+    if( i >= 4 ) {
+      for( sum = 0, k = 0; k < 5; ++k )
+        sum += hist[ k ];
+      bad += out[ CH ] != (uint16_t)((sum + 2) / 5);
+    }
+  }
+  HARNESS_CHECK( bad == 0 );
+
+  /* median of 7 ms: the middle of the last 7, single spikes never show */
+  set_all( AD_FILTER_MEDIAN, 0.007f );
+  retune();
+  bad = 0;
+  for( i = 0; i < 1000; ++i ) {
+    v = (uint16_t)(harness_rand() & 0x3fff);
+    hist[ i % 7 ] = raw[ CH ] = v;
+    scan( raw );
+    if( i >= 6 ) {
+      memcpy( sorted, hist, 7 * sizeof( hist[ 0 ] ) );
+      qsort( sorted, 7, sizeof( sorted[ 0 ] ), cmp );
+      bad += out[ CH ] != sorted[ 3 ];
+    }
+  }
+  HARNESS_CHECK( bad == 0 );
+  hold( 2000, 7 );
+  for( i = 0; i < 100; ++i ) {
+    raw[ CH ] = i % 4 == 0 ? 16000 : 2000;
+    scan( raw );
+    bad += out[ CH ] != 2000;
+  }
+  HARNESS_CHECK( bad == 0 );
+
+  /* rate limit of 1 s full scale: 16 counts a scan, small moves are exact */
+  set_all( AD_FILTER_RATE, 1.0f );
+  retune();
+  hold( 1000, 2 );
+  hold( 1010, 1 );
+  HARNESS_CHECK( out[ CH ] == 1010 );
+  hold( 9000, 100 );
+  HARNESS_CHECK( out[ CH ] == 1010 + 100 * 16 );
+  hold( 0, 10 );
+  HARNESS_CHECK( out[ CH ] == 1010 + 90 * 16 );
+
+  /* ns per scan of all 40 channels, the scan rate steady */
+  for( i = 0; i < SCANS; ++i ) {
+    for( ch = 0; ch < ADC_Q0_SIZE; ++ch )
+      random_scans[ i ][ ch ] = (uint16_t)(harness_rand() & 0x3fff);
+  }
+  set_all( AD_FILTER_NONE, 0.0f );
+  retune();
+  HARNESS_BENCH( "AD_Filter_Scan, none", PASSES, ns, bench_scan() );
+  set_all( AD_FILTER_EMA, 0.1f );
+  retune();
+  HARNESS_BENCH( "AD_Filter_Scan, EMA", PASSES, ns, bench_scan() );
+  set_all( AD_FILTER_AVERAGE, 0.007f );
+  retune();
+  HARNESS_BENCH( "AD_Filter_Scan, average(7)", PASSES, ns, bench_scan() );
+  set_all( AD_FILTER_RATE, 1.0f );
+  retune();
+  HARNESS_BENCH( "AD_Filter_Scan, rate limit", PASSES, ns, bench_scan() );
+  set_all( AD_FILTER_MEDIAN, 0.007f );
+  retune();
+  HARNESS_BENCH( "AD_Filter_Scan, median(7)", PASSES, ns, bench_scan() );
+  for( ch = 0; ch < ADC_Q0_SIZE; ++ch )
+    set( ch, (uint8_t)(AD_FILTER_NONE + ch % 5), ch % 5 == 4 ? 1.0f : 0.007f );
+  retune();
+  HARNESS_BENCH( "AD_Filter_Scan, mixed (8 of each)", PASSES, ns, bench_scan() );
+  set_all( AD_FILTER_DEFAULT, 0.0f );
+  retune();
+  HARNESS_BENCH( "AD_Filter_Scan, default", PASSES, ns, bench_scan() );
+  harness_sink = out[ CH ];
+
+  return harness_done();
+}
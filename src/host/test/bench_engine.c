@@ -0,0 +1,118 @@
+/**
+ * @file   bench_engine.c
+ * @brief  ns per Engine10_Task pass and per function, CurrentTune.msq
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ * The pass is the body of Engine10_Task's loop with the sensors coming
+ * through a Q0 scan. The eTPU isn't running, so RPM is swept by setting it
+ * after the sensor read and the engine position stays unknown: Set_Fuel()
+ * does all its updates and then switches the channels off.
+ */
+
+#include <math.h>
+#include "../../../o5e/src/Engine_OPS.c"   /**< the pass steps are static */
+#include "eQADC_OPS.h"
+#include "periph_host.h"
+#include "harness.h"
+
+#define PASSES  ( 20000 )
+#define STEPS   ( 97 )        /**< sweep points, prime so they mix        */
+
+static int32_t  step;
+static float    rpm;
+static float    load[ STEPS ];  /**< Reference_VE at each step            */
+
+static void
+  sensors( void )
+{
+  uint8_t i;
+
+  step = step + 1 < STEPS ? step + 1 : 0;
+  rpm = 500.0f + step * (8500.0f / STEPS);
+  for( i = 0; i < ADC_Q0_SIZE; ++i )
+    ADC_Q0_Buf[ 0 ][ i ] = 8192;
+  ADC_Q0_Buf[ 0 ][ V_MAP_2_AD ] = (uint16_t)(2000 + step * 120);
+  ADC_Q0_Buf[ 0 ][ V_TPS_AD ] = (uint16_t)(1000 + step * 100);
+  ADC_Scan_Done( 0 );
+}
+
+/* next step of the sweep without the sensor read, for timing what comes
+   after it on its own */
+static void
+  sweep( void )
+{
+  step = step + 1 < STEPS ? step + 1 : 0;
+  RPM = 500.0f + step * (8500.0f / STEPS);
+  Reference_VE = load[ step ];
+}
+
+static void
+  fast_vars( void )
+{
+  Get_Fast_Op_Vars();
+  RPM = rpm;                  /**< the eTPU would have it               */
+}
+
+static void
+  engine_pass( void )
+{
+  sensors();
+  fast_vars();
+  MAP_Sample_Update();
+  Knock_Update();
+  Get_Reference_VE();
+  Get_Speed_Load_Tables();
+  Set_Spark();
+  Set_Fuel();
+  fs_etpu_pwm_update( TACH_CHANNEL, (uint32_t)(RPM * Pulses_Per_Rev) / 60, 1000, etpu_tcr1_freq );
+  periph_host_etpu_service();
+}
+
+int
+  main( void )
+{
+  double ns, pass_ns;
+  uint32_t i;
+
+  periph_host_init();
+  if( periph_host_load_cal( HOST_CAL_IMAGE ) )
+    return 2;
+  err_init();
+  init_variables();
+  HARNESS_CHECK( Flash_OK );
+
+  Get_Slow_Op_Vars();
+  engine_pass();
+  Get_Base_Pulse_Width();
+
+  /* every point of the sweep gives sane outputs */
+  for( i = 0; i < STEPS; ++i ) {
+    engine_pass();
+    load[ step ] = Reference_VE;
+    if( !HARNESS_CHECK( Reference_VE > 0.0f && Reference_VE < 400.0f ) ||
+        !HARNESS_CHECK( Spark_Advance > -20.0f && Spark_Advance < 80.0f ) ||
+        !HARNESS_CHECK( Inj_End_Angle_x100 >= 0 && Inj_End_Angle_x100 < 72000 ) ||
+        !HARNESS_CHECK( isfinite( Pulse_Width ) && Pulse_Width >= 0.0f ) )
+      break;
+  }
+
+  HARNESS_BENCH( "engine pass", PASSES, pass_ns, engine_pass() );
+
+  HARNESS_BENCH( "  Q0 scan (ADC_Scan_Done)", PASSES, ns, sensors() );
+  HARNESS_BENCH( "  Get_Fast_Op_Vars", PASSES, ns, fast_vars() );
+  HARNESS_BENCH( "  MAP_Sample_Update + Knock_Update", PASSES, ns,
+                 MAP_Sample_Update(); Knock_Update() );
+  HARNESS_BENCH( "  Get_Reference_VE", PASSES, ns, Get_Reference_VE() );
+  HARNESS_BENCH( "  sweep step only", PASSES, ns, sweep() );
+  HARNESS_BENCH( "  Get_Speed_Load_Tables (+ sweep step)", PASSES, ns,
+                 sweep(); Get_Speed_Load_Tables() );
+  HARNESS_BENCH( "  Set_Spark", PASSES, ns, Set_Spark() );
+  HARNESS_BENCH( "  Set_Fuel", PASSES, ns, Set_Fuel(); periph_host_etpu_service() );
+  HARNESS_BENCH( "Get_Slow_Op_Vars (every 100 ms)", PASSES, ns, Get_Slow_Op_Vars() );
+
+  harness_sink = (uint32_t)pass_ns;
+  return harness_done();
+}
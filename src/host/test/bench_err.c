@@ -0,0 +1,225 @@
+/**
+ * @file   bench_err.c
+ * @brief  err ring and per code counters, and ns per push against the
+ *         old masked fifo
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ * old_push() and friends are err_push/err_pop/err_destroy from before the
+ * ring, on the fifo/lifo they used. The masked sections are counted with
+ * the host bsp's mask hook.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/time.h>
+#include "../../fifo.c"
+#include "../../lifo.c"
+#include "bsp.h"
+#include "err.h"
+#include "../../err/err_prv.h"      /**< err_head/err_tail            */
+#include "bsp_host.h"
+#include "periph_host.h"
+#include "harness.h"
+
+#define PUSHES  ( 1000000 )
+#define CODES   ( 8 )         /**< codes in the bench mix                 */
+#define DRAIN   ( 64 )        /**< pushes between drains                  */
+
+#define TEST_CODE( i_ )  RECOVERABLE( yyyyy_CODE( (0x10 + (i_)) ) )
+
+/* --| the old err, fifo of records from a free lifo |-------------------- */
+struct old_err
+{
+  fifo_t link;
+  uint32_t code;
+  uint64_t ts;
+};
+
+static struct old_err  old_pool[ ERR_DEPTH ];
+static struct old_err *old_free;
+static fifo_t          old_fifo;
+
+static void
+  old_init( void )
+{
+  uint32_t i;
+
+  fifo_init( &old_fifo );
+  old_free = 0;
+  for( i = 0; i < ERR_DEPTH; i++ )
+    old_free = lifo_push( old_free, &old_pool[ i ] );
+}
+
+static void
+  old_push( uint32_t code )
+{
+  struct old_err *e;
+  bsp_declare_state();
+
+  bsp_disable_interrupts();
+  e = lifo_pop( &old_free );
+  bsp_enable_interrupts();
+
+  if( e ) {
+    e->ts = bsp_get_timebase();
+    e->code = code;
+    bsp_disable_interrupts();
+    fifo_push( &old_fifo, e );
+    bsp_enable_interrupts();
+  }
+}
+
+static struct old_err *
+  old_pop( void )
+{
+  struct old_err *e;
+  bsp_declare_state();
+
+  bsp_disable_interrupts();
+  e = fifo_pop( &old_fifo );
+  bsp_enable_interrupts();
+  return e;
+}
+
+static void
+  old_destroy( struct old_err *e )
+{
+  bsp_declare_state();
+
+  bsp_disable_interrupts();
+  old_free = lifo_push( old_free, e );
+  bsp_enable_interrupts();
+}
+
+/* --| both, the bench mix |---------------------------------------------- */
+static uint32_t masks;
+static uint32_t pushes;
+
+static void
+  mask( void )
+{
+  ++masks;
+}
+
+static void
+  new_mix( void )
+{
+  const err_t *e;
+
+  err_push( TEST_CODE( pushes % CODES ) );
+  if( ++pushes % DRAIN == 0 ) {
+    while( (e = err_pop()) != 0 )
+      err_destroy( e );
+  }
+}
+
+static void
+  old_mix( void )
+{
+  struct old_err *e;
+
+  old_push( TEST_CODE( pushes % CODES ) );
+  if( ++pushes % DRAIN == 0 ) {
+    while( (e = old_pop()) != 0 )
+      old_destroy( e );
+  }
+}
+
+/* count for code, 0 if it has no slot */
+static uint32_t
+  count( uint32_t code )
+{
+  const struct err_counts * const c = err_counts_get();
+  uint32_t i;
+
+  for( i = 0; i < ERR_CODES; ++i ) {
+    if( c->codes[ i ].code == code )
+      return c->codes[ i ].count;
+  }
+  return 0;
+}
+
+int
+  main( void )
+{
+  struct itimerval off = { { 0, 0 }, { 0, 0 } };
+  const err_t *e;
+  uint32_t i;
+  double old_ns, new_ns;
+
+  bsp_host_init( 0, 0, 0 );
+  periph_host_init();             /**< err_push lights a led            */
+  err_init();
+
+  /* one code: queued with its time, counted, popped, gone */
+  systime = 5;
+  err_push( TEST_CODE( 0 ) );
+  e = err_pop();
+  HARNESS_CHECK( e && err_get_code( e ) == TEST_CODE( 0 ) );
+  HARNESS_CHECK( e && err_get_ts( e ) == bsp_get_timebase() );
+  if( e )
+    err_destroy( e );
+  HARNESS_CHECK( err_pop() == 0 );
+  HARNESS_CHECK( count( TEST_CODE( 0 ) ) == 1 );
+
+  /* a code pushed again before it is read is only counted */
+  systime = 7;
+  err_push( TEST_CODE( 0 ) );
+  systime = 9;
+  err_push( TEST_CODE( 0 ) );
+  err_push( TEST_CODE( 1 ) );
+  HARNESS_CHECK( err_head - err_tail == 2 );
+  HARNESS_CHECK( count( TEST_CODE( 0 ) ) == 3 );
+  for( i = 0; i < ERR_CODES; ++i ) {
+    if( err_counts_get()->codes[ i ].code == TEST_CODE( 0 ) )
+      HARNESS_CHECK( err_counts_get()->codes[ i ].first == 5 &&
+                     err_counts_get()->codes[ i ].last == 9 );
+  }
+  /* and queued again once it has been read */
+  e = err_pop();
+  HARNESS_CHECK( e && err_get_code( e ) == TEST_CODE( 0 ) );
+  err_destroy( e );
+  err_push( TEST_CODE( 0 ) );
+  HARNESS_CHECK( err_head - err_tail == 2 );
+  e = err_pop();
+  HARNESS_CHECK( e && err_get_code( e ) == TEST_CODE( 1 ) );
+  err_destroy( e );
+  e = err_pop();
+  HARNESS_CHECK( e && err_get_code( e ) == TEST_CODE( 0 ) );
+  err_destroy( e );
+
+  /* a full ring drops, oldest first out, and a full table stops counting */
+  err_init();
+  for( i = 0; i < ERR_DEPTH + 5; ++i )
+    err_push( TEST_CODE( i ) );
+  HARNESS_CHECK( err_counts_get()->dropped == 5 );
+  for( i = 0; (e = err_pop()) != 0; ++i ) {
+    HARNESS_CHECK( err_get_code( e ) == TEST_CODE( i ) );
+    err_destroy( e );
+  }
+  HARNESS_CHECK( i == ERR_DEPTH );
+  for( i = ERR_DEPTH + 5; i < ERR_CODES + 3; ++i )
+    err_push( TEST_CODE( i ) );
+  HARNESS_CHECK( err_counts_get()->untracked == 3 );
+
+  /* ns and masked sections per push: 8 codes, drained every 64 pushes */
+  bsp_host_mask_hook( mask );
+  setitimer( ITIMER_REAL, &off, 0 );    /**< no stall alarm, nothing spins */
+
+  err_init();
+  masks = pushes = 0;
+  HARNESS_BENCH( "err_push, ring", PUSHES, new_ns, new_mix() );
+  printf( "  %.2f masked sections per push\n", (double)masks / pushes );
+  HARNESS_CHECK( masks == 0 );
+
+  old_init();
+  masks = pushes = 0;
+  HARNESS_BENCH( "err_push, old masked fifo", PUSHES, old_ns, old_mix() );
+  printf( "  %.2f masked sections per push\n", (double)masks / pushes );
+
+  harness_sink = (uint32_t)(old_ns + new_ns);
+  return harness_done();
+}
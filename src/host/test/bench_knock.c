@@ -0,0 +1,171 @@
+/**
+ * @file   bench_knock.c
+ * @brief  knock intensity from synthetic sensor windows, and the Goertzel
+ *         bin's ns per window
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ * Each window is noise on a mid scale offset, plus a tone. The samples go
+ * in the ADC_Q3_Buf half the DMA would be filling, the DMA's address is
+ * moved past them, and the real Knock_ISR() takes the window. The
+ * background is learned from noise only windows, then put back before
+ * every window under test, so each intensity is one knock against a
+ * quiet engine. The window length is the worst case load: 12 cylinders
+ * at 8000 rpm with 45 degree windows.
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include "../../../o5e/src/Knock.c"  /**< Band_Energy() and the state are static */
+#include "mpc563xm.h"
+#include "periph_host.h"
+#include "harness.h"
+
+#define Q3_DMA_CHAN ( 7 )         /**< eDMA_OPS.c, ADC_Q3_DMA_CHAN        */
+#define FILTER_PAGE ( 4 )         /**< variables.h, Knock_Freq            */
+#define MID         ( 8192 )      /**< A/D counts, sensor bias            */
+#define NOISE       ( 1000 )       /**< +/- A/D counts                     */
+#define WINDOWS     ( 2000 )      /**< per case                           */
+#define PASSES      ( 100000 )
+
+#define KNOCK_FREQ  (*(float *)&Page_Ptr[ FILTER_PAGE ][ 1820 ])
+
+static uint16_t samples;          /**< per window                         */
+
+/* fill the buffer the DMA is on, as it would over a window */
+static void
+  fill( float a, float freq )
+{
+  volatile uint16_t * const x = &ADC_Q3_Buf[ Buf_Cur ][ 0 ];
+  float const w = 2.0f * 3.14159265f * freq / ADC_Q3_RATE;
+  float const phase = (harness_rand() & 0xffff) * (2.0f * 3.14159265f / 65536.0f);
+  uint16_t i;
+
+  for( i = 0; i < samples; ++i )
+    x[ i ] = (uint16_t)(MID + (int32_t)(harness_rand() % (2 * NOISE + 1)) - NOISE +
+                        (int32_t)lrintf( a * sinf( w * i + phase ) ));
+  EDMA.TCD[ Q3_DMA_CHAN ].DADDR = (uint32_t)(uintptr_t)&x[ samples ];
+}
+
+/* the same window again, against background ref */
+static void
+  again( uint32_t ref )
+{
+  EDMA.TCD[ Q3_DMA_CHAN ].DADDR = (uint32_t)(uintptr_t)&ADC_Q3_Buf[ Buf_Cur ][ samples ];
+  Ref_x32[ 0 ] = ref;
+  Knock_ISR();
+}
+
+/* one window through the interrupt */
+static uint16_t
+  window( float a, float freq )
+{
+  fill( a, freq );
+  Knock_ISR();
+  return Knock_Intensity[ 0 ];
+}
+
+/* mean intensity over WINDOWS single knocks against background ref */
+static float
+  mean( uint32_t ref, float a, float freq )
+{
+  uint32_t i, sum = 0;
+
+  for( i = 0; i < WINDOWS; ++i ) {
+    Ref_x32[ 0 ] = ref;
+    sum += window( a, freq );
+  }
+  return (float)sum / WINDOWS;
+}
+
+int
+  main( void )
+{
+  static const struct {
+    const char *name;
+    float a, freq;
+  } cases[] = {
+    { "noise only", 0.0f, 7000.0f },
+    { "7 kHz tone a=200", 200.0f, 7000.0f },
+    { "7 kHz tone a=600", 600.0f, 7000.0f },
+    { "7 kHz tone a=2000", 2000.0f, 7000.0f },
+    { "12 kHz off band a=2000", 2000.0f, 12000.0f },
+    { "3 kHz off band a=2000", 2000.0f, 3000.0f }
+  };
+  float m[ sizeof( cases ) / sizeof( cases[ 0 ] ) ];
+  uint32_t i, ref, e;
+  double ns;
+
+  periph_host_init();
+  if( periph_host_load_cal( HOST_CAL_IMAGE ) )
+    return 2;
+  err_init();
+  init_variables();
+  HARNESS_CHECK( Flash_OK );
+
+  /* one window, cylinder 0, no eTPU: the ISR's bookkeeping is all there */
+  N_Windows = 1;
+  KNOCK_FREQ = 7000.0f;
+  Set_Coeff();
+  HARNESS_CHECK( Coeff > 0 && Coeff < 2 * COEFF_ONE );
+  samples = (uint16_t)(ADC_Q3_RATE * 45.0f / (8000.0f * 6.0f));
+  printf( "%.0f samples/s, %u samples per 45 deg window at 8000 rpm\n",
+          ADC_Q3_RATE, samples );
+  HARNESS_CHECK( samples == 44 );
+
+  /* a steady tone on a bin comes out near amplitude^2 / 4 */
+  samples = ADC_Q3_SIZE;
+  KNOCK_FREQ = ADC_Q3_RATE * 76.0f / ADC_Q3_SIZE;
+  Set_Coeff();
+  fill( 1000.0f, KNOCK_FREQ );
+  e = Band_Energy( (const uint16_t *)&ADC_Q3_Buf[ Buf_Cur ][ 0 ], samples, Coeff );
+  printf( "tone a=1000 on its bin, band energy %u\n", e );
+  HARNESS_CHECK( e > 240000 && e < 260000 );
+
+  /* off: too few samples, or a band past what the rate can see */
+  samples = 44;
+  KNOCK_FREQ = 7000.0f;
+  Set_Coeff();
+  Knock_Intensity[ 0 ] = 0;
+  samples = 7;
+  window( 2000.0f, 7000.0f );
+  HARNESS_CHECK( Knock_Intensity[ 0 ] == 0 && Ref_x32[ 0 ] == 0 );
+  KNOCK_FREQ = 30000.0f;
+  Set_Coeff();
+  HARNESS_CHECK( Coeff == 0 );
+  samples = 44;
+  window( 2000.0f, 7000.0f );
+  HARNESS_CHECK( Knock_Intensity[ 0 ] == 0 && Ref_x32[ 0 ] == 0 );
+  KNOCK_FREQ = 7000.0f;
+  Set_Coeff();
+
+  /* learn the background, a knock doesn't move it much */
+  for( i = 0; i < 500; ++i )
+    window( 0.0f, 7000.0f );
+  ref = Ref_x32[ 0 ];
+  HARNESS_CHECK( ref > 0 );
+  window( 2000.0f, 7000.0f );
+  HARNESS_CHECK( Ref_x32[ 0 ] <= ref + (ref >> REF_SHIFT) + 1 );
+
+  for( i = 0; i < sizeof( cases ) / sizeof( cases[ 0 ] ); ++i ) {
+    m[ i ] = mean( ref, cases[ i ].a, cases[ i ].freq );
+    printf( "  %-24s mean intensity %6.0f\n", cases[ i ].name, m[ i ] );
+  }
+  /* a quiet window reads about 100, in band grows with amplitude, off
+     band tones of the same size stay near the quiet level */
+  HARNESS_CHECK( m[ 0 ] > 50 && m[ 0 ] < 200 );
+  HARNESS_CHECK( m[ 1 ] > m[ 0 ] && m[ 2 ] > 2 * m[ 1 ] && m[ 3 ] > 5 * m[ 2 ] );
+  HARNESS_CHECK( m[ 3 ] < 0xffff );
+  HARNESS_CHECK( m[ 4 ] < 4 * m[ 0 ] && m[ 5 ] < 4 * m[ 0 ] );
+
+  /* ns per window: the bin alone, and the whole interrupt */
+  fill( 600.0f, 7000.0f );
+  HARNESS_BENCH( "Band_Energy, 44 samples", PASSES, ns,
+                 harness_sink += Band_Energy( (const uint16_t *)&ADC_Q3_Buf[ Buf_Cur ][ 0 ], samples, Coeff ) );
+  printf( "  %.1f ns/sample\n", ns / samples );
+  HARNESS_BENCH( "Knock_ISR, 44 samples", PASSES, ns, again( ref ) );
+
+  return harness_done();
+}
@@ -0,0 +1,137 @@
+/**
+ * @file   bench_os_ready.c
+ * @brief  the ready set pick against the old scan of every tcb
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ * N_TASKS tasks are created with random prios in random order, then put
+ * through random waits, ticks, events, suspends, resumes, readies and
+ * kills. After every step os_task_highest_prio_ready_task() has to pick
+ * what the old linear scan picks from the task states.
+ */
+
+#include <stdio.h>
+#include "../../cocoos/os_task.c"   /**< task_list[] is static            */
+#include "bsp_host.h"
+#include "harness.h"
+
+#define STEPS   ( 2000000 )
+#define PASSES  ( 1000000 )
+
+static void
+  task( void )
+{
+}
+
+/* the pick from before the ready set */
+static uint8_t
+  scan( void )
+{
+  uint8_t index, highest_prio_task = NO_TID, highest_prio = 255;
+  os_declare_state();
+
+  os_disable_interrupts();
+  for( index = 0; index != nTasks; ++index ) {
+    if( READY == task_list[ index ].state && task_list[ index ].prio < highest_prio ) {
+      highest_prio = task_list[ index ].prio;
+      highest_prio_task = index;
+    }
+  }
+  os_enable_interrupts();
+  return highest_prio_task;
+}
+
+/* one random scheduler call; waits only start from READY, the way a
+   running task would make them */
+static void
+  step( void )
+{
+  uint32_t const r = harness_rand();
+  uint8_t const tid = (uint8_t)((r >> 8) % nTasks);
+  TaskState_t const state = task_list[ tid ].state;
+
+  switch( r & 7 ) {
+    case 0:
+    case 1:
+      if( state == READY )
+        os_task_wait_time_set( tid, (uint8_t)((r >> 16) & 1), (uint16_t)(1 + (r >> 17) % 40) );
+      break;
+    case 2:
+      if( state == READY )
+        os_task_wait_event( tid, (Evt_t)((r >> 16) % 8), 1, (uint16_t)((r >> 20) % 30) );
+      break;
+    case 3:
+      os_task_signal_event( (Evt_t)((r >> 16) % 8) );
+      break;
+    case 4:
+      os_task_suspend( tid );
+      break;
+    case 5:
+      if( (r >> 16) % 64 == 0 )
+        os_task_kill( tid );
+      else if( (r >> 16) % 8 == 0 )
+        os_task_ready_set( tid );
+      else
+        os_task_resume( tid );
+      break;
+    default:
+      os_task_tick( (uint8_t)((r >> 16) & 1), (uint16_t)(1 + (r >> 17) % 3) );
+      break;
+  }
+}
+
+int
+  main( void )
+{
+  uint8_t prio[ 256 ];
+  uint32_t i, j, picked = 0, ready_bits;
+  uint8_t t;
+  double ns;
+
+  bsp_host_init( 0, 0, 0 );
+
+  /* random distinct prios, shuffled */
+  for( i = 0; i < 256; ++i )
+    prio[ i ] = (uint8_t)i;
+  for( i = 255; i > 0; --i ) {
+    j = harness_rand() % (i + 1);
+    t = prio[ i ]; prio[ i ] = prio[ j ]; prio[ j ] = t;
+  }
+  for( i = 0; i < N_TASKS; ++i )
+    task_create( task, prio[ i ], 0, 0, 0 );
+  HARNESS_CHECK( nTasks == N_TASKS );
+
+  for( i = 0; i < STEPS; ++i ) {
+    step();
+
+    /* the set has exactly the READY tasks, at their rank */
+    ready_bits = 0;
+    for( t = 0; t < nTasks; ++t ) {
+      if( task_list[ t ].state == READY )
+        ready_bits |= RANK_BIT( task_list[ t ].rank );
+    }
+    if( !HARNESS_CHECK( ready_set == ready_bits ) ||
+        !HARNESS_CHECK( os_task_highest_prio_ready_task() == scan() ) ) {
+      printf( "  step %u\n", i );
+      break;
+    }
+    picked += os_task_highest_prio_ready_task() != NO_TID;
+  }
+  printf( "%u steps, a task ready after %u of them\n", i, picked );
+
+  /* about half the tasks ready, the usual mix */
+  for( t = 0; t < nTasks; ++t ) {
+    if( t & 1 )
+      os_task_suspend( t );
+    else
+      os_task_ready_set( t );
+  }
+  HARNESS_BENCH( "os_task_highest_prio_ready_task, old scan", PASSES, ns,
+                 harness_sink += scan() );
+  HARNESS_BENCH( "os_task_highest_prio_ready_task", PASSES, ns,
+                 harness_sink += os_task_highest_prio_ready_task() );
+
+  return harness_done();
+}
@@ -0,0 +1,194 @@
+/**
+ * @file   bench_os_timers.c
+ * @brief  the sorted timer lists against the old per tick countdown
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ * A model of the old os_task.c runs next to the real one: every waiting
+ * task's time counted down on each tick of its clock, as the old
+ * os_task_tick() did. Both get the same random waits, ticks, events,
+ * suspends, resumes, readies and kills. After every step the states and
+ * the time left on each wait have to match.
+ */
+
+#include <stdio.h>
+#include "../../cocoos/os_task.c"   /**< task_list[] is static            */
+#include "bsp_host.h"
+#include "harness.h"
+
+#define STEPS   ( 3000000 )
+#define PASSES  ( 1000000 )
+
+/* the old scheduler's view of each task */
+static TaskState_t ref_state[ N_TASKS ];
+static TaskState_t ref_saved[ N_TASKS ];
+static uint16_t    ref_time[ N_TASKS ];
+static uint8_t     ref_clock[ N_TASKS ];
+static uint8_t     ref_events[ N_TASKS ];   /**< one bit per event waited on */
+
+static void
+  task( void )
+{
+}
+
+/* the old os_task_tick(), on the model */
+static void
+  ref_tick( uint8_t id, uint16_t size )
+{
+  uint8_t t;
+
+  for( t = 0; t != nTasks; ++t ) {
+    if( TIMED_STATE( ref_state[ t ] ) && ref_clock[ t ] == id ) {
+      if( ref_time[ t ] <= size ) {
+        ref_time[ t ] = 0;
+        if( ref_state[ t ] == WAITING_EVENT_TIMEOUT )
+          ref_events[ t ] = 0;
+        ref_state[ t ] = READY;
+      }
+      else
+        ref_time[ t ] -= size;
+    }
+  }
+}
+
+/* one random scheduler call on both; waits only start from READY, the way
+   a running task would make them */
+static void
+  step( void )
+{
+  uint32_t const r = harness_rand();
+  uint8_t const tid = (uint8_t)((r >> 8) % nTasks);
+  uint8_t const id = (uint8_t)((r >> 16) & 1);
+  uint16_t const time = (uint16_t)(1 + (r >> 17) % 40);
+  Evt_t const ev = (Evt_t)((r >> 16) % 8);
+  uint8_t t;
+
+  switch( r & 7 ) {
+    case 0:
+    case 1:
+      if( ref_state[ tid ] == READY ) {
+        os_task_wait_time_set( tid, id, time );
+        ref_state[ tid ] = WAITING_TIME;
+        ref_clock[ tid ] = id;
+        ref_time[ tid ] = time;
+      }
+      break;
+    case 2:
+      if( ref_state[ tid ] == READY ) {
+        os_task_wait_event( tid, ev, 1, (uint16_t)(time & 1 ? time : 0) );
+        ref_events[ tid ] |= 1 << ev;
+        ref_state[ tid ] = time & 1 ? WAITING_EVENT_TIMEOUT : WAITING_EVENT;
+        ref_clock[ tid ] = 0;
+        ref_time[ tid ] = time;
+      }
+      break;
+    case 3:
+      os_task_signal_event( ev );
+      for( t = 0; t != nTasks; ++t ) {
+        if( (ref_state[ t ] == WAITING_EVENT || ref_state[ t ] == WAITING_EVENT_TIMEOUT) &&
+            (ref_events[ t ] & (1 << ev)) ) {
+          ref_events[ t ] = 0;                /**< waitSingleEvent */
+          ref_state[ t ] = READY;
+        }
+      }
+      break;
+    case 4:
+      if( (r >> 16) % 4 == 0 ) {
+        os_task_suspend( tid );
+        if( ref_state[ tid ] != KILLED ) {
+          ref_saved[ tid ] = ref_state[ tid ];
+          ref_state[ tid ] = SUSPENDED;
+        }
+      } else {
+        os_task_resume( tid );
+        if( ref_state[ tid ] == SUSPENDED )
+          ref_state[ tid ] = ref_saved[ tid ];
+      }
+      break;
+    case 5:
+      if( (r >> 16) % 64 == 0 ) {
+        os_task_kill( tid );
+        ref_state[ tid ] = KILLED;
+      } else if( ref_state[ tid ] == KILLED || (r >> 16) % 8 == 0 ) {
+        os_task_ready_set( tid );
+        ref_state[ tid ] = READY;
+      }
+      break;
+    default:
+      os_task_tick( id, (uint16_t)(1 + (r >> 17) % 3) );
+      ref_tick( id, (uint16_t)(1 + (r >> 17) % 3) );
+      break;
+  }
+}
+
+/* states, time left and the next timeout agree with the model */
+static int
+  same( void )
+{
+  uint32_t next[ N_CLOCKS ] = { OS_NO_TIMEOUT, OS_NO_TIMEOUT };
+  uint32_t left;
+  uint8_t t, id;
+
+  for( t = 0; t != nTasks; ++t ) {
+    if( task_list[ t ].state != ref_state[ t ] )
+      return 0;
+    if( TIMED_STATE( ref_state[ t ] ) ) {
+      left = task_list[ t ].deadline - clock_now[ ref_clock[ t ] ];
+      if( left != ref_time[ t ] || task_list[ t ].clockId != ref_clock[ t ] )
+        return 0;
+      if( left < next[ ref_clock[ t ] ] )
+        next[ ref_clock[ t ] ] = left;
+    } else if( ref_state[ t ] == SUSPENDED && TIMED_STATE( ref_saved[ t ] ) ) {
+      if( task_list[ t ].time != ref_time[ t ] )
+        return 0;
+    }
+  }
+  for( id = 0; id != N_CLOCKS; ++id ) {
+    if( os_task_next_timeout( id ) != next[ id ] )
+      return 0;
+  }
+  return 1;
+}
+
+int
+  main( void )
+{
+  uint32_t i, waits = 0;
+  uint8_t t;
+  double ns;
+
+  bsp_host_init( 0, 0, 0 );
+  for( t = 0; t < N_TASKS; ++t ) {
+    task_create( task, t, 0, 0, 0 );
+    ref_state[ t ] = READY;
+  }
+
+  for( i = 0; i < STEPS; ++i ) {
+    step();
+    if( !HARNESS_CHECK( same() ) ) {
+      printf( "  step %u\n", i );
+      break;
+    }
+    for( t = 0; t < N_TASKS; ++t )
+      waits += TIMED_STATE( ref_state[ t ] );
+  }
+  printf( "%u steps, %.1f timed waits on the lists on average\n", i, (double)waits / i );
+
+  /* every task waiting a long time, ticks that release nobody: the old
+     tick looks at every task, the list only at its head */
+  for( t = 0; t < N_TASKS; ++t ) {
+    os_task_ready_set( t );
+    os_task_wait_time_set( t, 0, (uint16_t)(60000 - t) );
+    ref_state[ t ] = WAITING_TIME;
+    ref_clock[ t ] = 0;
+    ref_time[ t ] = (uint16_t)(60000 - t);
+  }
+  HARNESS_BENCH( "os_task_tick, old countdown", PASSES / 100, ns,
+                 ref_tick( 0, 1 ) );
+  HARNESS_BENCH( "os_task_tick", PASSES / 100, ns,
+                 os_task_tick( 0, 1 ) );
+
+  return harness_done();
+}
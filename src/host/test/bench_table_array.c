@@ -0,0 +1,96 @@
+/**
+ * @file   bench_table_array.c
+ * @brief  table_lookup_array() against table_lookup() per sample
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ * A random walk stands in for a datalog. The array lookup has to give
+ * the same floats, bit for bit, as looking up each sample on its own.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "err.h"
+#include "periph_host.h"
+#include "tune_tables.h"
+
+#define SAMPLES  ( 200000 )   /**< per table, and per bench pass          */
+
+static float col[ SAMPLES ];
+static float row[ SAMPLES ];
+static float array[ SAMPLES ];
+static float scalar[ SAMPLES ];
+
+static void
+  walk( const struct table *t )
+{
+  uint32_t i;
+  float x = tune_axis_rand( t->col_axis, t->cols );
+  float y = tune_axis_rand( t->row_axis, t->rows );
+
+  for( i = 0; i < SAMPLES; ++i ) {
+    x = tune_axis_walk( x, t->col_axis, t->cols );
+    y = tune_axis_walk( y, t->row_axis, t->rows );
+    col[ i ] = x;
+    row[ i ] = t->rows > 1 ? y : 0.0f;
+  }
+}
+
+static void
+  lookup_each( const struct table *t )
+{
+  uint32_t i;
+
+  for( i = 0; i < SAMPLES; ++i )
+    scalar[ i ] = table_lookup( col[ i ], row[ i ], t );
+}
+
+int
+  main( void )
+{
+  double array_ns, scalar_ns;
+  uint32_t n, tables = 0;
+
+  periph_host_init();
+  if( periph_host_load_cal( HOST_CAL_IMAGE ) )
+    return 2;
+  err_init();
+  init_variables();
+  HARNESS_CHECK( Flash_OK );
+
+  {
+    const struct tune_table list[] = TUNE_TABLES;
+
+    for( n = 0; n < TUNE_TABLE_COUNT( list ); ++n ) {
+      const struct table * const t = list[ n ].table;
+
+      if( table_check( t ) != CODE_NONE )
+        continue;                         /**< unsorted, see bench_table_hint */
+      walk( t );
+      table_lookup_array( col, row, array, SAMPLES, t );
+      lookup_each( t );
+      if( !HARNESS_CHECK( memcmp( array, scalar, sizeof( array ) ) == 0 ) )
+        printf( "  %s\n", list[ n ].name );
+      ++tables;
+    }
+  }
+  printf( "%u samples each over %u tables\n", SAMPLES, tables );
+
+  /* a 1D table, no row values */
+  walk( CLT_Table );
+  table_lookup_array( col, 0, array, SAMPLES, CLT_Table );
+  lookup_each( CLT_Table );
+  HARNESS_CHECK( memcmp( array, scalar, sizeof( array ) ) == 0 );
+
+  walk( Spark_Advance_Table );
+  HARNESS_BENCH( "Spark_Advance_Table, table_lookup per sample", 1, scalar_ns,
+                 lookup_each( Spark_Advance_Table ) );
+  HARNESS_BENCH( "Spark_Advance_Table, table_lookup_array", 1, array_ns,
+                 table_lookup_array( col, row, array, SAMPLES, Spark_Advance_Table ) );
+  printf( "per sample: %.1f ns each, %.1f ns array\n", scalar_ns / SAMPLES, array_ns / SAMPLES );
+  harness_sink = (uint32_t)(array[ SAMPLES - 1 ] + scalar[ SAMPLES - 1 ]);
+
+  return harness_done();
+}
@@ -0,0 +1,150 @@
+/**
+ * @file   bench_table_group.c
+ * @brief  table_lookup_group() against a lookup per table, per engine
+ *         pass
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ * The group is Get_Speed_Load_Tables()'s: spark advance and injection end
+ * angle through deg*100 fixed point copies, and Inj_Time_Corr in float,
+ * all at RPM x Reference_VE. apart() is the same pass before the group,
+ * one search per table.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "err.h"
+#include "periph_host.h"
+#include "tune_tables.h"
+
+#define POINTS     ( 100000 )
+#define WORST_DEG  ( 0.025 )
+
+static int32_t spark_data[ 32 * 11 ];
+static int32_t inj_end_data[ 32 * 11 ];
+static struct table_q spark = TABLE_Q( spark_data, 1.0f, 10.0f, 100.0f );
+static struct table_q inj_end = TABLE_Q( inj_end_data, 1.0f, 10.0f, 100.0f );
+static struct table_hint inj_time_hint;
+static struct table_group_member member[ 3 ];
+static struct table_group group = { 0, 0, member, 3 };
+
+static float    rpm[ POINTS ];
+static float    load[ POINTS ];
+static uint32_t point;
+static int32_t  x100[ 2 ];
+static float    corr;
+
+/* Get_Speed_Load_Tables() before the group */
+static void
+  apart( float r, float l )
+{
+  x100[ 0 ] = table_lookup_q( (int32_t)(r + 0.5f), (int32_t)(l * 10 + 0.5f), Spark_Advance_Table, &spark );
+  x100[ 1 ] = table_lookup_q( (int32_t)(r + 0.5f), (int32_t)(l * 10 + 0.5f), Inj_End_Angle_Table, &inj_end );
+  corr = table_lookup_hint( r, l, Inj_Time_Corr_Table, &inj_time_hint );
+}
+
+static void
+  together( float r, float l )
+{
+  member[ 0 ].table = Spark_Advance_Table;
+  member[ 0 ].q = &spark;
+  member[ 1 ].table = Inj_End_Angle_Table;
+  member[ 1 ].q = &inj_end;
+  member[ 2 ].table = Inj_Time_Corr_Table;
+  group.col_value = r;
+  group.row_value = l;
+  table_lookup_group( &group );
+  x100[ 0 ] = member[ 0 ].q_result;
+  x100[ 1 ] = member[ 1 ].q_result;
+  corr = member[ 2 ].result;
+}
+
+static void
+  pass_apart( void )
+{
+  point = point + 1 < POINTS ? point + 1 : 0;
+  apart( rpm[ point ], load[ point ] );
+}
+
+static void
+  pass_together( void )
+{
+  point = point + 1 < POINTS ? point + 1 : 0;
+  together( rpm[ point ], load[ point ] );
+}
+
+int
+  main( void )
+{
+  struct table_hint hint;
+  double worst = 0.0, d, apart_ns, group_ns;
+  float x = 3000.0f, y = 80.0f, axis, f;
+  uint32_t i, bad = 0;
+  int32_t q0, q1;
+
+  periph_host_init();
+  if( periph_host_load_cal( HOST_CAL_IMAGE ) )
+    return 2;
+  err_init();
+  init_variables();
+  HARNESS_CHECK( Flash_OK );
+
+  /* how Engine10_Task's RPM and load move, over the whole table and past
+     its ends */
+  for( i = 0; i < POINTS; ++i ) {
+    x = tune_axis_walk( x, Spark_Advance_Table->col_axis, Spark_Advance_Table->cols );
+    y = tune_axis_walk( y, Spark_Advance_Table->row_axis, Spark_Advance_Table->rows );
+    rpm[ i ] = x > 0.0f ? x : 0.0f;
+    load[ i ] = y > 0.0f ? y : 0.0f;
+  }
+
+  /* the example tune's three tables share their axes: the float result is
+     the lookup's to the bit, the fixed point ones are within the copies'
+     rounding of the float tables */
+  memset( &hint, 0, sizeof( hint ) );
+  for( i = 0; i < POINTS; ++i ) {
+    together( rpm[ i ], load[ i ] );
+    bad += corr != table_lookup_hint( rpm[ i ], load[ i ], Inj_Time_Corr_Table, &hint );
+    d = fabs( x100[ 0 ] / 100.0 - table_lookup( rpm[ i ], load[ i ], Spark_Advance_Table ) );
+    worst = d > worst ? d : worst;
+    d = fabs( x100[ 1 ] / 100.0 - table_lookup( rpm[ i ], load[ i ], Inj_End_Angle_Table ) );
+    worst = d > worst ? d : worst;
+  }
+  printf( "%u points, fixed point results worst %.4f deg from float\n", POINTS, worst );
+  HARNESS_CHECK( group.same_axes );
+  HARNESS_CHECK( spark.valid && inj_end.valid );
+  HARNESS_CHECK( bad == 0 );
+  HARNESS_CHECK( worst <= WORST_DEG );
+
+  /* a tuner write that moves one table's axis: the group notices and
+     looks each table up on its own, exactly as apart() does */
+  axis = Inj_Time_Corr_Table->col_axis[ 3 ];
+  ((struct table *)Inj_Time_Corr_Table)->col_axis[ 3 ] = axis + 1.0f;
+  ++Page_Generation;
+  bad = 0;
+  for( i = 0; i < 1000; ++i ) {
+    together( rpm[ i ], load[ i ] );
+    q0 = x100[ 0 ];
+    q1 = x100[ 1 ];
+    f = corr;
+    apart( rpm[ i ], load[ i ] );
+    bad += q0 != x100[ 0 ] || q1 != x100[ 1 ] || f != corr;
+  }
+  HARNESS_CHECK( !group.same_axes );
+  HARNESS_CHECK( bad == 0 );
+  ((struct table *)Inj_Time_Corr_Table)->col_axis[ 3 ] = axis;
+  ++Page_Generation;
+  together( rpm[ 0 ], load[ 0 ] );
+  HARNESS_CHECK( group.same_axes );
+
+  /* per engine pass */
+  HARNESS_BENCH( "Get_Speed_Load_Tables, a lookup per table", POINTS, apart_ns, pass_apart() );
+  HARNESS_BENCH( "Get_Speed_Load_Tables, table_lookup_group", POINTS, group_ns, pass_together() );
+  printf( "  %.1f ns saved per pass\n", apart_ns - group_ns );
+  harness_sink = (uint32_t)(x100[ 0 ] + x100[ 1 ] + corr);
+
+  return harness_done();
+}
@@ -0,0 +1,115 @@
+/**
+ * @file   bench_table_hint.c
+ * @brief  table_lookup_hint() against table_lookup(), every tune table
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "err.h"
+#include "periph_host.h"
+#include "tune_tables.h"
+
+#define POINTS  ( 100000 )    /**< per table                              */
+#define JUMP    ( 64 )        /**< every JUMP'th point lands anywhere     */
+
+static float    col[ POINTS ];
+static float    row[ POINTS ];
+static uint32_t point;
+
+/* a random walk over the table's axes with the odd jump, so the hint
+   sees its own cell, the next one over and a full search */
+static void
+  walk( const struct table *t )
+{
+  uint32_t i;
+  float x = tune_axis_rand( t->col_axis, t->cols );
+  float y = tune_axis_rand( t->row_axis, t->rows );
+
+  for( i = 0; i < POINTS; ++i ) {
+    if( i % JUMP == 0 ) {
+      x = tune_axis_rand( t->col_axis, t->cols );
+      y = tune_axis_rand( t->row_axis, t->rows );
+    } else {
+      x = tune_axis_walk( x, t->col_axis, t->cols );
+      y = tune_axis_walk( y, t->row_axis, t->rows );
+    }
+    col[ i ] = x;
+    row[ i ] = t->rows > 1 ? y : 0.0f;
+  }
+}
+
+static float
+  lookup( const struct table *t )
+{
+  point = point + 1 < POINTS ? point + 1 : 0;
+  return table_lookup( col[ point ], row[ point ], t );
+}
+
+static float
+  lookup_hint( const struct table *t, struct table_hint *hint )
+{
+  point = point + 1 < POINTS ? point + 1 : 0;
+  return table_lookup_hint( col[ point ], row[ point ], t, hint );
+}
+
+int
+  main( void )
+{
+  struct table_hint hint;
+  double ns, worst = 0.0, d;
+  float a, b;
+  uint32_t i, n, points = 0;
+
+  periph_host_init();
+  if( periph_host_load_cal( HOST_CAL_IMAGE ) )
+    return 2;
+  err_init();
+  init_variables();
+  HARNESS_CHECK( Flash_OK );
+
+  {
+    const struct tune_table tables[] = TUNE_TABLES;
+
+    /* the hinted lookup finds the same cell as the search; it multiplies
+       by 1/width where table_lookup() divides, so only rounding differs.
+       An unsorted axis has no one right cell, those tables are skipped */
+    for( n = 0; n < TUNE_TABLE_COUNT( tables ); ++n ) {
+      const struct table * const t = tables[ n ].table;
+
+      if( table_check( t ) != CODE_NONE ) {
+        printf( "  %s skipped, fails table_check()\n", tables[ n ].name );
+        continue;
+      }
+      memset( &hint, 0, sizeof( hint ) );
+      walk( t );
+      for( i = 0; i < POINTS; ++i ) {
+        a = table_lookup_hint( col[ i ], row[ i ], t, &hint );
+        b = table_lookup( col[ i ], row[ i ], t );
+        d = fabs( (double)a - b ) / fmax( 1.0, fabs( b ) );
+        if( d > worst )
+          worst = d;
+        if( !HARNESS_CHECK( d < 1.0e-5 ) ) {
+          printf( "  %s at %g, %g: %g, %g\n", tables[ n ].name, col[ i ], row[ i ], a, b );
+          break;
+        }
+      }
+      points += i;
+    }
+    printf( "%u points, worst relative difference %.2g\n", points, worst );
+  }
+
+  walk( Spark_Advance_Table );
+  memset( &hint, 0, sizeof( hint ) );
+  HARNESS_BENCH( "Spark_Advance_Table, table_lookup", POINTS, ns,
+                 harness_sink += (uint32_t)lookup( Spark_Advance_Table ) );
+  HARNESS_BENCH( "Spark_Advance_Table, table_lookup_hint", POINTS, ns,
+                 harness_sink += (uint32_t)lookup_hint( Spark_Advance_Table, &hint ) );
+
+  return harness_done();
+}
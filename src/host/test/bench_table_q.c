@@ -0,0 +1,116 @@
+/**
+ * @file   bench_table_q.c
+ * @brief  fixed point table copies against the float lookup
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ * The copies are set up the way Engine_OPS.c sets them up: deg*100 from
+ * whole RPM and load*10. Both are compared with the float lookup at the
+ * same RPM and load over 0-9000 RPM and 0-220% load.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "err.h"
+#include "periph_host.h"
+#include "tune_tables.h"
+
+#define RPM_STEP   ( 3 )
+#define LOAD_STEP  ( 3 )      /**< 0.3%                                   */
+#define POINTS     ( 100000 )
+#define WORST_DEG  ( 0.025 )
+
+static int32_t  spark_data[ 32 * 11 ];
+static int32_t  inj_end_data[ 32 * 11 ];
+static int32_t  small_data[ 4 ];
+static int32_t  rpm[ POINTS ];
+static int32_t  load[ POINTS ];
+static uint32_t point;
+
+/* worst difference in degrees between q and the float table */
+static double
+  sweep( const struct table *t, struct table_q *q )
+{
+  double worst = 0.0, d;
+  int32_t r, l;
+
+  for( r = 0; r <= 9000; r += RPM_STEP ) {
+    for( l = 0; l <= 2200; l += LOAD_STEP ) {
+      d = fabs( table_lookup_q( r, l, t, q ) / 100.0 - table_lookup( (float)r, l / 10.0f, t ) );
+      if( d > worst )
+        worst = d;
+    }
+  }
+  return worst;
+}
+
+static int32_t
+  lookup_q( const struct table *t, struct table_q *q )
+{
+  point = point + 1 < POINTS ? point + 1 : 0;
+  return table_lookup_q( rpm[ point ], load[ point ], t, q );
+}
+
+static float
+  lookup_float( const struct table *t, struct table_hint *hint )
+{
+  point = point + 1 < POINTS ? point + 1 : 0;
+  return table_lookup_hint( (float)rpm[ point ], load[ point ] / 10.0f, t, hint );
+}
+
+int
+  main( void )
+{
+  struct table_q spark = TABLE_Q( spark_data, 1.0f, 10.0f, 100.0f );
+  struct table_q inj_end = TABLE_Q( inj_end_data, 1.0f, 10.0f, 100.0f );
+  struct table_q small = TABLE_Q( small_data, 1.0f, 10.0f, 100.0f );
+  struct table_hint hint;
+  double worst, ns;
+  float x = 3000.0f, y = 80.0f;
+  uint32_t i;
+
+  periph_host_init();
+  if( periph_host_load_cal( HOST_CAL_IMAGE ) )
+    return 2;
+  err_init();
+  init_variables();
+  HARNESS_CHECK( Flash_OK );
+
+  worst = sweep( Spark_Advance_Table, &spark );
+  printf( "Spark_Advance_Table, worst difference %.4f deg\n", worst );
+  HARNESS_CHECK( spark.valid );
+  HARNESS_CHECK( worst <= WORST_DEG );
+
+  worst = sweep( Inj_End_Angle_Table, &inj_end );
+  printf( "Inj_End_Angle_Table, worst difference %.4f deg\n", worst );
+  HARNESS_CHECK( inj_end.valid );
+  HARNESS_CHECK( worst <= WORST_DEG );
+
+  /* too big for its copy: falls back to the float lookup, same rounding */
+  HARNESS_CHECK( table_lookup_q( 3000, 800, Spark_Advance_Table, &small ) ==
+                 (int32_t)floorf( table_lookup( 3000.0f, 80.0f, Spark_Advance_Table ) * 100.0f + 0.5f ) );
+  HARNESS_CHECK( !small.valid );
+
+  /* a page change rebuilds the copy */
+  ++Page_Generation;
+  (void)table_lookup_q( 3000, 800, Spark_Advance_Table, &spark );
+  HARNESS_CHECK( spark.generation == Page_Generation );
+
+  /* how Engine10_Task's RPM and load move */
+  for( i = 0; i < POINTS; ++i ) {
+    x = tune_axis_walk( x, Spark_Advance_Table->col_axis, Spark_Advance_Table->cols );
+    y = tune_axis_walk( y, Spark_Advance_Table->row_axis, Spark_Advance_Table->rows );
+    rpm[ i ] = x > 0.0f ? (int32_t)(x + 0.5f) : 0;
+    load[ i ] = y > 0.0f ? (int32_t)(y * 10.0f + 0.5f) : 0;
+  }
+  memset( &hint, 0, sizeof( hint ) );
+  HARNESS_BENCH( "Spark_Advance_Table, table_lookup_hint", POINTS, ns,
+                 harness_sink += (uint32_t)(lookup_float( Spark_Advance_Table, &hint ) * 100.0f) );
+  HARNESS_BENCH( "Spark_Advance_Table, table_lookup_q", POINTS, ns,
+                 harness_sink += (uint32_t)lookup_q( Spark_Advance_Table, &spark ) );
+
+  return harness_done();
+}
@@ -0,0 +1,120 @@
+/**
+ * @file   bench_table_recip.c
+ * @brief  interpolating with 1/cell width against dividing by it
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ * Two hints run the same search on the same points. One keeps the
+ * precomputed 1/width, the other has it cleared after the setup so
+ * axis_locate() divides the way it did before. Even spacing is cleared
+ * in both, so only the ratio differs.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "err.h"
+#include "periph_host.h"
+#include "tune_tables.h"
+
+#define STEPS   ( 8 )         /**< grid points per axis cell              */
+#define POINTS  ( 100000 )
+
+static float    col[ POINTS ];
+static float    row[ POINTS ];
+static uint32_t point;
+
+/* a hint set up for t, then cut back to searching (and dividing) */
+static void
+  hint_init( const struct table *t, struct table_hint *hint, int divide )
+{
+  memset( hint, 0, sizeof( *hint ) );
+  (void)table_lookup_hint( t->col_axis[ 0 ], t->row_axis[ 0 ], t, hint );
+  hint->col.inv_step = hint->row.inv_step = 0;
+  if( divide )
+    hint->col.widths = hint->row.widths = 0;
+}
+
+/* i'th of the grid points along an axis: STEPS per cell plus one past
+   each end */
+static float
+  grid( const float *axis, uint8_t n, uint32_t i )
+{
+  uint32_t const cell = i / STEPS;
+
+  if( i == 0 )
+    return axis[ 0 ] - 1.0f;
+  if( cell >= (uint32_t)(n - 1) )
+    return axis[ n - 1 ] + (float)(i - (uint32_t)(n - 1) * STEPS);
+  return axis[ cell ] + (axis[ cell + 1 ] - axis[ cell ]) * (float)(i % STEPS) / STEPS;
+}
+
+static float
+  lookup( const struct table *t, struct table_hint *hint )
+{
+  point = point + 1 < POINTS ? point + 1 : 0;
+  return table_lookup_hint( col[ point ], row[ point ], t, hint );
+}
+
+int
+  main( void )
+{
+  struct table_hint mul, div;
+  double ns, worst = 0.0, d;
+  float a, b;
+  uint32_t i, j, n, nc, nr, points = 0, tables = 0;
+
+  periph_host_init();
+  if( periph_host_load_cal( HOST_CAL_IMAGE ) )
+    return 2;
+  err_init();
+  init_variables();
+  HARNESS_CHECK( Flash_OK );
+
+  {
+    const struct tune_table list[] = TUNE_TABLES;
+
+    for( n = 0; n < TUNE_TABLE_COUNT( list ); ++n ) {
+      const struct table * const t = list[ n ].table;
+
+      if( table_check( t ) != CODE_NONE )
+        continue;                         /**< unsorted, see bench_table_hint */
+      hint_init( t, &mul, 0 );
+      hint_init( t, &div, 1 );
+      nc = (uint32_t)(t->cols - 1) * STEPS + 2;
+      nr = t->rows > 1 ? (uint32_t)(t->rows - 1) * STEPS + 2 : 1;
+      for( j = 0; j < nr; ++j ) {
+        for( i = 0; i < nc; ++i ) {
+          float const x = grid( t->col_axis, t->cols, i );
+          float const y = t->rows > 1 ? grid( t->row_axis, t->rows, j ) : 0.0f;
+
+          a = table_lookup_hint( x, y, t, &mul );
+          b = table_lookup_hint( x, y, t, &div );
+          d = fabs( (double)a - b ) / fmax( 1.0, fabs( b ) );
+          if( d > worst )
+            worst = d;
+        }
+      }
+      HARNESS_CHECK( worst < 1.0e-5 );
+      points += nc * nr;
+      ++tables;
+    }
+  }
+  printf( "%u points over %u tables, worst relative difference %.2g\n", points, tables, worst );
+
+  /* the engine pass' biggest table, points spread all over it */
+  for( i = 0; i < POINTS; ++i ) {
+    col[ i ] = tune_axis_rand( Spark_Advance_Table->col_axis, Spark_Advance_Table->cols );
+    row[ i ] = tune_axis_rand( Spark_Advance_Table->row_axis, Spark_Advance_Table->rows );
+  }
+  hint_init( Spark_Advance_Table, &mul, 0 );
+  hint_init( Spark_Advance_Table, &div, 1 );
+  HARNESS_BENCH( "Spark_Advance_Table, divide", POINTS, ns,
+                 harness_sink += (uint32_t)lookup( Spark_Advance_Table, &div ) );
+  HARNESS_BENCH( "Spark_Advance_Table, 1/width", POINTS, ns,
+                 harness_sink += (uint32_t)lookup( Spark_Advance_Table, &mul ) );
+
+  return harness_done();
+}
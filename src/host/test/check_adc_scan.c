@@ -0,0 +1,159 @@
+/**
+ * @file   check_adc_scan.c
+ * @brief  ADC_Scan_Read() with ADC_Scan_Done() interrupting it at every
+ *         instruction
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ * The read is single stepped (x86 trap flag) and the SIGTRAP handler stands
+ * in for the Q0 DMA interrupt: on step k it publishes the next scan, for
+ * every k the read takes. Each scan's raw values are its seq plus the
+ * channel, so a copy that mixes two scans shows. Every read has to give one
+ * whole scan, the newest one or the one before if the publish came after
+ * the last seq check, with its own time, and seq and time have to advance.
+ */
+
+#define _GNU_SOURCE                     /**< REG_EFL                        */
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <ucontext.h>
+#include "typedefs.h"
+#include "bsp.h"
+#include "err.h"
+#include "variables.h"
+#include "eQADC_OPS.h"
+#include "periph_host.h"
+#include "harness.h"
+
+#define SCAN_MS     ( 10 )        /**< systime between scans              */
+#define MAX_STEPS   ( 100000 )    /**< a read is far shorter than this    */
+
+static volatile uint32_t steps;       /**< read instructions so far       */
+static volatile uint32_t publish_at;  /**< step to publish on, 0 for none */
+static volatile uint32_t published;   /**< seq of the newest scan         */
+
+/* the Q0 DMA interrupt: the next scan into a DMA half and out */
+static void
+  publish( void )
+{
+  static uint8_t buf;
+  uint8_t ch;
+
+  ++published;
+  for( ch = 0; ch < ADC_Q0_SIZE; ++ch )
+    ADC_Q0_Buf[ buf ][ ch ] = (uint16_t)(published + ch);
+  systime = published * SCAN_MS;
+  ADC_Scan_Done( buf );
+  buf ^= 1;
+}
+
+#if defined( __x86_64__ )
+
+#define TF  ( 0x100 )             /**< EFLAGS trap flag                   */
+
+static void
+  step( int sig, siginfo_t *info, void *context )
+{
+  ucontext_t * const uc = context;
+
+  (void)sig;
+  (void)info;
+  if( ++steps == publish_at )
+    publish();
+  if( steps >= MAX_STEPS )                /**< runaway, stop stepping     */
+    uc->uc_mcontext.gregs[ REG_EFL ] &= ~TF;
+}
+
+/* ADC_Scan_Read() one instruction at a time, returns the steps it took */
+static uint32_t
+  stepped_read( struct adc_scan *scan, uint8_t *newer )
+{
+  steps = 0;
+  __asm__ volatile( "pushf; orq %0, (%%rsp); popf" : : "i"( TF ) : "memory", "cc" );
+  *newer = ADC_Scan_Read( scan );
+  __asm__ volatile( "pushf; andq %0, (%%rsp); popf" : : "i"( ~TF ) : "memory", "cc" );
+  return steps;
+}
+
+/* one scan's raw values, all from the scan its seq says */
+static int
+  whole( const struct adc_scan *scan )
+{
+  uint8_t ch;
+
+  for( ch = 0; ch < ADC_Q0_SIZE; ++ch )
+    if( scan->raw[ ch ] != (uint16_t)(scan->seq + ch) )
+      return 0;
+  return scan->time == scan->seq * SCAN_MS;
+}
+
+int
+  main( void )
+{
+  static struct adc_scan scan;
+  struct sigaction sa;
+  uint32_t k, n, plain, retried = 0, newest = 0, prev;
+  uint8_t newer;
+
+  periph_host_init();
+  if( periph_host_load_cal( HOST_CAL_IMAGE ) )
+    return 2;
+  err_init();
+  init_variables();
+
+  memset( &sa, 0, sizeof( sa ) );
+  sa.sa_sigaction = step;
+  sa.sa_flags = SA_SIGINFO;
+  sigaction( SIGTRAP, &sa, 0 );
+
+  publish();
+  publish_at = 0;
+  plain = stepped_read( &scan, &newer );
+  HARNESS_CHECK( newer && scan.seq == published && whole( &scan ) );
+  HARNESS_CHECK( plain > 0 && plain < MAX_STEPS );
+  printf( "a read is %u instructions\n", plain );
+
+  /* a publish on every step of the read, and a little past it */
+  for( k = 1; k <= plain + 2; ++k ) {
+    prev = scan.seq;
+    publish_at = k;
+    n = stepped_read( &scan, &newer );
+    if( !HARNESS_CHECK( whole( &scan ) ) ) {
+      printf( "  publish on step %u: seq %u torn\n", k, scan.seq );
+      break;
+    }
+    HARNESS_CHECK( scan.seq == published || (k > 1 && scan.seq == published - 1) );
+    HARNESS_CHECK( newer == (scan.seq != prev) );
+    HARNESS_CHECK( scan.seq >= prev && scan.time >= prev * SCAN_MS );
+    if( k <= plain )
+      HARNESS_CHECK( steps >= k );        /**< the publish was inside the read */
+    retried += n > plain;
+    newest += scan.seq == published;
+  }
+  printf( "%u reads with a publish inside, %u read again, %u got the newest scan\n",
+          plain, retried, newest );
+  HARNESS_CHECK( retried > 0 );
+
+  /* and a read after all that catches up */
+  publish_at = 0;
+  prev = scan.seq;
+  (void)stepped_read( &scan, &newer );
+  HARNESS_CHECK( scan.seq == published && whole( &scan ) && newer == (prev != published) );
+
+  return harness_done();
+}
+
+#else
+
+int
+  main( void )
+{
+  printf( "no single step on this host, skipped\n" );
+  return harness_done();
+}
+
+#endif
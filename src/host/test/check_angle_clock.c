@@ -0,0 +1,116 @@
+/**
+ * @file   check_angle_clock.c
+ * @brief  Degree_Clock and the os angle clock from the window interrupt,
+ *         and Angle_Clock_Restart()
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ * System_Init() brings up the tune's eTPU set, then TCR2 is moved by
+ * random steps up to half a cycle, across the end of the cycle too, and the real
+ * Angle_Clock_ISR is taken through its INTC vector after each. Degree_Clock
+ * has to be the whole degrees since the last restart, at most one behind
+ * (the reciprocal can round an exact multiple down, the next interrupt
+ * picks it up), never ahead, and the os angle clock has to move with it.
+ * A restart at any angle counts from that angle, and a calibration write
+ * that leaves the wheel alone doesn't disturb the count.
+ */
+
+#include <stdio.h>
+#include "config.h"
+#include "mpc563xm.h"
+#include "cocoos.h"
+#include "variables.h"
+#include "err.h"
+#include "etpu_util.h"
+#include "etpu_struct.h"
+#include "etpu_crank_auto.h"
+#include "eTPU_OPS.h"
+#include "main.h"
+#include "Angle_Clock.h"
+#include "bsp_host.h"
+#include "periph_host.h"
+#include "harness.h"
+
+#define ANGLE_VECTOR  ( 68 + ANGLE_CLOCK_CHANNEL )   /**< eTPU A channel */
+#define STEPS         ( 200000 )
+#define RESTARTS      ( 1000 )
+
+void System_Init( void );
+
+static uint32_t cycle;            /**< TCR2 ticks per 720 degrees         */
+static uint32_t tpd;              /**< TCR2 ticks per degree              */
+static uint32_t tcr2;
+
+/* TCR2 on by 'ticks', then the window interrupt */
+static void
+  window( uint32_t ticks )
+{
+  tcr2 = (tcr2 + ticks) % cycle;
+  eTPU->TB2R_A.R = tcr2;
+  eTPU->CHAN[ ANGLE_CLOCK_CHANNEL ].SCR.B.CIS = 1;
+  bsp_host_vector( ANGLE_VECTOR );
+}
+
+int
+  main( void )
+{
+  uint64_t ticks;                 /**< since the last restart             */
+  uint32_t i, n, step, os_deg, behind = 0;
+
+  periph_host_init();
+  if( periph_host_load_cal( HOST_CAL_IMAGE ) )
+    return 2;
+  bsp_host_init( 0, 0, 0 );
+  bsp_host_mask_hook( periph_host_etpu_service );
+  err_init();
+  System_Init();
+  HARNESS_CHECK( Flash_OK );
+  fs_etpu_set_global_24( FS_ETPU_ENG_POS_SYNC_STATUS_GLOBAL_OFFSET, FS_ETPU_ENG_POS_FULL_SYNC );
+
+  cycle = (uint32_t)Ticks_Per_Tooth * Total_Teeth * 2;
+  tpd = (uint32_t)Ticks_Per_Tooth * (N_Teeth + Missing_Teeth) / 360;
+  printf( "%u ticks per cycle, %u per degree\n", cycle, tpd );
+  HARNESS_CHECK( tpd * 720 == cycle );
+
+  for( n = 0; n < RESTARTS; ++n ) {
+    /* restart anywhere, part way into a degree too */
+    tcr2 = harness_rand() % cycle;
+    eTPU->TB2R_A.R = tcr2;
+    Angle_Clock_Restart();
+    HARNESS_CHECK( Degree_Clock == 0 );
+    ticks = 0;
+    os_deg = os_task_clock_get( 1 );
+
+    for( i = 0; i < STEPS / RESTARTS; ++i ) {
+      /* mostly a window's worth, sometimes a few ticks or up to half a cycle
+         (a gap near a whole cycle can't be told from a short one) */
+      switch( harness_rand() & 7 ) {
+        case 0:  step = harness_rand() % (tpd * 2);      break;
+        case 1:  step = harness_rand() % (cycle / 2);    break;
+        default: step = cycle / ANGLE_CLOCK_WINDOWS + harness_rand() % tpd;
+      }
+      window( step );
+      ticks += step;
+
+      if( !HARNESS_CHECK( Degree_Clock == ticks / tpd || Degree_Clock + 1 == ticks / tpd ) ) {
+        printf( "  restart %u step %u: Degree_Clock %u, %llu whole degrees\n",
+                n, i, Degree_Clock, (unsigned long long)(ticks / tpd) );
+        break;
+      }
+      behind += Degree_Clock != ticks / tpd;
+
+      /* the os angle clock moved the same degrees */
+      if( !HARNESS_CHECK( os_task_clock_get( 1 ) - os_deg == Degree_Clock ) )
+        break;
+
+      /* a tuner write to some other page now and then */
+      if( (i & 63) == 0 )
+        Page_Changed( 3 );
+    }
+  }
+  printf( "%u windows, %u a degree behind\n", STEPS, behind );
+
+  return harness_done();
+}
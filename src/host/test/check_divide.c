@@ -0,0 +1,41 @@
+/**
+ * @file   check_divide.c
+ * @brief  main.c's divide by constant for the post start counters against
+ *         real division
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ * Angle_Clock_Task turns ms into s and degrees into cycles with a multiply
+ * and a shift, x/1000 == (x * 274877907) >> 38 and x/720 ==
+ * ((x >> 4) * 95443718) >> 32. Both have to equal the division for every
+ * 32 bit x, not just the ones the counters reach before they stop at 10000.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include "harness.h"
+
+/* as main.c has them */
+#define MS_TO_S( x )         ( (uint32_t)(((uint64_t)(x) * 274877907) >> 38) )
+#define DEG_TO_CYCLES( x )   ( (uint32_t)((((uint64_t)((x) >> 4)) * 95443718) >> 32) )
+
+int
+  main( void )
+{
+  uint32_t x = 0, ms_bad = 0, deg_bad = 0;
+
+  do {
+    if( MS_TO_S( x ) != x / 1000 && ms_bad++ == 0 )
+      printf( "  %u / 1000: %u, not %u\n", x, MS_TO_S( x ), x / 1000 );
+    if( DEG_TO_CYCLES( x ) != x / 720 && deg_bad++ == 0 )
+      printf( "  %u / 720: %u, not %u\n", x, DEG_TO_CYCLES( x ), x / 720 );
+  } while( ++x != 0 );
+
+  printf( "every 32 bit x: %u wrong / 1000, %u wrong / 720\n", ms_bad, deg_bad );
+  HARNESS_CHECK( ms_bad == 0 );
+  HARNESS_CHECK( deg_bad == 0 );
+
+  return harness_done();
+}
@@ -0,0 +1,119 @@
+/**
+ * @file   check_os_idle.c
+ * @brief  src/os_idle.c's tickless sleep on virtual time: no ms ticks lost
+ *         or gained across long one-shot sleeps
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ * The firmware's os_idle() is built in here as idle(), in place of the
+ * host bsp's jump to the next interrupt. Its wait loop reads the timebase,
+ * and each read here costs IDLE_SPIN clocks, so virtual time moves while
+ * it spins and the one-shot decrementer comes due. Tasks wait 7 ms, 250 ms
+ * and 3000 ms (longer than one sleep) on the ms clock and 360 degrees on
+ * the angle clock, which ends sleeps early. After every idle() systime has
+ * to be the timebase's ms, and every ms clock task has to wake on the ms
+ * it asked for, with far fewer decrementer interrupts than ms.
+ */
+
+#include <stdio.h>
+#include "cocoos.h"
+#include "bsp.h"
+#include "bsp_host.h"
+#include "harness.h"
+
+#define IDLE_SPIN   ( 40 )        /**< clocks per timebase read in idle() */
+#define ISR_CLOCKS  ( 200 )
+#define RUN_MS      ( 60000 )
+#define RPM         ( 1234.0f )   /**< not a multiple of anything         */
+
+/* os_idle.c reads the timebase through this */
+static uint32_t
+  spin_timebase( void )
+{
+  bsp_host_spend( IDLE_SPIN );
+  return bsp_get_timebase_lower();
+}
+
+#define os_idle                 idle
+#define bsp_get_timebase_lower  spin_timebase
+#include "../../os_idle.c"
+#undef  os_idle
+#undef  bsp_get_timebase_lower
+
+static const struct
+{
+  uint8_t clock;
+  uint16_t wait;
+} waits[] = { { 1, 360 }, { 0, 7 }, { 0, 250 }, { 0, 3000 } };
+
+#define TASKS  ( sizeof( waits ) / sizeof( waits[ 0 ] ) )
+
+static uint32_t decr_ticks;
+
+static void
+  count_tick( void )
+{
+  ++decr_ticks;
+}
+
+static void
+  task( void )
+{
+}
+
+/* ms of virtual time so far */
+static uint32_t
+  timebase_ms( void )
+{
+  return (uint32_t)(bsp_get_timebase() / BSP_DECR_PERIOD);
+}
+
+int
+  main( void )
+{
+  uint32_t due[ TASKS ] = { 0 }, runs[ TASKS ] = { 0 }, idles = 0, late = 0;
+  uint8_t t;
+
+  bsp_host_init( 0, ISR_CLOCKS, 0 );
+  bsp_host_tick_hook( count_tick );
+  bsp_host_angle_init( 1, 0 );
+  bsp_host_set_rpm( RPM );
+  for( t = 0; t < TASKS; ++t )
+    task_create( task, t, 0, 0, 0 );
+
+  /* every task starts ready and waits again each time it runs */
+  while( systime < RUN_MS ) {
+    t = os_task_highest_prio_ready_task();
+    if( t == NO_TID ) {
+      idle();
+      bsp_host_spend( 1 );                /**< a tick due right on the return */
+      ++idles;
+      if( !HARNESS_CHECK( systime == timebase_ms() ) ) {
+        printf( "  systime %u, timebase %u ms\n", systime, timebase_ms() );
+        break;
+      }
+      continue;
+    }
+    if( waits[ t ].clock == 0 && systime != due[ t ] ) {
+      ++late;
+      printf( "  task %u ran at %u ms, due at %u\n", t, systime, due[ t ] );
+    }
+    ++runs[ t ];
+    due[ t ] = systime + waits[ t ].wait;
+    os_task_wait_time_set( t, waits[ t ].clock, waits[ t ].wait );
+  }
+
+  printf( "%u ms in %u sleeps, %u decrementer interrupts\n", systime, idles, decr_ticks );
+  for( t = 0; t < TASKS; ++t )
+    printf( "  waits %u %s: %u runs\n", waits[ t ].wait, waits[ t ].clock ? "deg" : "ms", runs[ t ] );
+
+  HARNESS_CHECK( late == 0 );
+  HARNESS_CHECK( runs[ 1 ] == RUN_MS / 7 + 1 && runs[ 2 ] == RUN_MS / 250 + (RUN_MS % 250 != 0) );
+  HARNESS_CHECK( runs[ 3 ] == RUN_MS / 3000 );
+  HARNESS_CHECK( runs[ 0 ] > 0 );
+  HARNESS_CHECK( decr_ticks < RUN_MS / 4 );
+
+  return harness_done();
+}
@@ -0,0 +1,131 @@
+/**
+ * @file   check_os_stats.c
+ * @brief  task slice stats on virtual time, where every run time is known
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ * Three tasks spend a set number of core clocks per slice through
+ * bsp_host_spend(), so the stats os_task_run() keeps can be checked
+ * exactly: run min/max/mean and histogram, the release latency a low prio
+ * slice causes, and the overruns and response time of a fixed rate task
+ * that sometimes runs past its period.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "cocoos.h"
+#include "bsp.h"
+#include "bsp_host.h"
+#include "harness.h"
+
+#define RUN_MS      ( 1000 )
+#define MS          ( BSP_DECR_PERIOD )   /**< core clocks                */
+#define HI_RUN      ( 20000 )
+#define MID_SHORT   ( 1000 )
+#define MID_LONG    ( 60000 )
+#define PER_RUN     ( 2000 )
+#define PER_LONG    ( 6 * MS )            /**< past the 5 ms period       */
+#define PER_EVERY   ( 10 )                /**< every 10th job runs long   */
+
+static uint8_t  hi_tid, mid_tid, per_tid;
+static uint32_t per_jobs;
+
+static void
+  hi_task( void )
+{
+  task_open();
+  for( ;; ) {
+    bsp_host_spend( HI_RUN );
+    task_wait( 4 );
+  }
+  task_close();
+}
+
+static void
+  mid_task( void )
+{
+  static uint32_t n;
+
+  task_open();
+  for( ;; ) {
+    bsp_host_spend( ++n & 1 ? MID_SHORT : MID_LONG );
+    task_wait( 2 );
+  }
+  task_close();
+}
+
+static void
+  per_task( void )
+{
+  task_open();
+  for( ;; ) {
+    bsp_host_spend( ++per_jobs % PER_EVERY == 0 ? PER_LONG : PER_RUN );
+    task_period( 5 );
+  }
+  task_close();
+}
+
+static uint8_t
+  bucket( uint32_t run )
+{
+  uint8_t b = 0;
+
+  while( (run >> OS_STATS_HIST_SHIFT) >> b )
+    ++b;
+  return b < OS_STATS_HIST_SIZE ? b : OS_STATS_HIST_SIZE - 1;
+}
+
+static void
+  done( void )
+{
+  const struct os_task_stats * const s = os_task_stats_get();
+  const struct os_task_stats * const hi = &s[ hi_tid ];
+  const struct os_task_stats * const mid = &s[ mid_tid ];
+  const struct os_task_stats * const per = &s[ per_tid ];
+  uint32_t i, sum = 0;
+
+  bsp_host_report();
+
+  /* every slice the same: min, max and the running mean all agree. the
+     waits are relative, so a late start costs hi a run now and then */
+  HARNESS_CHECK( hi->runs > RUN_MS / 5 && hi->runs <= RUN_MS / 4 );
+  HARNESS_CHECK( hi->run_min == HI_RUN && hi->run_max == HI_RUN );
+  HARNESS_CHECK( hi->run_mean > HI_RUN - 32 && hi->run_mean <= HI_RUN );
+  HARNESS_CHECK( hi->run_hist[ bucket( HI_RUN ) ] == hi->runs );
+
+  /* two run times, half the slices in each bucket */
+  HARNESS_CHECK( mid->run_min == MID_SHORT && mid->run_max == MID_LONG );
+  for( i = 0; i < OS_STATS_HIST_SIZE; ++i )
+    sum += mid->run_hist[ i ];
+  HARNESS_CHECK( sum == mid->runs );
+  HARNESS_CHECK( mid->run_hist[ bucket( MID_SHORT ) ] >= mid->runs / 2 );
+  HARNESS_CHECK( mid->run_hist[ bucket( MID_LONG ) ] >= mid->runs / 2 - 1 );
+
+  /* slices aren't preempted: hi waits out at most one long slice of a
+     lower prio task, and a latency is never negative (wrapped) */
+  HARNESS_CHECK( hi->latency_max > 0 && hi->latency_max <= PER_LONG );
+  HARNESS_CHECK( mid->latency_max <= PER_LONG + HI_RUN );
+  HARNESS_CHECK( per->latency_max < 2 * PER_LONG );
+
+  /* each long job that finished missed one release and is the worst
+     response */
+  HARNESS_CHECK( per->overruns == per->runs / PER_EVERY );
+  HARNESS_CHECK( per->response_max >= PER_LONG && per->response_max < PER_LONG + MS );
+  HARNESS_CHECK( hi->overruns == 0 && mid->overruns == 0 );
+
+  exit( harness_done() );
+}
+
+int
+  main( void )
+{
+  bsp_host_init( RUN_MS, 0, done );
+  os_init();
+  hi_tid = task_create( hi_task, 1, 0, 0, 0 );
+  mid_tid = task_create( mid_task, 2, 0, 0, 0 );
+  per_tid = task_create( per_task, 3, 0, 0, 0 );
+  os_start();                   /**< doesn't return, done() exits */
+  return 1;
+}
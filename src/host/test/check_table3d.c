@@ -0,0 +1,125 @@
+/**
+ * @file   check_table3d.c
+ * @brief  table_lookup_3d() on planar tables, which trilinear
+ *         interpolation reproduces exactly
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "err.h"
+#include "periph_host.h"
+#include "tune_tables.h"
+
+#define TABLES  ( 1000 )
+#define POINTS  ( 1000 )      /**< per table                              */
+
+/* RPM x load x CLT like plane, 0 to about 2500 */
+static float
+  plane( float x, float y, float z )
+{
+  return 0.1f * x + 2.0f * y + 5.0f * z + 300.0f;
+}
+
+/* times code has been pushed since err_init() */
+static uint32_t
+  pushed( uint32_t code )
+{
+  const struct err_counts * const c = err_counts_get();
+  uint32_t i;
+
+  for( i = 0; i < ERR_CODES; ++i ) {
+    if( c->codes[ i ].code == code )
+      return c->codes[ i ].count;
+  }
+  return 0;
+}
+
+static float
+  clamp( float v, const float *axis, uint8_t n )
+{
+  return v < axis[ 0 ] ? axis[ 0 ] : v > axis[ n - 1 ] ? axis[ n - 1 ] : v;
+}
+
+/* random size and increasing axes, some evenly spaced, data on the plane */
+static void
+  random_table( struct table3d *t )
+{
+  uint8_t i, j, k;
+
+  memset( t, 0, sizeof( *t ) );
+  t->cols = (uint8_t)(2 + harness_rand() % (MAX_3D_COLS - 1));
+  t->rows = (uint8_t)(1 + harness_rand() % MAX_3D_ROWS);
+  t->layers = (uint8_t)(1 + harness_rand() % MAX_3D_LAYERS);
+  t->col_axis[ 0 ] = (float)(harness_rand() % 1000);
+  t->row_axis[ 0 ] = (float)(harness_rand() % 30);
+  t->layer_axis[ 0 ] = (float)(harness_rand() % 40) - 40.0f;
+  for( i = 1; i < t->cols; ++i )
+    t->col_axis[ i ] = t->col_axis[ i - 1 ] + ((harness_rand() & 1) ? 500.0f : 50.0f + harness_rand() % 1000);
+  for( i = 1; i < t->rows; ++i )
+    t->row_axis[ i ] = t->row_axis[ i - 1 ] + ((harness_rand() & 1) ? 20.0f : 1.0f + harness_rand() % 40);
+  for( i = 1; i < t->layers; ++i )
+    t->layer_axis[ i ] = t->layer_axis[ i - 1 ] + 10.0f + harness_rand() % 40;
+  for( k = 0; k < t->layers; ++k )
+    for( j = 0; j < t->rows; ++j )
+      for( i = 0; i < t->cols; ++i )
+        t->data[ (k * t->rows + j) * t->cols + i ] = plane( t->col_axis[ i ], t->row_axis[ j ], t->layer_axis[ k ] );
+}
+
+int
+  main( void )
+{
+  static struct table3d t;
+  struct table3d_hint hint;
+  double worst = 0.0, d;
+  uint32_t i, n, before;
+  float x, y, z, v;
+
+  periph_host_init();
+  if( periph_host_load_cal( HOST_CAL_IMAGE ) )
+    return 2;
+  err_init();
+  init_variables();
+
+  for( n = 0; n < TABLES; ++n ) {
+    random_table( &t );
+    HARNESS_CHECK( table3d_check( &t ) == CODE_NONE );
+    memset( &hint, 0, sizeof( hint ) );
+    for( i = 0; i < POINTS; ++i ) {
+      x = tune_axis_rand( t.col_axis, t.cols );
+      y = tune_axis_rand( t.row_axis, t.rows );
+      z = tune_axis_rand( t.layer_axis, t.layers );
+      if( i % 8 == 0 )                    /**< right on a layer */
+        z = t.layer_axis[ harness_rand() % t.layers ];
+      v = plane( clamp( x, t.col_axis, t.cols ), clamp( y, t.row_axis, t.rows ),
+                 clamp( z, t.layer_axis, t.layers ) );
+      d = fabs( (double)table_lookup_3d( x, y, z, &t, &hint ) - v );
+      if( d > worst )
+        worst = d;
+    }
+  }
+  printf( "%u points, worst error %.2g\n", TABLES * POINTS, worst );
+  HARNESS_CHECK( worst < 1.0e-3 );
+
+  /* a bad size gives 255 and is logged, like the 2D lookups */
+  random_table( &t );
+  t.layers = MAX_3D_LAYERS + 1;
+  HARNESS_CHECK( table3d_check( &t ) == CODE_OLDJUNK_FC );
+  before = pushed( CODE_OLDJUNK_FC );
+  memset( &hint, 0, sizeof( hint ) );
+  HARNESS_CHECK( table_lookup_3d( 1.0f, 1.0f, 1.0f, &t, &hint ) == 255.0f );
+  HARNESS_CHECK( !hint.valid );
+  HARNESS_CHECK( pushed( CODE_OLDJUNK_FC ) == before + 1 );
+  t.layers = 2;
+  t.layer_axis[ 1 ] = t.layer_axis[ 0 ] - 1.0f;
+  HARNESS_CHECK( table3d_check( &t ) == CODE_OLDJUNK_FA );
+  t.layers = 0;
+  HARNESS_CHECK( table3d_check( &t ) == CODE_OLDJUNK_FC );
+
+  return harness_done();
+}
@@ -0,0 +1,143 @@
+/**
+ * @file   check_table_check.c
+ * @brief  table checks on a page change, bad sizes caught by the lookups
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ * The size and axis checks run once per page change now, so a table
+ * broken by a tuner write has to be caught some other way: the lookups
+ * still give 255 and push CODE_OLDJUNK_FC for it, same as the old
+ * per lookup check did.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "err.h"
+#include "periph_host.h"
+#include "tune_tables.h"
+
+#define PASSES  ( 100000 )
+#define SPARK_PAGE  ( 7 )     /**< variables.h, Spark_Advance_Table       */
+#define LAMBDA_PAGE ( 8 )     /**< variables.h, Lambda_Set_Point_Table    */
+
+/* times code has been pushed since err_init() */
+static uint32_t
+  pushed( uint32_t code )
+{
+  const struct err_counts * const c = err_counts_get();
+  uint32_t i;
+
+  for( i = 0; i < ERR_CODES; ++i ) {
+    if( c->codes[ i ].code == code )
+      return c->codes[ i ].count;
+  }
+  return 0;
+}
+
+/* a table made up here, 4 x 3 with sorted axes */
+static void
+  small_table( struct table *t )
+{
+  uint8_t i;
+
+  memset( t, 0, sizeof( *t ) );
+  t->cols = 4;
+  t->rows = 3;
+  for( i = 0; i < t->cols; ++i )
+    t->col_axis[ i ] = 1000.0f * i;
+  for( i = 0; i < t->rows; ++i )
+    t->row_axis[ i ] = 50.0f * i;
+  for( i = 0; i < t->cols * t->rows; ++i )
+    t->data[ i ] = (float)i;
+}
+
+int
+  main( void )
+{
+  static struct table t;
+  struct table_hint hint;
+  struct table *spark;
+  float x[ 3 ] = { 500.0f, 1500.0f, 2500.0f };
+  float y[ 3 ] = { 25.0f, 75.0f, 100.0f };
+  float r[ 3 ];
+  uint32_t before, generation;
+  uint8_t cols;
+  double ns;
+
+  periph_host_init();
+  if( periph_host_load_cal( HOST_CAL_IMAGE ) )
+    return 2;
+  err_init();
+  init_variables();
+  HARNESS_CHECK( Flash_OK );
+  spark = (struct table *)Spark_Advance_Table;
+
+  /* what table_check() finds */
+  small_table( &t );
+  HARNESS_CHECK( table_check( &t ) == CODE_NONE );
+  HARNESS_CHECK( table_lookup( 1500.0f, 75.0f, &t ) == 5.5f + 0.5f * 4.0f );
+  t.cols = 0;
+  HARNESS_CHECK( table_check( &t ) == CODE_OLDJUNK_FC );
+  t.cols = MAX_COLS + 1;
+  HARNESS_CHECK( table_check( &t ) == CODE_OLDJUNK_FC );
+  small_table( &t );
+  t.rows = 0;
+  HARNESS_CHECK( table_check( &t ) == CODE_OLDJUNK_FC );
+  small_table( &t );
+  t.col_axis[ 2 ] = 500.0f;
+  HARNESS_CHECK( table_check( &t ) == CODE_OLDJUNK_FB );
+  small_table( &t );
+  t.row_axis[ 2 ] = 10.0f;
+  HARNESS_CHECK( table_check( &t ) == CODE_OLDJUNK_FA );
+  HARNESS_CHECK( table_check( 0 ) == CODE_OLDJUNK_FC );
+
+  /* every lookup gives 255 and logs a bad size */
+  small_table( &t );
+  t.cols = 200;
+  before = pushed( CODE_OLDJUNK_FC );
+  memset( &hint, 0, sizeof( hint ) );
+  HARNESS_CHECK( table_lookup( 1500.0f, 75.0f, &t ) == 255.0f );
+  HARNESS_CHECK( table_lookup_hint( 1500.0f, 75.0f, &t, &hint ) == 255.0f );
+  table_lookup_array( x, y, r, 3, &t );
+  HARNESS_CHECK( r[ 0 ] == 255.0f && r[ 1 ] == 255.0f && r[ 2 ] == 255.0f );
+  HARNESS_CHECK( pushed( CODE_OLDJUNK_FC ) == before + 3 );
+
+  /* a tuner write that breaks a tune table: the hint is redone on the
+     new Page_Generation, the page goes invalid, and putting it right
+     brings both back */
+  memset( &hint, 0, sizeof( hint ) );
+  HARNESS_CHECK( table_lookup_hint( 3000.0f, 80.0f, spark, &hint ) != 255.0f );
+  cols = spark->cols;
+  spark->cols = MAX_COLS + 1;
+  generation = Page_Generation;
+  before = pushed( CODE_OLDJUNK_FC );
+  Page_Changed( SPARK_PAGE );
+  HARNESS_CHECK( Page_Generation != generation );
+  HARNESS_CHECK( !Page_Valid[ SPARK_PAGE ] );
+  HARNESS_CHECK( table_lookup_hint( 3000.0f, 80.0f, spark, &hint ) == 255.0f );
+  HARNESS_CHECK( pushed( CODE_OLDJUNK_FC ) == before + 2 );   /**< page check + lookup */
+  spark->cols = cols;
+  Page_Changed( SPARK_PAGE );
+  HARNESS_CHECK( Page_Valid[ SPARK_PAGE ] );
+  HARNESS_CHECK( table_lookup_hint( 3000.0f, 80.0f, spark, &hint ) == table_lookup( 3000.0f, 80.0f, spark ) );
+
+  /* the example tune's unsorted Lambda_Set_Point axis is logged once at
+     boot, not again on every write to its page, and doesn't block it */
+  HARNESS_CHECK( table_check( Lambda_Set_Point_Table ) == CODE_OLDJUNK_FB );
+  before = pushed( CODE_OLDJUNK_FB );
+  HARNESS_CHECK( before == 1 );
+  Page_Changed( LAMBDA_PAGE );
+  Page_Changed( LAMBDA_PAGE );
+  HARNESS_CHECK( pushed( CODE_OLDJUNK_FB ) == before );
+  HARNESS_CHECK( Page_Valid[ LAMBDA_PAGE ] );
+
+  /* what moved out of every lookup */
+  HARNESS_BENCH( "table_check(Spark_Advance_Table)", PASSES, ns,
+                 harness_sink += table_check( Spark_Advance_Table ) );
+  HARNESS_BENCH( "table_lookup_hint(Spark_Advance_Table)", PASSES, ns,
+                 harness_sink += (uint32_t)table_lookup_hint( 3000.0f, 80.0f, spark, &hint ) );
+
+  return harness_done();
+}
@@ -0,0 +1,295 @@
+/**
+ * @file   check_table_locate.c
+ * @brief  table_locate() + table_interp() against the lookups and the
+ *         lookup before it was split
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ * baseline() is the table_lookup() from before the split, less its
+ * PARANOIA checks. On random tables with strictly increasing axes the
+ * lookup gives the same floats it did, except a 1D lookup below the first
+ * axis value, which now clamps where it used to extrapolate.
+ *
+ * Axes with a repeated value (a step in the table) are checked apart: a
+ * point on the repeat lands in the cell of the last copy whichever way it
+ * is found, so the binary search, the hint and table_lookup_array() agree.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "err.h"
+#include "periph_host.h"
+#include "tune_tables.h"
+
+#define TABLES  ( 2000 )
+#define POINTS  ( 500 )       /**< per table                              */
+
+/* the old bsearch(), unchanged */
+static uint8_t
+  old_search( const float value, const float * const array, uint8_t n )
+{
+  uint8_t lower = 0, middle = 0, upper = --n, i;
+
+  for( i = 0; i <= n; i++ ) {
+    middle = (upper + lower) / 2;
+    if( middle == lower )
+      break;
+    if( array[ middle ] < value )
+      lower = middle;
+    else if( array[ middle ] > value )
+      upper = middle;
+    else
+      break;
+  }
+  return middle;
+}
+
+static float
+  old_interpolate( const float fraction, const float value1, const float value2 )
+{
+  if( value1 == value2 || fraction == 0 )
+    return value1;
+  if( value1 < value2 )
+    return value1 + ((value2 - value1) * fraction);
+  return value1 - ((value1 - value2) * fraction);
+}
+
+/* table_lookup() before the split, the branches folded but the same
+   float operations in the same order */
+static float
+  baseline( const float col_value, const float row_value, const struct table * const t )
+{
+  uint8_t const rows = t->rows, cols = t->cols;
+  uint8_t col_index, row_index;
+  const float *ptr;
+  float ratio, value3, value4;
+  int row_interp, col_interp;
+
+  if( row_value <= t->row_axis[ 0 ] )
+    row_index = 0;
+  else if( row_value >= t->row_axis[ rows - 1 ] )
+    row_index = rows - 1;
+  else
+    row_index = old_search( row_value, t->row_axis, rows );
+
+  if( col_value <= t->col_axis[ 0 ] )
+    col_index = 0;
+  else if( col_value >= t->col_axis[ cols - 1 ] )
+    col_index = cols - 1;
+  else
+    col_index = old_search( col_value, t->col_axis, cols );
+
+  if( rows == 1 ) {
+    ptr = t->data + col_index;
+    if( col_value == t->col_axis[ col_index ] || col_index == cols - 1 )
+      return ptr[ 0 ];
+    ratio = (col_value - t->col_axis[ col_index ]) / (t->col_axis[ col_index + 1 ] - t->col_axis[ col_index ]);
+    return old_interpolate( ratio, ptr[ 0 ], ptr[ 1 ] );
+  }
+
+  ptr = t->data + (cols * row_index) + col_index;
+  row_interp = !(row_index >= rows - 1 || (row_value <= t->row_axis[ row_index ] && row_index == 0));
+  col_interp = !(col_index >= cols - 1 || (col_value <= t->col_axis[ col_index ] && col_index == 0));
+
+  if( !row_interp ) {
+    if( !col_interp )
+      return ptr[ 0 ];
+    ratio = (col_value - t->col_axis[ col_index ]) / (t->col_axis[ col_index + 1 ] - t->col_axis[ col_index ]);
+    return old_interpolate( ratio, ptr[ 0 ], ptr[ 1 ] );
+  }
+  ratio = (row_value - t->row_axis[ row_index ]) / (t->row_axis[ row_index + 1 ] - t->row_axis[ row_index ]);
+  value3 = old_interpolate( ratio, ptr[ 0 ], ptr[ cols ] );
+  if( !col_interp )
+    return value3;
+  value4 = old_interpolate( ratio, ptr[ 1 ], ptr[ cols + 1 ] );
+  ratio = (col_value - t->col_axis[ col_index ]) / (t->col_axis[ col_index + 1 ] - t->col_axis[ col_index ]);
+  return old_interpolate( ratio, value3, value4 );
+}
+
+/* random size, strictly increasing axes (some evenly spaced), random data */
+static void
+  random_table( struct table *t )
+{
+  uint8_t i;
+  uint16_t n;
+
+  memset( t, 0, sizeof( *t ) );
+  t->cols = (uint8_t)(2 + harness_rand() % (MAX_COLS - 1));
+  t->rows = (harness_rand() & 3) == 0 ? 1 : (uint8_t)(2 + harness_rand() % (MAX_ROWS - 1));
+  t->col_axis[ 0 ] = (float)(harness_rand() % 1000) - 500.0f;
+  t->row_axis[ 0 ] = (float)(harness_rand() % 100);
+  for( i = 1; i < t->cols; ++i )
+    t->col_axis[ i ] = t->col_axis[ i - 1 ] + ((harness_rand() & 1) ? 250.0f : 1.0f + harness_rand() % 1000);
+  for( i = 1; i < t->rows; ++i )
+    t->row_axis[ i ] = t->row_axis[ i - 1 ] + ((harness_rand() & 1) ? 10.0f : 0.5f + harness_rand() % 40);
+  for( n = 0; n < t->cols * t->rows; ++n )
+    t->data[ n ] = (float)(harness_rand() % 20000) / 100.0f - 50.0f;
+}
+
+/* random_table() with a value repeated two or three times somewhere inside
+   each axis, copy k is the first */
+static void
+  repeat_table( struct table *t, uint8_t *col_k, uint8_t *row_k )
+{
+  uint8_t i, copies;
+
+  do
+    random_table( t );
+  while( t->cols < 4 );
+  copies = (uint8_t)(2 + (harness_rand() & 1));
+  if( t->cols < 3 + copies )
+    copies = 2;
+  *col_k = (uint8_t)(1 + harness_rand() % (t->cols - 1 - copies));
+  for( i = 1; i < copies; ++i )
+    t->col_axis[ *col_k + i ] = t->col_axis[ *col_k ];
+
+  *row_k = 0;
+  if( t->rows >= 4 ) {
+    *row_k = (uint8_t)(1 + harness_rand() % (t->rows - 3));
+    t->row_axis[ *row_k + 1 ] = t->row_axis[ *row_k ];
+  }
+}
+
+/* the cell holding value, axis[ i ] <= value < axis[ i + 1 ], the last
+   one past the end of the axis */
+static uint8_t
+  cell( const float value, const float *axis, uint8_t n )
+{
+  uint8_t i;
+
+  if( n == 1 || value <= axis[ 0 ] )
+    return 0;
+  for( i = 0; i < n - 1 && axis[ i + 1 ] <= value; ++i )
+    ;
+  return i;
+}
+
+/* the last copy of axis[ k ] */
+static uint8_t
+  last_copy( const float *axis, uint8_t k )
+{
+  while( axis[ k + 1 ] == axis[ k ] )
+    ++k;
+  return k;
+}
+
+int
+  main( void )
+{
+  static struct table t;
+  struct table_hint hint, locate_hint;
+  struct table_pos pos;
+  uint32_t i, n, same = 0, clamped = 0;
+  float x, y, a, b;
+
+  periph_host_init();
+  if( periph_host_load_cal( HOST_CAL_IMAGE ) )
+    return 2;
+  err_init();
+  init_variables();
+  HARNESS_CHECK( Flash_OK );
+
+  for( n = 0; n < TABLES; ++n ) {
+    random_table( &t );
+    memset( &hint, 0, sizeof( hint ) );
+    memset( &locate_hint, 0, sizeof( locate_hint ) );
+    for( i = 0; i < POINTS; ++i ) {
+      x = tune_axis_rand( t.col_axis, t.cols );
+      y = t.rows > 1 ? tune_axis_rand( t.row_axis, t.rows ) : 0.0f;
+      if( i % 8 == 0 )                    /**< right on an axis value */
+        x = t.col_axis[ harness_rand() % t.cols ];
+
+      /* the split halves are the hinted lookup */
+      table_locate( x, y, &t, &locate_hint, &pos );
+      a = table_interp( &t, &pos );
+      if( !HARNESS_CHECK( a == table_lookup_hint( x, y, &t, &hint ) ) )
+        break;
+
+      /* and the plain lookup is what it was, but for the 1D clamp */
+      a = table_lookup( x, y, &t );
+      if( t.rows == 1 && x < t.col_axis[ 0 ] ) {
+        if( !HARNESS_CHECK( a == t.data[ 0 ] ) )
+          break;
+        ++clamped;
+        continue;
+      }
+      b = baseline( x, y, &t );
+      if( !HARNESS_CHECK( a == b ) ) {
+        printf( "  %ux%u table at %g, %g: %g, was %g\n", t.cols, t.rows, x, y, a, b );
+        break;
+      }
+      ++same;
+    }
+  }
+  printf( "%u points as before, %u 1D points clamped below the axis\n", same, clamped );
+
+  /* repeated axis values */
+  {
+    static float xs[ POINTS ], ys[ POINTS ], array[ POINTS ];
+    uint8_t col_k, row_k, col_last, row_last;
+    uint32_t on_step = 0;
+
+    for( n = 0; n < TABLES; ++n ) {
+      repeat_table( &t, &col_k, &row_k );
+      HARNESS_CHECK( table_check( &t ) == CODE_NONE );
+      col_last = last_copy( t.col_axis, col_k );
+      row_last = row_k ? last_copy( t.row_axis, row_k ) : 0;
+      memset( &hint, 0, sizeof( hint ) );
+      for( i = 0; i < POINTS; ++i ) {
+        xs[ i ] = (i & 1) ? t.col_axis[ col_k ] : tune_axis_rand( t.col_axis, t.cols );
+        ys[ i ] = t.rows == 1 ? 0.0f : (i & 2) && row_k ? t.row_axis[ row_k ] : t.row_axis[ 0 ];
+      }
+      table_lookup_array( xs, t.rows > 1 ? ys : 0, array, POINTS, &t );
+      for( i = 0; i < POINTS; ++i ) {
+        /* the binary search and the array divide the same way, so the same cell is the same float */
+        a = table_lookup( xs[ i ], ys[ i ], &t );
+        if( !HARNESS_CHECK( a == array[ i ] ) ) {
+          printf( "  %ux%u table at %g, %g: %g, array %g\n", t.cols, t.rows, xs[ i ], ys[ i ], a, array[ i ] );
+          break;
+        }
+        /* the hint starts from wherever the last point was, and only the cell has to match */
+        table_locate( xs[ i ], ys[ i ], &t, &hint, &pos );
+        if( !HARNESS_CHECK( pos.col_index == cell( xs[ i ], t.col_axis, t.cols ) &&
+                            pos.row_index == cell( ys[ i ], t.row_axis, t.rows ) ) ) {
+          printf( "  %ux%u table at %g, %g: cell %u,%u\n", t.cols, t.rows, xs[ i ], ys[ i ], pos.col_index, pos.row_index );
+          break;
+        }
+        if( xs[ i ] != t.col_axis[ col_k ] )
+          continue;
+        b = t.data[ (ys[ i ] == t.row_axis[ row_k ] && row_k ? t.cols * row_last : 0) + col_last ];
+        if( !HARNESS_CHECK( a == b && table_interp( &t, &pos ) == b ) ) {
+          printf( "  %ux%u table on the step at %g, %g: %g, last copy %g\n", t.cols, t.rows, xs[ i ], ys[ i ], a, b );
+          break;
+        }
+        ++on_step;
+      }
+    }
+    printf( "%u points on a repeated axis value\n", on_step );
+  }
+
+  /* the tune's own tables, at the same points */
+  {
+    const struct tune_table tables[] = TUNE_TABLES;
+
+    for( n = 0; n < TUNE_TABLE_COUNT( tables ); ++n ) {
+      const struct table * const tt = tables[ n ].table;
+
+      if( table_check( tt ) != CODE_NONE )
+        continue;                         /**< unsorted, see bench_table_hint */
+      for( i = 0; i < POINTS; ++i ) {
+        x = tune_axis_rand( tt->col_axis, tt->cols );
+        y = tt->rows > 1 ? tune_axis_rand( tt->row_axis, tt->rows ) : 0.0f;
+        if( tt->rows == 1 && x < tt->col_axis[ 0 ] )
+          continue;
+        if( !HARNESS_CHECK( table_lookup( x, y, tt ) == baseline( x, y, tt ) ) ) {
+          printf( "  %s at %g, %g\n", tables[ n ].name, x, y );
+          break;
+        }
+      }
+    }
+  }
+
+  return harness_done();
+}
@@ -0,0 +1,122 @@
+/**
+ * @file   check_table_lut.c
+ * @brief  table_lookup_lut() against table_lookup() at every A/D count,
+ *         and the rebuild on a page change
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ * Every one of the 16384 counts goes through each sensor table of the
+ * example tune the way Get_Fast_Op_Vars() and Get_Slow_Op_Vars() read
+ * them (all the dividers are 1). The count indexed copy has to give the
+ * float lookup's value to within LUT_TOLERANCE of the table's range, float
+ * rounding; the segments with a table point inside go to the float lookup.
+ * A tuner write is not seen until Page_Changed(), then the copy follows
+ * the new table.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "err.h"
+#include "periph_host.h"
+#include "tune_tables.h"
+
+#define AD_VOLTS      ( 5.0f / 16384.0f )   /**< Variable_OPS.c         */
+#define LUT_TOLERANCE ( 1.0e-5f ) /**< of the table's data range          */
+#define CLT_PAGE      ( 3 )       /**< variables.h, CLT_Table             */
+
+/* worst |lut - float| over every count, as a fraction of the data range */
+static float
+  sweep( const struct table *t, struct table_lut *lut )
+{
+  float lo = t->data[ 0 ], hi = t->data[ 0 ], worst = 0.0f, d;
+  uint32_t count;
+  uint8_t i;
+
+  for( i = 1; i < t->cols; ++i ) {
+    lo = t->data[ i ] < lo ? t->data[ i ] : lo;
+    hi = t->data[ i ] > hi ? t->data[ i ] : hi;
+  }
+  for( count = 0; count < TABLE_LUT_COUNTS; ++count ) {
+    d = fabsf( table_lookup_lut( (uint16_t)count, t, lut ) - table_lookup( count * AD_VOLTS, 0, t ) );
+    if( d > worst )
+      worst = d;
+  }
+  return hi > lo ? worst / (hi - lo) : worst;
+}
+
+int
+  main( void )
+{
+  static struct table_lut lut[] = {
+    TABLE_LUT( AD_VOLTS ), TABLE_LUT( AD_VOLTS ), TABLE_LUT( AD_VOLTS ),
+    TABLE_LUT( AD_VOLTS ), TABLE_LUT( AD_VOLTS ), TABLE_LUT( AD_VOLTS ),
+    TABLE_LUT( AD_VOLTS ), TABLE_LUT( AD_VOLTS ) };
+  static struct table old;
+  static float before[ TABLE_LUT_COUNTS ];
+  struct table *clt;
+  uint32_t n, count, stale = 0, moved = 0;
+  uint8_t i;
+  float worst;
+
+  periph_host_init();
+  if( periph_host_load_cal( HOST_CAL_IMAGE ) )
+    return 2;
+  err_init();
+  init_variables();
+  HARNESS_CHECK( Flash_OK );
+
+  {
+    const struct tune_table sensors[] = {
+      TUNE_TABLE( CLT_Table ), TUNE_TABLE( IAT_Table ), TUNE_TABLE( TPS_Table ),
+      TUNE_TABLE( MAP_1_Table ), TUNE_TABLE( MAP_2_Table ), TUNE_TABLE( MAF_1_Table ),
+      TUNE_TABLE( Lambda_1_Table ), TUNE_TABLE( Lambda_2_Table ) };
+
+    for( n = 0; n < TUNE_TABLE_COUNT( sensors ); ++n ) {
+      worst = sweep( sensors[ n ].table, &lut[ n ] );
+      printf( "%-16s %2u points, %s, worst %.1e of range\n", sensors[ n ].name,
+              sensors[ n ].table->cols, lut[ n ].valid ? "lut" : "float", worst );
+      HARNESS_CHECK( lut[ n ].valid );
+      if( !HARNESS_CHECK( worst <= LUT_TOLERANCE ) )
+        printf( "  %s is off by more than %g of its range\n", sensors[ n ].name, LUT_TOLERANCE );
+    }
+  }
+
+  /* a tuner write to CLT_Table: the data upside down and the axis squeezed
+     into the bottom half of the counts */
+  clt = (struct table *)CLT_Table;
+  old = *clt;
+  for( count = 0; count < TABLE_LUT_COUNTS; ++count )
+    before[ count ] = table_lookup_lut( (uint16_t)count, clt, &lut[ 0 ] );
+  for( i = 0; i < clt->cols; ++i ) {
+    clt->data[ i ] = old.data[ clt->cols - 1 - i ];
+    clt->col_axis[ i ] = old.col_axis[ i ] * 0.5f;
+  }
+
+  /* not seen until the page is changed, outside the knee segments that go
+     to the table itself */
+  for( count = 0; count < TABLE_LUT_COUNTS; ++count )
+    stale += table_lookup_lut( (uint16_t)count, clt, &lut[ 0 ] ) != before[ count ] &&
+             !(lut[ 0 ].knee[ count >> (TABLE_LUT_SHIFT + 5) ] & (1ul << ((count >> TABLE_LUT_SHIFT) & 31)));
+  HARNESS_CHECK( stale == 0 );
+
+  /* then the copy is rebuilt and follows the new table */
+  Page_Changed( CLT_PAGE );
+  HARNESS_CHECK( Page_Valid[ CLT_PAGE ] );
+  worst = sweep( clt, &lut[ 0 ] );
+  HARNESS_CHECK( lut[ 0 ].generation == Page_Generation );
+  HARNESS_CHECK( worst <= LUT_TOLERANCE );
+  for( count = 0; count < TABLE_LUT_COUNTS; ++count )
+    moved += table_lookup_lut( (uint16_t)count, clt, &lut[ 0 ] ) != before[ count ];
+  HARNESS_CHECK( moved > TABLE_LUT_COUNTS / 2 );
+  printf( "CLT_Table rewritten, worst %.1e of range after Page_Changed()\n", worst );
+
+  /* and back */
+  *clt = old;
+  Page_Changed( CLT_PAGE );
+  HARNESS_CHECK( sweep( clt, &lut[ 0 ] ) <= LUT_TOLERANCE );
+
+  return harness_done();
+}
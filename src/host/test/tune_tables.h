@@ -0,0 +1,90 @@
+/**
+ * @file   tune_tables.h
+ * @brief  every 2D/1D table of the tune, for the table lookup checks
+ * @attention  { not for use in safety critical systems       }
+ * @attention  { not for use in pollution controlled vehicles }
+ *
+ * (c) Copyright 2026, Open5xxxECU - www.Open5xxxECU.org
+ *
+ */
+
+#ifndef   __tune_tables_h
+#define   __tune_tables_h
+
+#include <stdint.h>
+#include "Table_Lookup.h"
+#include "variables.h"
+#include "harness.h"
+
+/**
+ * Same list as Check_Page_Tables(). The tables live where Page_Ptr[]
+ * points, so declare the list inside a function once init_variables()
+ * has run:
+ *
+ *   const struct tune_table tables[] = TUNE_TABLES;
+ */
+
+struct tune_table
+{
+  const char *name;
+  const struct table *table;
+};
+
+#define TUNE_TABLE( t_ )  { #t_, t_ }
+
+#define TUNE_TABLES {                                                        \
+  TUNE_TABLE( sqrt_Table ), TUNE_TABLE( Prime_Corr_Table ),                  \
+  TUNE_TABLE( Prime_Decay_Table ), TUNE_TABLE( Man_Crank_Corr_Table ),       \
+  TUNE_TABLE( Fuel_Temp_Corr_Table ), TUNE_TABLE( IAT_Fuel_Corr_Table ),     \
+  TUNE_TABLE( Dwell_Table ), TUNE_TABLE( Inj_Dead_Time_Table ),              \
+  TUNE_TABLE( MAP_Angle_Table ), TUNE_TABLE( Accel_Limit_Table ),            \
+  TUNE_TABLE( Accel_Decay_Table ), TUNE_TABLE( Accel_Sensativity_Table ),    \
+  TUNE_TABLE( Decel_Limit_Table ), TUNE_TABLE( Decel_Decay_Table ),          \
+  TUNE_TABLE( Decel_Sensativity_Table ), TUNE_TABLE( TPS_Flow_Table ),       \
+  TUNE_TABLE( CLT_Table ), TUNE_TABLE( IAT_Table ), TUNE_TABLE( TPS_Table ), \
+  TUNE_TABLE( Lambda_1_Table ), TUNE_TABLE( Lambda_2_Table ),                \
+  TUNE_TABLE( MAF_1_Table ), TUNE_TABLE( MAF_2_Table ),                      \
+  TUNE_TABLE( MAP_1_Table ), TUNE_TABLE( MAP_2_Table ),                      \
+  TUNE_TABLE( Inj_Time_Corr_Table ), TUNE_TABLE( Inj_End_Angle_Table ),      \
+  TUNE_TABLE( Spark_Advance_Table ), TUNE_TABLE( Lambda_Set_Point_Table ),   \
+  TUNE_TABLE( Cyl_Trim_1_Table ), TUNE_TABLE( Cyl_Trim_2_Table ),            \
+  TUNE_TABLE( Cyl_Trim_3_Table ), TUNE_TABLE( Cyl_Trim_4_Table ),            \
+  TUNE_TABLE( Cyl_Trim_5_Table ), TUNE_TABLE( Cyl_Trim_6_Table ),            \
+  TUNE_TABLE( Cyl_Trim_7_Table ), TUNE_TABLE( Cyl_Trim_8_Table ),            \
+  TUNE_TABLE( Coil_Trim_1_Table ), TUNE_TABLE( Coil_Trim_2_Table ),          \
+  TUNE_TABLE( Coil_Trim_3_Table ), TUNE_TABLE( Coil_Trim_4_Table ) }
+
+#define TUNE_TABLE_COUNT( list_ )  ( sizeof( list_ ) / sizeof( (list_)[ 0 ] ) )
+
+/**
+ * @brief a random point on an axis, from 10% below the first value to
+ *        10% above the last so the clamps get hit too
+ */
+static inline float
+  tune_axis_rand( const float *axis, uint8_t n )
+{
+  float const lo = axis[ 0 ];
+  float const span = n > 1 ? axis[ n - 1 ] - lo : 1.0f;
+
+  return lo - span * 0.1f + span * 1.2f * (float)(harness_rand() & 0xffff) / 65535.0f;
+}
+
+/**
+ * @brief the next point of a random walk along an axis, about 1/200 of
+ *        the span per step and bounced off the ends, the way RPM and load
+ *        move between passes
+ */
+static inline float
+  tune_axis_walk( float x, const float *axis, uint8_t n )
+{
+  float const lo = axis[ 0 ];
+  float const span = n > 1 ? axis[ n - 1 ] - lo : 1.0f;
+  float const step = span * ((float)(harness_rand() & 0xff) - 127.5f) / 12750.0f;
+
+  x += step;
+  if( x < lo - span * 0.1f || x > lo + span * 1.1f )
+    x -= 2.0f * step;
+  return x;
+}
+
+#endif // __tune_tables_h
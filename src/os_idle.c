@@ -12,43 +12,95 @@
 
 #include "cocoos.h"
 #include "config.h"
-#include "main.h"
-#include "etpu_util.h"
-#include "mpc5500_ccdcfg.h"
+#include "bsp.h"
 
-#define ANGLE_TICKS_PER_DEGREE 10
+#define IDLE_MAX_MS   1000  /**< longest single sleep                     */
 
 /* --| TYPES    |--------------------------------------------------------- */
 /* --| STATICS  |--------------------------------------------------------- */
 /* --| INLINES  |--------------------------------------------------------- */
 /* --| INTERNAL |--------------------------------------------------------- */
 
-void 
-  os_idle( void )
+/* lower timebase at the start of systime tick 'ms', the timebase and   */
+/* systime both start from 0 in bsp_decr_init()                          */
+static uint32_t
+  tick_start( uint32_t ms )
 {
+  return ms * BSP_DECR_PERIOD;
+}
+
+/* account for every tick boundary the timebase has passed but systime  */
+/* hasn't - the decrementer ticks skipped while asleep, or lost while   */
+/* interrupts were masked. call with interrupts masked                  */
+static void
+  catch_up( uint32_t now )
+{
+  int32_t  behind;
+  uint32_t n;
+
+  behind = (int32_t)(now - tick_start(systime));
+  if( behind < (int32_t)BSP_DECR_PERIOD )
+    return;
 
-  /* eventually this gets gutted and we get proper updates via tpu */
-  /* interrupt. for now, we keep it until I figure out a way to    */
-  /* fix once and for all correctly                                */
-  /*                                                               */
-  /* ideally, I just put the core to sleep until the next int      */
-  /* rolls in                                                      */
-
-  static uint32_t prev_angle = 0;
-  prev_angle = angle_clock(); // previous crank position in ticks
-  //update crank shaft degree/angle clock (free running, not synced to an absolute engine position)
-  register uint32_t i;
-  register uint64_t j;
-
-  i = (angle_clock() - prev_angle) & 0xffffff;    // 24 bit hw counter 
-  j = i * (((uint64_t)1 << 32) / ANGLE_TICKS_PER_DEGREE);        // avoid a run time divide
-  i = (uint32_t) (j >> 32);                       // convert back to bin 0
-  if (i > 0) {                                    // delta full degrees
-    Degree_Clock += i;                          //< polled/used in Engine_OPS.c 
-    prev_angle = (prev_angle + i * ANGLE_TICKS_PER_DEGREE) & 0xffffff;
-    os_task_tick(1, (uint16_t) i);              // increment os angle clock value
-  } // if
+  n = (uint32_t)behind / BSP_DECR_PERIOD;
+  systime += n;
+  while( n > 0xffff ) {
+    os_task_tick( 0, 0xffff );
+    n -= 0xffff;
+  }
+  os_task_tick( 0, (uint16_t)n );
 }
+
 /* --| PUBLIC   |--------------------------------------------------------- */
 
-uint32_t Degree_Clock = 0;
+/**
+ * @brief called by the scheduler when no task is ready
+ * @details Tickless idle: skips the 1ms ticks up to the next time deadline
+ *          by loading the decrementer for that one wakeup, waits, then
+ *          brings systime and the ms clock up to date from the timebase
+ *          and puts the decrementer back on the 1ms grid. Angle deadlines
+ *          need no estimate, the angle clock interrupt readies those tasks
+ *          and any interrupt that readies a task ends the wait early.
+ */
+void
+  os_idle( void )
+{
+  uint32_t ms;
+  uint32_t wake;
+
+  os_declare_state();
+  os_disable_interrupts();
+
+  if( os_task_highest_prio_ready_task() != NO_TID ) {
+    os_enable_interrupts();   /**< an interrupt got in first               */
+    return;
+  }
+
+  /* earliest deadline on the ms clock */
+  ms = os_task_next_timeout( 0 );
+  if( ms > IDLE_MAX_MS )
+    ms = IDLE_MAX_MS;
+  if( ms < 1 )
+    ms = 1;
+
+  /* one decrementer interrupt at the deadline instead of one per ms */
+  wake = tick_start( systime + ms );
+  bsp_decr_set( wake - bsp_get_timebase_lower() );
+
+  os_enable_interrupts();
+
+  /* the timebase and ready set are core register and cached RAM reads, */
+  /* so this leaves the bus to the eTPU and DMA                         */
+  while( os_task_highest_prio_ready_task() == NO_TID
+      && (int32_t)(bsp_get_timebase_lower() - wake) < 0 )
+    ;
+
+  os_disable_interrupts();
+  catch_up( bsp_get_timebase_lower() );
+  bsp_decr_ack();             /**< catch_up() counted it                   */
+  wake = tick_start( systime + 1 ) - bsp_get_timebase_lower();
+  if( (int32_t)wake <= 0 )
+    wake = 1;                 /**< boundary just went by, tick right away  */
+  bsp_decr_set( wake );
+  os_enable_interrupts();
+}
@@ -0,0 +1,162 @@
+#!/usr/bin/env python
+"""
+Flash calibration block from a TunerStudio tune.
+
+    python tools/msq_image.py o5e/Tuner/o5e.ini <tune>.msq <out>.bin [--little]
+                              [--set name=value ...]
+
+Lays the constants of every page out the way a burn leaves them in BLK1B:
+the 'ABCD' header, then page n at BLOCK_HEADER_SIZE + n * MAX_PAGE_SIZE
+(variables.h). Offsets, types, scale and translate come from the ini
+[Constants] section, values from the .msq. Values are stored big endian
+like the target; --little writes them in x86 order for the host build,
+which reads the page image straight into Page_Ptr[] (src/host). --set
+replaces a constant's value from the tune, written as the .msq has it.
+"""
+
+import re
+import struct
+import sys
+import xml.etree.ElementTree as ET
+
+BLOCK_HEADER_SIZE = 1024        # variables.h
+MAX_PAGE_SIZE = 2048
+NPAGES = 13
+BURN_COUNT = 1
+
+TYPES = {'U08': 'B', 'S08': 'b', 'U16': 'H', 'S16': 'h',
+         'U32': 'I', 'S32': 'i', 'F32': 'f'}
+
+# name = class, type, offset, ...
+CONSTANT = re.compile(r'^\s*(\w+)\s*=\s*(scalar|array|bits)\s*,\s*(\w+)\s*,\s*(\d+)\s*,(.*)$')
+PAGE = re.compile(r'^\s*page\s*=\s*(\d+)')
+SHAPE = re.compile(r'^\s*\[\s*(\d+)(?:\s*x\s*(\d+))?\s*\]')
+BITS = re.compile(r'^\s*\[\s*(\d+)\s*:\s*(\d+)\s*\]')
+
+
+def fields(rest):
+    """split the rest of a constant line on commas outside quotes, up to
+    the ; comment"""
+    out, cur, quoted = [], '', False
+    for c in rest:
+        if c == '"':
+            quoted = not quoted
+        if c == ';' and not quoted:
+            break
+        if c == ',' and not quoted:
+            out.append(cur.strip())
+            cur = ''
+        else:
+            cur += c
+    out.append(cur.strip())
+    return out
+
+
+def parse_ini(path):
+    """returns {name: constant} and [page size] from the [Constants] section"""
+    constants = {}
+    sizes = []
+    section = None
+    page = None
+
+    for line in open(path, encoding='latin-1'):
+        s = line.strip()
+        if s.startswith('['):
+            section = s
+            continue
+        if section != '[Constants]':
+            continue
+        if s.startswith('pageSize'):
+            sizes = [int(v) for v in s.split('=', 1)[1].split(';')[0].split(',')]
+            continue
+        m = PAGE.match(line)
+        if m:
+            page = int(m.group(1)) - 1          # ini counts pages from 1
+            continue
+        m = CONSTANT.match(line)
+        if not m or page is None:
+            continue
+        name, cls, typ, offset, rest = m.groups()
+        rest = fields(rest)
+        c = {'page': page, 'class': cls, 'type': typ, 'offset': int(offset)}
+        if cls == 'bits':
+            lo, hi = BITS.match(rest[0]).groups()
+            c['bits'] = (int(lo), int(hi))
+            c['options'] = [o.strip().strip('"') for o in rest[1:]]
+        else:
+            if cls == 'array':
+                x, y = SHAPE.match(rest[0]).groups()
+                c['count'] = int(x) * (int(y) if y else 1)
+                rest = rest[1:]
+            else:
+                c['count'] = 1
+            c['scale'] = float(rest[1].split()[0])
+            c['translate'] = float(rest[2].split()[0])     # Test_TPS lacks a comma after it
+        constants[name] = c
+    return constants, sizes
+
+
+def parse_msq(path):
+    """returns {(page, name): text}"""
+    values = {}
+    for page in ET.parse(path).getroot():
+        if not page.tag.endswith('page') or page.get('number') is None:
+            continue
+        for c in page:
+            if c.tag.endswith('constant'):
+                values[(int(page.get('number')), c.get('name'))] = c.text or ''
+    return values
+
+
+def store(image, base, c, text, endian):
+    if c['class'] == 'bits':
+        text = text.strip().strip('"')
+        index = c['options'].index(text) if text in c['options'] else int(float(text))
+        lo, hi = c['bits']
+        mask = ((1 << (hi - lo + 1)) - 1) << lo
+        image[base + c['offset']] = (image[base + c['offset']] & ~mask) | ((index << lo) & mask)
+        return
+
+    fmt = endian + TYPES[c['type']]
+    size = struct.calcsize(fmt)
+    values = [float(v) for v in text.split()][:c['count']]
+    for i, v in enumerate(values):
+        raw = v / c['scale'] - c['translate']
+        if fmt[-1] != 'f':
+            raw = int(round(raw))
+            if fmt[-1].isupper():
+                raw &= (1 << (8 * size)) - 1
+        struct.pack_into(fmt, image, base + c['offset'] + i * size, raw)
+
+
+def main(argv):
+    if len(argv) < 4:
+        sys.exit(__doc__)
+    endian = '<' if '--little' in argv else '>'
+    constants, sizes = parse_ini(argv[1])
+    values = parse_msq(argv[2])
+    for i, arg in enumerate(argv):
+        if arg == '--set':
+            name, text = argv[i + 1].split('=', 1)
+            values[(constants[name]['page'], name)] = text
+
+    image = bytearray(b'\xff' * (BLOCK_HEADER_SIZE + NPAGES * MAX_PAGE_SIZE))
+    image[0:5] = b'ABCD' + bytes([BURN_COUNT])
+    for page, size in enumerate(sizes):
+        base = BLOCK_HEADER_SIZE + page * MAX_PAGE_SIZE
+        image[base:base + size] = bytes(size)
+
+    missing = 0
+    for name, c in constants.items():
+        text = values.get((c['page'], name))
+        if text is None:
+            missing += 1
+            continue
+        store(image, BLOCK_HEADER_SIZE + c['page'] * MAX_PAGE_SIZE, c, text, endian)
+
+    open(argv[3], 'wb').write(image)
+    print('%s: %d constants, %d not in the tune' % (argv[3], len(constants) - missing, missing))
+
+
+if __name__ == '__main__':
+    main(sys.argv)
@@ -0,0 +1,82 @@
+#!/usr/bin/env python
+"""
+Static RAM per module from a CodeWarrior link map.
+
+    python tools/ram_report.py o5e_Data/<target>/<target>.MAP [-n 20]
+
+Turn on "Generate Link Map" in the linker settings to get the .MAP. Prints
+.sdata/.sbss/.data/.bss bytes for each object file, largest first, then the
+biggest single symbols. The same totals are on tuner page 0xf5 at run time
+(bsp_static_ram), along with the stack high water mark.
+"""
+
+import re
+import sys
+from collections import defaultdict
+
+RAM_SECTIONS = ('.sdata', '.sbss', '.data', '.bss')
+
+# <start> <size> <virtual> [<file offset>] <align> <symbol> <object>
+ENTRY = re.compile(r'^\s*[0-9a-fA-F]{8}\s+([0-9a-fA-F]+)\s+[0-9a-fA-F]{8}\s+'
+                   r'(?:[0-9a-fA-F]{8}\s+)?\d+\s+(\S+)\s+(\S+)')
+LAYOUT = re.compile(r'^(\S+)\s+section layout')
+
+
+def parse(path):
+    """returns {object: {section: bytes}} and [(bytes, symbol, object)]"""
+    totals = defaultdict(lambda: defaultdict(int))   # from the section lines
+    sums = defaultdict(lambda: defaultdict(int))     # from the symbol lines
+    symbols = []
+    section = None
+
+    for line in open(path):
+        m = LAYOUT.match(line)
+        if m:
+            section = m.group(1) if m.group(1) in RAM_SECTIONS else None
+            continue
+        if section is None:
+            continue
+        m = ENTRY.match(line)
+        if not m:
+            continue
+        size, name, obj = int(m.group(1), 16), m.group(2), m.group(3)
+        if name == section:
+            totals[obj][section] += size
+        else:
+            sums[obj][section] += size
+            symbols.append((size, name, obj))
+
+    # an object's section line covers its symbols plus padding, use it when there
+    for obj, secs in sums.items():
+        for sec, size in secs.items():
+            if sec not in totals[obj]:
+                totals[obj][sec] = size
+    return totals, symbols
+
+
+def main(argv):
+    if len(argv) < 2:
+        sys.exit(__doc__)
+    top = int(argv[argv.index('-n') + 1]) if '-n' in argv else 20
+    totals, symbols = parse(argv[1])
+    if not totals:
+        sys.exit('no %s section layout found in %s' % ('/'.join(RAM_SECTIONS), argv[1]))
+
+    rows = sorted(totals.items(), key=lambda kv: -sum(kv[1].values()))
+    print('%-28s' % 'module' + ''.join('%8s' % s for s in RAM_SECTIONS) + '%8s' % 'total')
+    grand = defaultdict(int)
+    for obj, secs in rows:
+        for s in RAM_SECTIONS:
+            grand[s] += secs.get(s, 0)
+        print('%-28s' % obj + ''.join('%8d' % secs.get(s, 0) for s in RAM_SECTIONS)
+              + '%8d' % sum(secs.values()))
+    print('%-28s' % 'all' + ''.join('%8d' % grand[s] for s in RAM_SECTIONS)
+          + '%8d' % sum(grand.values()))
+
+    print('\nlargest symbols')
+    for size, name, obj in sorted(symbols, reverse=True)[:top]:
+        print('%8d  %-32s %s' % (size, name, obj))
+
+
+if __name__ == '__main__':
+    main(sys.argv)